@@ -26,10 +26,19 @@
 #include "fs_tensor.h"
 #include "SylvException.h"
 
+// The workers of the thread pool run the code of this MEX file, so they
+// are stopped before it is unloaded
+static void shutdown_threads()
+{
+	THREAD_GROUP::shutdown();
+}
+
 extern "C" {
 	void mexFunction(int nlhs, mxArray* plhs[],
 					 int nhrs, const mxArray* prhs[])
 	{
+		mexAtExit(shutdown_threads);
+
 		if (nhrs < 12 || nlhs != 2)
                   DYN_MEX_FUNC_ERR_MSG_TXT("dynare_simul_ must have at least 12 input parameters and exactly 2 output arguments.\n");
 
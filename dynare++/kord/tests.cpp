@@ -57,6 +57,7 @@ FSSparseTensor* SparseGenerator::makeTensor(int dim, int nv, int r,
 			}
 		}
 	}
+	res->compress();
 	return res;
 }
 
@@ -226,6 +227,10 @@ protected:
 									 int nstat, int npred, int nboth, int forw,
 									 const TwoDMatrix& gy, const TwoDMatrix& gu,
 									 const TwoDMatrix& v);
+	static double korder_threads(int maxdim, int unfold_dim, int nthreads,
+								 int nstat, int npred, int nboth, int forw,
+								 const TwoDMatrix& gy, const TwoDMatrix& gu,
+								 const TwoDMatrix& v);
 };
 
 
@@ -308,6 +313,54 @@ double TestRunnable::korder_unfold_fold(int maxdim, int unfold_dim,
 	return maxerror;
 }
 
+// Runs the steps with max_parallel_threads equal to 1 (the sequential
+// path) and to nthreads (the recovery graph run by the threads), and
+// returns the maximum relative difference of the folded derivatives.
+double TestRunnable::korder_threads(int maxdim, int unfold_dim, int nthreads,
+									int nstat, int npred, int nboth, int nforw,
+									const TwoDMatrix& gy, const TwoDMatrix& gu,
+									const TwoDMatrix& v)
+{
+	TensorContainer<FSSparseTensor> c(1);
+	int ny = nstat+npred+nboth+nforw;
+	int nu = v.nrows();
+	int nz = nboth+nforw+ny+nboth+npred+nu;
+	SparseGenerator::fillContainer(c, maxdim, nz, ny, 5.0);
+	int save_threads = THREAD_GROUP::max_parallel_threads;
+	Journal jr("out.txt");
+	KOrder* kords[2];
+	int threads[2] = {1, nthreads};
+	for (int r = 0; r < 2; r++) {
+		THREAD_GROUP::max_parallel_threads = threads[r];
+		kords[r] = new KOrder(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+		for (int d = 2; d <= unfold_dim; d++)
+			kords[r]->performStep<KOrder::unfold>(d);
+		kords[r]->switchToFolded();
+		for (int d = unfold_dim+1; d <= maxdim; d++)
+			kords[r]->performStep<KOrder::fold>(d);
+	}
+	THREAD_GROUP::max_parallel_threads = save_threads;
+
+	double maxerror = 0.0;
+	const FGSContainer& g1 = kords[0]->getFoldDers();
+	const FGSContainer& g2 = kords[1]->getFoldDers();
+	for (FGSContainer::const_iterator it = g1.begin(); it != g1.end(); ++it) {
+		const Symmetry& sym = (*it).first;
+		FGSTensor diff(*((*it).second));
+		diff.add(-1.0, *(g2.get(sym)));
+		double norm = diff.getData().getMax();
+		double scale = (*it).second->getData().getMax();
+		if (scale > 1.0)
+			norm /= scale;
+		if (maxerror < norm)
+			maxerror = norm;
+	}
+	printf("	max difference of %d threads: %10.6g\n", nthreads, maxerror);
+	delete kords[0];
+	delete kords[1];
+	return maxerror;
+}
+
 class UnfoldKOrderSmall : public TestRunnable {
 public:
 	UnfoldKOrderSmall()
@@ -367,6 +420,24 @@ public:
 		}
 };
 
+class ThreadsKOrderSmall : public TestRunnable {
+public:
+	ThreadsKOrderSmall()
+		: TestRunnable("1 and 4 threads korder (stat=2,pred=3,both=1,forw=2,u=3,dim=4)",
+					   4, 18) {}
+
+	bool run() const
+		{
+			TwoDMatrix gy(8, 4, gy_data);
+			TwoDMatrix gu(8, 3, gu_data);
+			TwoDMatrix v(3, 3, vdata);
+			double err = korder_threads(4, 3, 4, 2, 3, 1, 2,
+										gy, gu, v);
+
+			return err < 1e-10;
+		}
+};
+
 int main()
 {
 	TestRunnable* all_tests[50];
@@ -375,6 +446,7 @@ int main()
 	all_tests[num_tests++] = new UnfoldKOrderSmall();
 	all_tests[num_tests++] = new UnfoldKOrderSW();
 	all_tests[num_tests++] = new UnfoldFoldKOrderSW();
+	all_tests[num_tests++] = new ThreadsKOrderSmall();
 
 	// find maximum dimension and maximum nvar
 	int dmax=0;
@@ -198,8 +198,10 @@ void Dynare::calcDerivatives(const Vector& yy, const Vector& xx)
 	ConstVector yyp(yy, nstat()+npred(), nyss());
 	ogdyn::DynareAtomValues dav(model->getAtoms(), model->getParams(), yym, yy, yyp, xx);
 	DynareDerEvalLoader ddel(model->getAtoms(), md, model->getOrder());
-	for (int iord = 1; iord <= model->getOrder(); iord++)
+	for (int iord = 1; iord <= model->getOrder(); iord++) {
 		fde->eval(dav, ddel, iord);
+		md.get(Symmetry(iord))->compress();
+	}
 }
 
 void Dynare::calcDerivativesAtSteady()
@@ -27,6 +27,9 @@ const char* help_str =
 "    --seed <num>         random number generator seed [934098]\n"
 "    --order <num>        order of approximation [no default]\n"
 "    --threads <num>      number of max parallel threads [2]\n"
+"    --mem-budget <num>   MB of derivatives kept in memory, the rest\n"
+"                         is spilled to scratch files [0=no budget]\n"
+"    --scratch-dir <dir>  directory of the scratch files [.]\n"
 "    --ss-tol <num>       steady state calcs tolerance [1.e-13]\n"
 "    --check pesPES       check model residuals [no checks]\n"
 "                         lower/upper case switches off/on\n"
@@ -49,7 +52,7 @@ DynareParams::DynareParams(int argc, char** argv)
 	: modname(NULL), num_per(100), num_burn(0), num_sim(80), 
 	  num_rtper(0), num_rtsim(0),
 	  num_condper(0), num_condsim(0),
-	  num_threads(2), num_steps(0),
+	  num_threads(2), num_steps(0), mem_budget(0), scratch_dir("."),
 	  prefix("dyn"), seed(934098), order(-1), ss_tol(1.e-13),
 	  check_along_path(false), check_along_shocks(false),
 	  check_on_ellipse(false), check_evals(1000), check_num(10), check_scale(2.0),
@@ -84,6 +87,8 @@ DynareParams::DynareParams(int argc, char** argv)
 		{"condsim", required_argument, NULL, opt_condsim},
 		{"prefix", required_argument, NULL, opt_prefix},
 		{"threads", required_argument, NULL, opt_threads},
+		{"mem-budget", required_argument, NULL, opt_mem_budget},
+		{"scratch-dir", required_argument, NULL, opt_scratch_dir},
 		{"steps", required_argument, NULL, opt_steps},
 		{"seed", required_argument, NULL, opt_seed},
 		{"order", required_argument, NULL, opt_order},
@@ -141,6 +146,13 @@ DynareParams::DynareParams(int argc, char** argv)
 			if (1 != sscanf(optarg, "%d", &num_threads))
 				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
 			break;
+		case opt_mem_budget:
+			if (1 != sscanf(optarg, "%d", &mem_budget))
+				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
+			break;
+		case opt_scratch_dir:
+			scratch_dir = optarg;
+			break;
 		case opt_steps:
 			if (1 != sscanf(optarg, "%d", &num_steps))
 				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
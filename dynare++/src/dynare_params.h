@@ -25,6 +25,10 @@ struct DynareParams {
 	int num_condsim;
 	int num_threads;
 	int num_steps;
+	/** Memory budget in MB for the derivatives kept in memory, 0 for no budget. */
+	int mem_budget;
+	/** Directory of the scratch files the derivatives are spilled to. */
+	const char* scratch_dir;
 	const char* prefix;
 	int seed;
 	int order;
@@ -58,7 +62,7 @@ struct DynareParams {
 		{return 10*check_num;}
 private:
 	enum {opt_per, opt_burn, opt_sim, opt_rtper, opt_rtsim, opt_condper, opt_condsim,
-		  opt_prefix, opt_threads,
+		  opt_prefix, opt_threads, opt_mem_budget, opt_scratch_dir,
 		  opt_steps, opt_seed, opt_order, opt_ss_tol, opt_check,
 		  opt_check_along_path, opt_check_along_shocks, opt_check_on_ellipse,
 		  opt_check_evals, opt_check_scale, opt_check_num, opt_noirfs, opt_irfs,
@@ -29,6 +29,8 @@ int main(int argc, char** argv)
 		return 0;
 	}
 	THREAD_GROUP::max_parallel_threads = params.num_threads;
+	KOrder::mem_budget = params.mem_budget;
+	SylvMemoryPool::setScratchDir(params.scratch_dir);
 
 	try {
 		// make journal name and journal
@@ -10,13 +10,90 @@
 
 #include <ctime>
 
+GeneralSylvesterFactors::GeneralSylvesterFactors(int n, int m, int zero_cols,
+												 const double* da, const double* db,
+												 const double* dc, const SylvParams& ps)
+	: pars(ps), a(da, n), b(db, n, n-zero_cols), c(dc, m),
+	  alu(a.getData()), ipiv(new lapack_int[n])
+{
+	// PLU factorization of a
+	lapack_int info;
+	lapack_int rows = n;
+	dgetrf(&rows, &rows, alu.base(), &rows, ipiv, &info);
+	// condition numbers
+	double* const work = new double[4*n];
+	lapack_int* const iwork = new lapack_int[n];
+	double norm1 = a.getNorm1();
+	double rcond1;
+	dgecon("1", &rows, alu.base(), &rows, &norm1, &rcond1,
+		   work, iwork, &info);
+	double norminf = a.getNormInf();
+	double rcondinf;
+	dgecon("I", &rows, alu.base(), &rows, &norminf, &rcondinf,
+		   work, iwork, &info);
+	delete [] iwork;
+	delete [] work;
+	pars.rcondA1 = rcond1;
+	pars.rcondAI = rcondinf;
+	// decompositions
+	GeneralMatrix ainvb(b);
+	multInvA(ainvb);
+	bdecomp = new SchurDecompZero(ainvb);
+	cdecomp = new SimilarityDecomp(c.getData().base(), c.numRows(), *(pars.bs_norm));
+	cdecomp->check(pars, c);
+	cdecomp->infoToPars(pars);
+	if (*(pars.method) == SylvParams::recurse)
+		sylv = new TriangularSylvester(*bdecomp, *cdecomp);
+	else if (*(pars.method) == SylvParams::blocked)
+		sylv = new TriangularSylvester(*bdecomp, *cdecomp, *(pars.block_size),
+									   *(pars.num_threads));
+	else
+		sylv = new IterativeSylvester(*bdecomp, *cdecomp);
+}
+
+GeneralSylvesterFactors::~GeneralSylvesterFactors()
+{
+	delete sylv;
+	delete cdecomp;
+	delete bdecomp;
+	delete [] ipiv;
+}
+
+void GeneralSylvesterFactors::multInvA(GeneralMatrix& d) const
+{
+	if (d.numRows() != a.numRows())
+		throw SYLV_MES_EXCEPTION("Wrong dimensions for multInvA.");
+	if (d.numCols() == 0)
+		return;
+	lapack_int info;
+	lapack_int rows = a.numRows();
+	lapack_int cols = d.numCols();
+	lapack_int ld = d.getLD();
+	dgetrs("N", &rows, &cols, alu.base(), &rows, ipiv,
+		   d.base(), &ld, &info);
+}
+
+void GeneralSylvesterFactors::infoToPars(SylvParams& p) const
+{
+	p.rcondA1 = pars.rcondA1;
+	p.rcondAI = pars.rcondAI;
+	p.f_err1 = pars.f_err1;
+	p.f_errI = pars.f_errI;
+	p.viv_err1 = pars.viv_err1;
+	p.viv_errI = pars.viv_errI;
+	p.ivv_err1 = pars.ivv_err1;
+	p.ivv_errI = pars.ivv_errI;
+	cdecomp->infoToPars(p);
+}
+
 GeneralSylvester::GeneralSylvester(int ord, int n, int m, int zero_cols,
 								   const double* da, const double* db,
 								   const double* dc, const double* dd,
 								   const SylvParams& ps)
 	: pars(ps), 
-	  mem_driver(pars, 1, m, n, ord), order(ord), a(da, n),
-	  b(db, n, n-zero_cols), c(dc, m), d(dd, n, power(m, order)),
+	  order(ord),
+	  factors(new GeneralSylvesterFactors(n, m, zero_cols, da, db, dc, pars)),
+	  own_factors(true), d(dd, n, power(m, order)),
 	  solved(false)
 {
 	init();
@@ -27,8 +104,9 @@ GeneralSylvester::GeneralSylvester(int ord, int n, int m, int zero_cols,
 								   const double* dc, double* dd,
 								   const SylvParams& ps)
 	: pars(ps),
-	  mem_driver(pars, 0, m, n, ord), order(ord), a(da, n),
-	  b(db, n, n-zero_cols), c(dc, m), d(dd, n, power(m, order)),
+	  order(ord),
+	  factors(new GeneralSylvesterFactors(n, m, zero_cols, da, db, dc, pars)),
+	  own_factors(true), d(dd, n, power(m, order)),
 	  solved(false)
 {
 	init();
@@ -39,8 +117,9 @@ GeneralSylvester::GeneralSylvester(int ord, int n, int m, int zero_cols,
 								   const double* dc, const double* dd,
 								   bool alloc_for_check)
 	: pars(alloc_for_check), 
-	  mem_driver(pars, 1, m, n, ord), order(ord), a(da, n),
-	  b(db, n, n-zero_cols), c(dc, m), d(dd, n, power(m, order)),
+	  order(ord),
+	  factors(new GeneralSylvesterFactors(n, m, zero_cols, da, db, dc, pars)),
+	  own_factors(true), d(dd, n, power(m, order)),
 	  solved(false)
 {
 	init();
@@ -51,8 +130,29 @@ GeneralSylvester::GeneralSylvester(int ord, int n, int m, int zero_cols,
 								   const double* dc, double* dd,
 								   bool alloc_for_check)
 	: pars(alloc_for_check),
-	  mem_driver(pars, 0, m, n, ord), order(ord), a(da, n),
-	  b(db, n, n-zero_cols), c(dc, m), d(dd, n, power(m, order)),
+	  order(ord),
+	  factors(new GeneralSylvesterFactors(n, m, zero_cols, da, db, dc, pars)),
+	  own_factors(true), d(dd, n, power(m, order)),
+	  solved(false)
+{
+	init();
+}
+
+GeneralSylvester::GeneralSylvester(int ord, const GeneralSylvesterFactors& fact,
+								   double* dd, bool alloc_for_check)
+	: pars(alloc_for_check),
+	  order(ord), factors(&fact), own_factors(false),
+	  d(dd, fact.getN(), power(fact.getM(), order)),
+	  solved(false)
+{
+	init();
+}
+
+GeneralSylvester::GeneralSylvester(int ord, const GeneralSylvesterFactors& fact,
+								   double* dd, const SylvParams& ps)
+	: pars(ps),
+	  order(ord), factors(&fact), own_factors(false),
+	  d(dd, fact.getN(), power(fact.getM(), order)),
 	  solved(false)
 {
 	init();
@@ -60,20 +160,8 @@ GeneralSylvester::GeneralSylvester(int ord, int n, int m, int zero_cols,
 
 void GeneralSylvester::init()
 {
-	GeneralMatrix ainvb(b);
-	double rcond1;
-	double rcondinf;
-	a.multInvLeft2(ainvb, d, rcond1, rcondinf);
-	pars.rcondA1 = rcond1;
-	pars.rcondAI = rcondinf;
-	bdecomp = new SchurDecompZero(ainvb);
-	cdecomp = new SimilarityDecomp(c.getData().base(), c.numRows(), *(pars.bs_norm));
-	cdecomp->check(pars, c);
-	cdecomp->infoToPars(pars);
-	if (*(pars.method) == SylvParams::recurse)
-		sylv = new TriangularSylvester(*bdecomp, *cdecomp);
-	else
-		sylv = new IterativeSylvester(*bdecomp, *cdecomp);
+	factors->multInvA(d);
+	factors->infoToPars(pars);
 }
 
 void GeneralSylvester::solve()
@@ -81,24 +169,20 @@ void GeneralSylvester::solve()
 	if (solved)
 		throw SYLV_MES_EXCEPTION("Attempt to run solve() more than once.");
 
-	mem_driver.setStackMode(true);
-
 	clock_t start = clock();
 	// multiply d
-	d.multLeftITrans(bdecomp->getQ());
-	d.multRightKron(cdecomp->getQ(), order);
+	d.multLeftITrans(factors->getBDecomp().getQ());
+	d.multRightKron(factors->getCDecomp().getQ(), order);
 	// convert to KronVector
 	KronVector dkron(d.getData(), getM(), getN(), order);
 	// solve
-	sylv->solve(pars, dkron);
+	factors->getSolver().solve(pars, dkron);
 	// multiply d back
-	d.multLeftI(bdecomp->getQ());
-	d.multRightKron(cdecomp->getInvQ(), order);
+	d.multLeftI(factors->getBDecomp().getQ());
+	d.multRightKron(factors->getCDecomp().getInvQ(), order);
 	clock_t end = clock();
 	pars.cpu_time = ((double)(end-start))/CLOCKS_PER_SEC;
 
-	mem_driver.setStackMode(false);
-
 	solved = true;
 }
 
@@ -107,8 +191,9 @@ void GeneralSylvester::check(const double* ds)
 	if (!solved)
 		throw SYLV_MES_EXCEPTION("Cannot run check on system, which is not solved yet.");
 
-	mem_driver.setStackMode(true);
-
+	const SqSylvMatrix& a = factors->getA();
+	const SylvMatrix& b = factors->getB();
+	const SqSylvMatrix& c = factors->getC();
 	// calculate xcheck = AX+BXC^i-D
 	SylvMatrix dcheck(d.numRows(), d.numCols());
 	dcheck.multLeft(b.numRows()-b.numCols(), b, d);
@@ -122,15 +207,12 @@ void GeneralSylvester::check(const double* ds)
 	pars.mat_errF = dcheck.getData().getNorm()/d.getData().getNorm();
 	pars.vec_err1 = dcheck.getData().getNorm1()/d.getData().getNorm1();
 	pars.vec_errI = dcheck.getData().getMax()/d.getData().getMax();
-
-	mem_driver.setStackMode(false);
 }
 
 GeneralSylvester::~GeneralSylvester()
 {
-	delete bdecomp;
-	delete cdecomp;
-	delete sylv;
+	if (own_factors)
+		delete factors;
 }
 
 // Local Variables:
@@ -10,18 +10,54 @@
 #include "SimilarityDecomp.h"
 #include "SylvesterSolver.h"
 
-class GeneralSylvester {
+#include <dynlapack.h>
+
+/* The factorizations of A, B and C, which do not depend on the right
+ * hand side D nor on the order: the PLU of A, the Schur decomposition
+ * of inv(A)*B, the block diagonalization of C, and the solver built
+ * upon the latter two by the method given in the parameters. They can
+ * be calculated once and shared (also concurrently) by GeneralSylvester
+ * objects solving for different right hand sides and orders. */
+class GeneralSylvesterFactors {
 	SylvParams pars;
-	SylvMemoryDriver mem_driver;
-	int order;
 	const SqSylvMatrix a;
 	const SylvMatrix b;
 	const SqSylvMatrix c;
-	SylvMatrix d;
-	bool solved;
+	Vector alu;
+	lapack_int* const ipiv;
 	SchurDecompZero* bdecomp;
 	SimilarityDecomp* cdecomp;
 	SylvesterSolver* sylv;
+public:
+	GeneralSylvesterFactors(int n, int m, int zero_cols,
+							const double* da, const double* db,
+							const double* dc, const SylvParams& ps);
+	~GeneralSylvesterFactors();
+	int getM() const {return c.numRows();}
+	int getN() const {return a.numRows();}
+	const SqSylvMatrix& getA() const {return a;}
+	const SylvMatrix& getB() const {return b;}
+	const SqSylvMatrix& getC() const {return c;}
+	const SchurDecompZero& getBDecomp() const {return *bdecomp;}
+	const SimilarityDecomp& getCDecomp() const {return *cdecomp;}
+	const SylvesterSolver& getSolver() const {return *sylv;}
+	/* d = inv(A)*d */
+	void multInvA(GeneralMatrix& d) const;
+	/* copies condition numbers of A and info on decomposition of C */
+	void infoToPars(SylvParams& p) const;
+private:
+	GeneralSylvesterFactors(const GeneralSylvesterFactors&);
+	const GeneralSylvesterFactors& operator=(const GeneralSylvesterFactors&);
+};
+
+class GeneralSylvester {
+	SylvParams pars;
+	SylvMemoryDriver mem_driver;
+	int order;
+	const GeneralSylvesterFactors* const factors;
+	const bool own_factors;
+	SylvMatrix d;
+	bool solved;
 public:
 	/* construct with my copy of d*/
 	GeneralSylvester(int ord, int n, int m, int zero_cols,
@@ -41,9 +77,15 @@ public:
 					 const double* da, const double* db,
 					 const double* dc, double* dd,
 					 const SylvParams& ps);
+	/* construct with shared factorizations and provided storage for d,
+	   the method of solution is given by the factorizations */
+	GeneralSylvester(int ord, const GeneralSylvesterFactors& fact, double* dd,
+					 bool alloc_for_check = false);
+	GeneralSylvester(int ord, const GeneralSylvesterFactors& fact, double* dd,
+					 const SylvParams& ps);
 	virtual ~GeneralSylvester();
-	int getM() const {return c.numRows();}
-	int getN() const {return a.numRows();}
+	int getM() const {return factors->getM();}
+	int getN() const {return factors->getN();}
 	const double* getResult() const {return d.base();}
 	const SylvParams& getParams() const {return pars;}
 	SylvParams& getParams() {return pars;}
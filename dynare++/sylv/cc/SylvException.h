@@ -5,10 +5,7 @@
 #ifndef SYLV_EXCEPTION_H
 #define SYLV_EXCEPTION_H
 
-#include "SylvMemory.h"
-
-
-class SylvException : public MallocAllocator {
+class SylvException {
 protected:
 	char file[50];
 	int line;
@@ -3,219 +3,204 @@
 /* Tag $Name:  $ */
 
 #include "SylvMemory.h"
-#include "SylvException.h"
-#include "KronVector.h"
 
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-# include <dynmex.h>
-#endif
-
-#include <cmath> 
-#include <cstdio>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if !defined(_WIN32)
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
 
 /**********************************************************/
 /*   SylvMemoryPool                                       */
 /**********************************************************/
 
-SylvMemoryPool memory_pool;
-
-SylvMemoryPool::SylvMemoryPool()
-	: base(0), length(0), allocated(0), stack_mode(false)
-{
-}
-
-void SylvMemoryPool::init(size_t size)
-{
-#ifdef USE_MEMORY_POOL
-	length = size;
-
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-	if (base)
-		throw SYLV_MES_EXCEPTION("Attempt to use matlab memory pool twice.");
-	base = (char*) mxMalloc(length);
-#else
-	base = (char*) malloc(length);
-#endif
-
+/* Each array is preceded by a header holding its size class, or -1 if
+ * the array is not to be kept, or -2 if it is mapped to a scratch file
+ * (then the header holds also the length of the mapping). The header
+ * is 16 bytes long to keep the alignment of malloc. A kept array
+ * stores the link to the next array of its free list in its first
+ * bytes. */
+
+union PoolHeader {
+	struct {
+		int cls;
+		size_t bytes;
+	} info;
+	double pad[2];
+};
+
+struct PoolState {
+	int depth;
+	int scratch_depth;
+	void* free_list[SylvMemoryPool::max_class+1];
+	SylvMemoryStats stats;
+};
+
+static char scratch_dir[1000] = "";
+
+const int SylvMemoryPool::max_class;
+const size_t SylvMemoryPool::max_cached;
+const int SylvMemoryPool::min_mapped;
+
+static SYLV_THREAD_LOCAL PoolState pool_state;
+
+static inline size_t class_bytes(int cls)
+{
+	return sizeof(PoolHeader) + (((size_t)1) << cls)*sizeof(double);
+}
+
+/* This maps an array of the given number of bytes (including the
+ * header) to a new scratch file, which is unlinked at once, so it
+ * vanishes with the mapping. It returns NULL if the mapping fails. */
+
+static PoolHeader* map_scratch(size_t bytes)
+{
+#if !defined(_WIN32)
+	char fname[1100];
+	sprintf(fname, "%s/sylv_scratch_XXXXXX", scratch_dir);
+	int fd = mkstemp(fname);
+	if (fd == -1)
+		return NULL;
+	unlink(fname);
+	void* p = MAP_FAILED;
+	if (ftruncate(fd, bytes) == 0)
+		p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return NULL;
+	PoolHeader* h = (PoolHeader*)p;
+	h->info.cls = -2;
+	h->info.bytes = bytes;
+	return h;
 #else
-	throw SYLV_MES_EXCEPTION("SylvMemoryPool::init() called for non memory pool code.");
+	return NULL;
 #endif
 }
 
-void* SylvMemoryPool::allocate(size_t size)
+double* SylvMemoryPool::allocate(int n)
 {
-#ifdef USE_MEMORY_POOL
-	if (allocated + size < length) {
-		char* res = base + allocated;
-		allocated += size;
-		return res;
+	PoolState& st = pool_state;
+	st.stats.num_alloc++;
+	if (st.scratch_depth > 0 && scratch_dir[0] && n >= min_mapped) {
+		size_t bytes = sizeof(PoolHeader) + ((size_t)n)*sizeof(double);
+		PoolHeader* h = map_scratch(bytes);
+		if (h) {
+			st.stats.mapped_bytes += bytes;
+			return (double*)(h+1);
+		}
+	}
+	/* Outside of a pool scope the array is freed on release, so it
+	 * gets its exact size rather than the size of its class. */
+	int cls = -1;
+	if (st.depth > 0) {
+		cls = 2;
+		while (cls <= max_class && (1 << cls) < n)
+			cls++;
+		if (cls > max_class)
+			cls = -1;
+	}
+	size_t bytes;
+	if (cls < 0) {
+		bytes = sizeof(PoolHeader) + ((size_t)n)*sizeof(double);
 	} else {
-		throw SYLV_MES_EXCEPTION("Run out of memory space");
+		bytes = class_bytes(cls);
+		if (st.free_list[cls]) {
+			PoolHeader* h = (PoolHeader*)st.free_list[cls];
+			st.free_list[cls] = *(void**)(h+1);
+			st.stats.cached_bytes -= bytes;
+			st.stats.num_reused++;
+			return (double*)(h+1);
+		}
+	}
+	PoolHeader* h = (PoolHeader*)malloc(bytes);
+	if (!h)
+		throw std::bad_alloc();
+	st.stats.sys_bytes += bytes;
+	h->info.cls = cls;
+	return (double*)(h+1);
+}
+
+void SylvMemoryPool::release(double* p)
+{
+	if (!p)
+		return;
+	PoolState& st = pool_state;
+	PoolHeader* h = ((PoolHeader*)p)-1;
+	int cls = h->info.cls;
+#if !defined(_WIN32)
+	if (cls == -2) {
+		st.stats.mapped_bytes -= h->info.bytes;
+		munmap(h, h->info.bytes);
+		return;
 	}
-#else
-	throw SYLV_MES_EXCEPTION("SylvMemoryPool::allocate() called for non memory pool code.");
-#endif
-}
-
-void SylvMemoryPool::free(void* p)
-{
-#ifdef USE_MEMORY_POOL
-	int offset = ((char*)p) - base;
-
-#ifdef DEBUG
-	if (offset < 0)
-		throw SYLV_MES_EXCEPTION("SylvMemoryPool::free() frees wrong address < begin.");
-	if (offset >= (int)length)
-		throw SYLV_MES_EXCEPTION("SylvMemoryPool::free() frees wrong address > end.");
-#endif	
-
-	if (stack_mode && offset >= 0 && offset < (int)allocated)
-		allocated = offset;
-
-#else
-	throw SYLV_MES_EXCEPTION("SylvMemoryPool::free() called for non memory pool code.");
-#endif
-}
-
-void SylvMemoryPool::setStackMode(bool mode)
-{
-	stack_mode = mode;
-}
-
-SylvMemoryPool::~SylvMemoryPool()
-{
-	reset();
-}
-
-void SylvMemoryPool::reset()
-{
-#if !defined(MATLAB_MEX_FILE) && !defined(OCTAVE_MEX_FILE)
-	delete [] base;
-	base = 0;
-	allocated = 0;
-	length = 0;
-	stack_mode = false;
 #endif
+	if (st.depth > 0 && cls >= 0
+		&& st.stats.cached_bytes + class_bytes(cls) <= max_cached) {
+		*(void**)p = st.free_list[cls];
+		st.free_list[cls] = h;
+		st.stats.cached_bytes += class_bytes(cls);
+		if (st.stats.peak_cached < st.stats.cached_bytes)
+			st.stats.peak_cached = st.stats.cached_bytes;
+	} else {
+		free(h);
+	}
 }
 
-/**********************************************************/
-/*   global new and delete                                */
-/**********************************************************/
-
-#ifdef USE_MEMORY_POOL
-
-void* operator new(size_t size)
-{
-	return memory_pool.allocate(size);
-}
-
-void* operator new[](size_t size)
-{
-	return memory_pool.allocate(size);
-}
-
-void operator delete(void* p)
-{
-	memory_pool.free(p);
-}
-
-void operator delete[](void* p)
+void SylvMemoryPool::open()
 {
-	memory_pool.free(p);
+	pool_state.depth++;
 }
 
-#endif
-
-/**********************************************************/
-/*   saved version of global new and delete               */
-/**********************************************************/
-
-#ifdef USE_MEMORY_POOL
-void* MallocAllocator::operator new(size_t size)
+void SylvMemoryPool::close()
 {
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-	throw SYLV_MES_EXCEPTION("Attempt to call wrong memory allocator.");
-#else
-	void* res = malloc(size);
-	if (!res) 
-		throw SYLV_MES_EXCEPTION("Malloc unable to allocate memory.");
-	return res;
-#endif
-}
-
-void* MallocAllocator::operator new[](size_t size)
-{
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-	throw SYLV_MES_EXCEPTION("Attempt to call wrong memory allocator.");
-#else
-	void* res = malloc(size);
-	if (!res)
-		throw SYLV_MES_EXCEPTION("Malloc unable allocate memory.");
-	return res;
-#endif
+	PoolState& st = pool_state;
+	if (--st.depth > 0)
+		return;
+	for (int cls = 0; cls <= max_class; cls++) {
+		while (st.free_list[cls]) {
+			PoolHeader* h = (PoolHeader*)st.free_list[cls];
+			st.free_list[cls] = *(void**)(h+1);
+			free(h);
+		}
+	}
+	st.stats.cached_bytes = 0;
 }
 
-void MallocAllocator::operator delete(void* p)
+void SylvMemoryPool::openScratch()
 {
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-	throw SYLV_MES_EXCEPTION("Attempt to call wrong memory destructor.");
-#else
-	free(p);
-#endif
+	pool_state.scratch_depth++;
 }
 
-void MallocAllocator::operator delete[](void* p)
+void SylvMemoryPool::closeScratch()
 {
-#if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)
-	throw SYLV_MES_EXCEPTION("Attempt to call wrong memory destructor.");
-#else
-	free(p);
-#endif
+	pool_state.scratch_depth--;
 }
 
-#endif
-
-
-/**********************************************************/
-/*   SylvMemoryDriver                                     */
-/**********************************************************/
-
-void SylvMemoryDriver::allocate(int num_d, int m, int n, int order)
+void SylvMemoryPool::setScratchDir(const char* dir)
 {
-#ifdef USE_MEMORY_POOL
-	int x_cols = power(m,order);
-	int total = num_d*x_cols*n; // storage for big matrices
-	total += x_cols; // storage for one extra row of a big matrix
-	int dig_vectors = (int)ceil(((double)(power(m,order)-1))/(m-1));
-	total += 8*n*dig_vectors; // storage for kron vectors instantiated during solv
-	total += 50*(m*m+n*n); // some storage for small square matrices
-	total *= sizeof(double); // everything in doubles
-	memory_pool.init(total);
-#endif
+	strncpy(scratch_dir, dir, sizeof(scratch_dir)-1);
+	scratch_dir[sizeof(scratch_dir)-1] = '\0';
 }
 
-
-SylvMemoryDriver::SylvMemoryDriver(int num_d, int m, int n, int order)
+bool SylvMemoryPool::isMapped(const double* p)
 {
-	allocate(num_d, m, n, order);
+	return p && (((const PoolHeader*)p)-1)->info.cls == -2;
 }
 
-SylvMemoryDriver::SylvMemoryDriver(const SylvParams& pars, int num_d,
-								   int m, int n, int order)
+const SylvMemoryStats& SylvMemoryPool::getStats()
 {
-	if (*(pars.method) == SylvParams::iter)
-		num_d++;
-	if (*(pars.want_check))
-		num_d++;
-	allocate(num_d, m, n, order);
+	return pool_state.stats;
 }
 
-SylvMemoryDriver::~SylvMemoryDriver()
+void SylvMemoryPool::resetStats()
 {
-	memory_pool.reset();
-}
-
-void SylvMemoryDriver::setStackMode(bool mode) {
-	memory_pool.setStackMode(mode);
+	SylvMemoryStats& s = pool_state.stats;
+	s.num_alloc = 0;
+	s.num_reused = 0;
+	s.sys_bytes = 0;
+	s.peak_cached = s.cached_bytes;
 }
@@ -5,54 +5,80 @@
 #ifndef SYLV_MEMORY_H
 #define SYLV_MEMORY_H
 
-#include "SylvParams.h"
+#include <cstddef>
 
-#include <new>
-
-class MallocAllocator {
-#ifdef USE_MEMORY_POOL
-public:
-	void* operator new(size_t size);
-	void* operator new[](size_t size);
-	void operator delete(void* p);
-	void operator delete[](void* p);
+#if defined(_MSC_VER)
+# define SYLV_THREAD_LOCAL __declspec(thread)
+#else
+# define SYLV_THREAD_LOCAL __thread
 #endif
-};
 
-#ifdef USE_MEMORY_POOL
-void* operator new(size_t size);
-void* operator new[](size_t size);
-void operator delete(void* p);
-void operator delete[](void* p);
-#endif
+/* The pool of the arrays of doubles owned by Vector, and hence by all
+ * the matrices and tensors built upon it. The pool is thread local,
+ * so no locking is needed. Outside a SylvMemoryDriver scope, the
+ * arrays are simply malloc'ed and freed. Within a scope, a released
+ * array is kept in the free list of its size class (sizes are rounded
+ * up to powers of two) and reused by the next allocation of the same
+ * class in the same thread. The kept arrays are returned to the system
+ * when the outermost scope of the thread is left. An array may be
+ * released by another thread than the one which allocated it.
+ *
+ * Within a SylvScratchDriver scope, the arrays of at least min_mapped
+ * doubles allocated by the thread are mapped to scratch files in the
+ * directory given by setScratchDir(), so that the system may page them
+ * out. This is used to keep large results out of the physical memory
+ * until they are needed. If no directory is set, or on Windows, the
+ * arrays are allocated as usual. */
+
+struct SylvMemoryStats {
+	long num_alloc;      // number of allocated arrays
+	long num_reused;     // number of arrays served from the free lists
+	double sys_bytes;    // bytes obtained from malloc
+	size_t cached_bytes; // bytes currently kept in the free lists
+	size_t peak_cached;  // maximum of cached_bytes
+	double mapped_bytes; // bytes currently mapped to scratch files
+};
 
 class SylvMemoryPool {
-	char* base;
-	size_t length;
-	size_t allocated;
-	bool stack_mode;
-	SylvMemoryPool(const SylvMemoryPool&);
-	const SylvMemoryPool& operator=(const SylvMemoryPool&);
 public:
-	SylvMemoryPool();
-	~SylvMemoryPool();
-	void init(size_t size);
-	void* allocate(size_t size);
-	void free(void* p);
-	void reset();
-	void setStackMode(bool);
+	/* Arrays above 2^max_class doubles are never kept, and a thread
+	 * keeps at most max_cached bytes. */
+	static const int max_class = 22;
+	static const size_t max_cached = ((size_t)1) << 27;
+	static const int min_mapped = 1 << 16;
+	static double* allocate(int n);
+	static void release(double* p);
+	static void open();
+	static void close();
+	static void openScratch();
+	static void closeScratch();
+	static void setScratchDir(const char* dir);
+	static bool isMapped(const double* p);
+	/* The statistics of the calling thread only. */
+	static const SylvMemoryStats& getStats();
+	static void resetStats();
 };
 
+/* A scope of the memory pool of the current thread. */
 class SylvMemoryDriver {
 	SylvMemoryDriver(const SylvMemoryDriver&);
 	const SylvMemoryDriver& operator=(const SylvMemoryDriver&);
 public:
-	SylvMemoryDriver(int num_d, int m, int n, int order);
-	SylvMemoryDriver(const SylvParams& pars, int num_d, int m, int n, int order);
-	static void setStackMode(bool);
-	~SylvMemoryDriver();
-protected:
-	void allocate(int num_d, int m, int n, int order);
+	SylvMemoryDriver()
+		{SylvMemoryPool::open();}
+	~SylvMemoryDriver()
+		{SylvMemoryPool::close();}
+};
+
+/* A scope within which the large arrays are mapped to scratch files. */
+class SylvScratchDriver {
+	SylvScratchDriver(const SylvScratchDriver&);
+	const SylvScratchDriver& operator=(const SylvScratchDriver&);
+public:
+	SylvScratchDriver()
+		{SylvMemoryPool::openScratch();}
+	~SylvScratchDriver()
+		{SylvMemoryPool::closeScratch();}
 };
 
 #endif /* SYLV_MEMORY_H */
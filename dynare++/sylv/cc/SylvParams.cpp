@@ -32,6 +32,10 @@ void SylvParams::print(FILE* fdesc, const char* prefix) const
 		max_num_iter.print(fdesc, prefix,    "max num iter       ", "%d");
 		num_iter.print(fdesc, prefix,        "num iter           ", "%d");
 	} else {
+		if (*method == blocked) {
+			block_size.print(fdesc, prefix,  "block size         ", "%d");
+			num_threads.print(fdesc, prefix, "num threads        ", "%d");
+		}
 		eig_min.print(fdesc, prefix,         "minimum eigenvalue ", "%8.4g");
 	}
 	mat_err1.print(fdesc, prefix, "rel. matrix norm1  ", "%8.4g");
@@ -49,6 +53,8 @@ void SylvParams::copy(const SylvParams& p)
 	max_num_iter = p.max_num_iter;
 	bs_norm = p.bs_norm;
 	want_check = p.want_check;
+	block_size = p.block_size;
+	num_threads = p.num_threads;
 	converged = p.converged;
 	iter_last_norm = p.iter_last_norm;
 	num_iter = p.num_iter;
@@ -84,6 +90,10 @@ void SylvParams::setArrayNames(int& num, const char** names) const
 		names[num++] = "max_num_iter";
 	if (bs_norm.getStatus() != undef)
 		names[num++] = "bs_norm";
+	if (block_size.getStatus() != undef)
+		names[num++] = "block_size";
+	if (num_threads.getStatus() != undef)
+		names[num++] = "num_threads";
 	if (converged.getStatus() != undef)
 		names[num++] = "converged";
 	if (iter_last_norm.getStatus() != undef)
@@ -155,6 +165,8 @@ mxArray* SylvParams::MethodParamItem::createMatlabArray() const
 {
 	if (value == iter)
 		return mxCreateString("iterative");
+	else if (value == blocked)
+		return mxCreateString("blocked");
 	else
 		return mxCreateString("recursive");
 }
@@ -176,6 +188,10 @@ mxArray* SylvParams::createStructArray() const
 		mxSetFieldByNumber(res, 0, i++, max_num_iter.createMatlabArray());
 	if (bs_norm.getStatus() != undef)
 		mxSetFieldByNumber(res, 0, i++, bs_norm.createMatlabArray());
+	if (block_size.getStatus() != undef)
+		mxSetFieldByNumber(res, 0, i++, block_size.createMatlabArray());
+	if (num_threads.getStatus() != undef)
+		mxSetFieldByNumber(res, 0, i++, num_threads.createMatlabArray());
 	if (converged.getStatus() != undef)
 		mxSetFieldByNumber(res, 0, i++, converged.createMatlabArray());
 	if (iter_last_norm.getStatus() != undef)
@@ -53,7 +53,7 @@ public:
 
 class SylvParams {
 public:
-	typedef enum {iter, recurse} solve_method;
+	typedef enum {iter, recurse, blocked} solve_method;
 
 protected:
 	class DoubleParamItem : public ParamItem<double> {
@@ -106,11 +106,13 @@ protected:
 
 public:
 	// input parameters
-	MethodParamItem method; // method of solution: iter/recurse
+	MethodParamItem method; // method of solution: iter/recurse/blocked
 	DoubleParamItem convergence_tol; // norm for what we consider converged
 	IntParamItem max_num_iter; // max number of iterations
 	DoubleParamItem bs_norm; // Bavely Stewart log10 of norm for diagonalization
 	BoolParamItem want_check; // true => allocate extra space for checks
+	IntParamItem block_size; // number of columns of F in a block (blocked)
+	IntParamItem num_threads; // number of threads for independent blocks of F (blocked)
 	// output parameters
 	BoolParamItem converged; // true if converged
 	DoubleParamItem iter_last_norm; // norm of the last iteration
@@ -138,7 +140,7 @@ public:
 
 	SylvParams(bool wc = false)
 		: method(recurse), convergence_tol(1.e-30), max_num_iter(15),
-		  bs_norm(1.3), want_check(wc) {}
+		  bs_norm(1.3), want_check(wc), block_size(32), num_threads(1) {}
 	SylvParams(const SylvParams& p)
 		{copy(p);}
 	const SylvParams& operator=(const SylvParams& p)
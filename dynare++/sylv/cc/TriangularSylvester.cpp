@@ -7,34 +7,53 @@
 #include "KronUtils.h"
 #include "BlockDiagonal.h"
 
+#include "SylvMemory.h"
+#include "SylvException.h"
+
 #include <cstdio>
+#include <cstring>
 #include <cmath>
+#include <exception>
+#include <new>
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 double TriangularSylvester::diag_zero = 1.e-15;
 double TriangularSylvester::diag_zero_sq = 1.e-30;
 
 TriangularSylvester::TriangularSylvester(const QuasiTriangular& k,
-										 const QuasiTriangular& f)
+										 const QuasiTriangular& f,
+										 int bs, int nt)
 	: SylvesterSolver(k, f),
 	  matrixKK(matrixK->clone(2, *matrixK)),
-	  matrixFF(new QuasiTriangular(2, *matrixF))
+	  matrixFF(new QuasiTriangular(2, *matrixF)),
+	  block_size(bs), num_threads(nt)
 {
+	getGroups(groups);
 }
 
 TriangularSylvester::TriangularSylvester(const SchurDecompZero& kdecomp,
-										 const SchurDecomp& fdecomp)
+										 const SchurDecomp& fdecomp,
+										 int bs, int nt)
 	: SylvesterSolver(kdecomp, fdecomp),
 	  matrixKK(matrixK->clone(2, *matrixK)),
-	  matrixFF(new QuasiTriangular(2, *matrixF))
+	  matrixFF(new QuasiTriangular(2, *matrixF)),
+	  block_size(bs), num_threads(nt)
 {
+	getGroups(groups);
 }
 
 TriangularSylvester::TriangularSylvester(const SchurDecompZero& kdecomp,
-										 const SimilarityDecomp& fdecomp)
+										 const SimilarityDecomp& fdecomp,
+										 int bs, int nt)
 	: SylvesterSolver(kdecomp, fdecomp),
 	  matrixKK(matrixK->clone(2, *matrixK)),
-	  matrixFF(new BlockDiagonal(2, *matrixF))
+	  matrixFF(new BlockDiagonal(2, *matrixF)),
+	  block_size(bs), num_threads(nt)
 {
+	getGroups(groups);
 }
 
 TriangularSylvester::~TriangularSylvester()
@@ -54,29 +73,305 @@ void TriangularSylvester::print() const
 void TriangularSylvester::solve(SylvParams& pars, KronVector& d) const
 {
 	double eig_min = 1e30;
-	solvi(1., d, eig_min);
+	if (block_size > 0 && num_threads > 1 && groups.size() > 1
+		&& d.getDepth() > 0)
+		solveGroups(d, eig_min);
+	else
+		solvi(1., d, eig_min);
 	pars.eig_min = sqrt(eig_min);
 }
 
+/* The state shared by the threads solving the groups. A thread takes
+ * the first group not yet taken until all are solved, or until a
+ * thread fails. An exception cannot leave a thread, so the first one
+ * is recorded and rethrown by the calling thread once all have been
+ * joined: std::bad_alloc as such, the others as a SylvException with
+ * their message. */
+struct TriangularSylvesterGroups {
+	enum error_type {no_error, memory_error, other_error};
+	const TriangularSylvester* sylv;
+	const TriangularSylvester::Groups* groups;
+	KronVector* d;
+	unsigned int next;
+	double eig_min;
+	error_type error;
+	char message[400];
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+#endif
+	bool take(unsigned int& g);
+	void done(double em);
+	void fail(error_type e, const char* mes);
+};
+
+bool TriangularSylvesterGroups::take(unsigned int& g)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&mutex);
+#endif
+	g = next++;
+	bool res = error == no_error && g < groups->size();
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&mutex);
+#endif
+	return res;
+}
+
+void TriangularSylvesterGroups::done(double em)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&mutex);
+#endif
+	if (em < eig_min)
+		eig_min = em;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&mutex);
+#endif
+}
+
+void TriangularSylvesterGroups::fail(error_type e, const char* mes)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&mutex);
+#endif
+	if (error == no_error) {
+		error = e;
+		strncpy(message, mes, sizeof(message)-1);
+		message[sizeof(message)-1] = '\0';
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&mutex);
+#endif
+}
+
+static void* solve_groups(void* arg)
+{
+	TriangularSylvesterGroups* tsg = (TriangularSylvesterGroups*) arg;
+	SylvMemoryDriver memdriver;
+	double eig_min = 1e30;
+	unsigned int g;
+	while (tsg->take(g)) {
+		try {
+			tsg->sylv->solviGroup(1., (*(tsg->groups))[g].first,
+								  (*(tsg->groups))[g].second,
+								  *(tsg->d), eig_min);
+		} catch (const SylvException& e) {
+			char mes[400];
+			mes[0] = '\0';
+			e.printMessage(mes, sizeof(mes)-1);
+			tsg->fail(TriangularSylvesterGroups::other_error, mes);
+		} catch (const std::bad_alloc& e) {
+			tsg->fail(TriangularSylvesterGroups::memory_error, e.what());
+		} catch (const std::exception& e) {
+			tsg->fail(TriangularSylvesterGroups::other_error, e.what());
+		} catch (...) {
+			tsg->fail(TriangularSylvesterGroups::other_error, "Unknown exception.");
+		}
+	}
+	tsg->done(eig_min);
+	return NULL;
+}
+
+void TriangularSylvester::solveGroups(KronVector& d, double& eig_min) const
+{
+	TriangularSylvesterGroups tsg;
+	tsg.sylv = this;
+	tsg.groups = &groups;
+	tsg.d = &d;
+	tsg.next = 0;
+	tsg.eig_min = eig_min;
+	tsg.error = TriangularSylvesterGroups::no_error;
+	tsg.message[0] = '\0';
+#ifdef HAVE_PTHREAD
+	pthread_mutex_init(&(tsg.mutex), NULL);
+	int nt = num_threads;
+	if (nt > (int)groups.size())
+		nt = groups.size();
+	// the calling thread takes the groups too, so the groups are all
+	// solved even if no thread could be created
+	vector<pthread_t> threads;
+	for (int i = 0; i < nt-1; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, solve_groups, &tsg) == 0)
+			threads.push_back(thread);
+	}
+	solve_groups(&tsg);
+	for (unsigned int i = 0; i < threads.size(); i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&(tsg.mutex));
+#else
+	solve_groups(&tsg);
+#endif
+	if (tsg.error == TriangularSylvesterGroups::memory_error)
+		throw std::bad_alloc();
+	if (tsg.error != TriangularSylvesterGroups::no_error) {
+		char mes[500];
+		sprintf(mes, "Failed to solve a group of diagonal blocks of F:\n%s", tsg.message);
+		throw SYLV_MES_EXCEPTION(mes);
+	}
+	eig_min = tsg.eig_min;
+}
+
 void TriangularSylvester::solvi(double r, KronVector& d, double& eig_min) const
 {
 	if (d.getDepth() == 0) {
 		QuasiTriangular* t = matrixK->clone(r);
 		t->solvePre(d, eig_min);
 		delete t;
+	} else if (block_size > 0) {
+		for (Groups::const_iterator gi = groups.begin(); gi != groups.end(); ++gi)
+			solviGroup(r, (*gi).first, (*gi).second, d, eig_min);
 	} else {
+		int jend = d.getM();
 		for (const_diag_iter di = matrixF->diag_begin();
 			 di != matrixF->diag_end();
 			 ++di) {
 			if ((*di).isReal()) {
-				solviRealAndEliminate(r, di, d, eig_min);
+				KronVector y(d.getM(), d.getN(), d.getDepth()-1);
+				solviRealAndEliminate(r, di, d, eig_min, y, jend);
 			} else {
-				solviComplexAndEliminate(r, di, d, eig_min);
+				KronVector y1(d.getM(), d.getN(), d.getDepth()-1);
+				KronVector y2(d.getM(), d.getN(), d.getDepth()-1);
+				solviComplexAndEliminate(r, di, d, eig_min, y1, y2, jend);
 			}
 		}
 	}
 }
 
+void TriangularSylvester::solviGroup(double r, const_diag_iter dbeg, const_diag_iter dend,
+									 KronVector& d, double& eig_min) const
+{
+	const_diag_iter di = dbeg;
+	while (di != dend) {
+		const_diag_iter de = panelEnd(di, dend);
+		solviPanel(r, di, de, d, eig_min);
+		di = de;
+	}
+}
+
+/* Each group ends with the last column of F reached by the rows of
+ * its blocks, so the next group is not coupled with it. For upper
+ * triangular F there is one group, for the block diagonal F there is
+ * one group per diagonal block. */
+void TriangularSylvester::getGroups(Groups& gr) const
+{
+	const_diag_iter dbeg = matrixF->diag_begin();
+	int gend = 0;
+	for (const_diag_iter di = matrixF->diag_begin();
+		 di != matrixF->diag_end();
+		 ++di) {
+		if (di != dbeg && (*di).getIndex() >= gend) {
+			gr.push_back(make_pair(dbeg, di));
+			dbeg = di;
+		}
+		int rend = matrixF->row_end(*di).getCol();
+		if (gend < rend)
+			gend = rend;
+	}
+	if (dbeg != matrixF->diag_end())
+		gr.push_back(make_pair(dbeg, matrixF->diag_end()));
+}
+
+TriangularSylvester::const_diag_iter
+TriangularSylvester::panelEnd(const_diag_iter di, const_diag_iter dend) const
+{
+	int jbeg = (*di).getIndex();
+	do {
+		++di;
+	} while (di != dend && (*di).getIndex() - jbeg < block_size);
+	return di;
+}
+
+int TriangularSylvester::panelRowEnd(const_diag_iter di, const_diag_iter dend) const
+{
+	int rend = 0;
+	for (; di != dend; ++di) {
+		int r = matrixF->row_end(*di).getCol();
+		if (rend < r)
+			rend = r;
+	}
+	return rend;
+}
+
+/* Here we solve the blocks of the panel as solvi does, but the
+ * elimination goes only to the columns of the panel. The y's are stored
+ * as columns of a matrix Y, the rest of d is then updated by
+ * D_rest = D_rest - Y*F_panel,rest in one multiplication. The columns
+ * of d are contiguous, so D_rest is a submatrix of d. */
+void TriangularSylvester::solviPanel(double r, const_diag_iter dbeg, const_diag_iter dend,
+									 KronVector& d, double& eig_min) const
+{
+	int jbeg = (*dbeg).getIndex();
+	int jend = jbeg;
+	for (const_diag_iter di = dbeg; di != dend; ++di)
+		jend += (*di).isReal() ? 1 : 2;
+	int sublen = d.length()/d.getM();
+	GeneralMatrix ymat(sublen, jend-jbeg);
+	for (const_diag_iter di = dbeg; di != dend; ++di) {
+		int jbar = (*di).getIndex();
+		Vector yv(ymat.getData(), (jbar-jbeg)*sublen, sublen);
+		KronVector y(yv, d.getM(), d.getN(), d.getDepth()-1);
+		if ((*di).isReal()) {
+			solviRealAndEliminate(r, di, d, eig_min, y, jend);
+		} else {
+			Vector yyv(ymat.getData(), (jbar+1-jbeg)*sublen, sublen);
+			KronVector yy(yyv, d.getM(), d.getN(), d.getDepth()-1);
+			solviComplexAndEliminate(r, di, d, eig_min, y, yy, jend);
+		}
+	}
+	int rend = panelRowEnd(dbeg, dend);
+	if (rend > jend) {
+		GeneralMatrix drest(d.base()+jend*sublen, sublen, rend-jend);
+		drest.multAndAdd(ConstGeneralMatrix(ymat),
+						 ConstGeneralMatrix(*matrixF, jbeg, jend, jend-jbeg, rend-jend),
+						 -1.0);
+	}
+}
+
+/* As solviPanel, with D_rest = D_rest - Y1*F_panel,rest - Y2*FF_panel,rest. */
+void TriangularSylvester::solviipPanel(double alpha, double betas,
+									   const_diag_iter dbeg, const_diag_iter dend,
+									   const_diag_iter dsbeg,
+									   KronVector& d, double& eig_min) const
+{
+	int jbeg = (*dbeg).getIndex();
+	int jend = jbeg;
+	for (const_diag_iter di = dbeg; di != dend; ++di)
+		jend += (*di).isReal() ? 1 : 2;
+	int sublen = d.length()/d.getM();
+	GeneralMatrix y1mat(sublen, jend-jbeg);
+	GeneralMatrix y2mat(sublen, jend-jbeg);
+	const_diag_iter dsi = dsbeg;
+	for (const_diag_iter di = dbeg; di != dend; ++di, ++dsi) {
+		int off = ((*di).getIndex()-jbeg)*sublen;
+		Vector y1v(y1mat.getData(), off, sublen);
+		Vector y2v(y2mat.getData(), off, sublen);
+		KronVector y1(y1v, d.getM(), d.getN(), d.getDepth()-1);
+		KronVector y2(y2v, d.getM(), d.getN(), d.getDepth()-1);
+		if ((*di).isReal()) {
+			solviipRealAndEliminate(alpha, betas, di, dsi, d, eig_min,
+									y1, y2, jend);
+		} else {
+			Vector y11v(y1mat.getData(), off+sublen, sublen);
+			Vector y22v(y2mat.getData(), off+sublen, sublen);
+			KronVector y11(y11v, d.getM(), d.getN(), d.getDepth()-1);
+			KronVector y22(y22v, d.getM(), d.getN(), d.getDepth()-1);
+			solviipComplexAndEliminate(alpha, betas, di, dsi, d, eig_min,
+									   y1, y11, y2, y22, jend);
+		}
+	}
+	int rend = panelRowEnd(dbeg, dend);
+	if (rend > jend) {
+		GeneralMatrix drest(d.base()+jend*sublen, sublen, rend-jend);
+		drest.multAndAdd(ConstGeneralMatrix(y1mat),
+						 ConstGeneralMatrix(*matrixF, jbeg, jend, jend-jbeg, rend-jend),
+						 -1.0);
+		drest.multAndAdd(ConstGeneralMatrix(y2mat),
+						 ConstGeneralMatrix(*matrixFF, jbeg, jend, jend-jbeg, rend-jend),
+						 -1.0);
+	}
+}
+
 
 void TriangularSylvester::solvii(double alpha, double beta1, double beta2,
 								 KronVector& d1, KronVector& d2,
@@ -105,14 +400,32 @@ void TriangularSylvester::solviip(double alpha, double betas,
 		QuasiTriangular* t= matrixK->clone(2*alpha, aspbs, *matrixKK);
 		t->solvePre(d, eig_min);
 		delete t;
+	} else if (block_size > 0) {
+		const_diag_iter dsi = matrixFF->diag_begin();
+		for (Groups::const_iterator gi = groups.begin(); gi != groups.end(); ++gi) {
+			const_diag_iter di = (*gi).first;
+			while (di != (*gi).second) {
+				const_diag_iter de = panelEnd(di, (*gi).second);
+				solviipPanel(alpha, betas, di, de, dsi, d, eig_min);
+				for (; di != de; ++di, ++dsi)
+					;
+			}
+		}
 	} else {
+		int jend = d.getM();
 		const_diag_iter di = matrixF->diag_begin();
 		const_diag_iter dsi = matrixFF->diag_begin();
 		for (; di != matrixF->diag_end(); ++di, ++dsi) {
+			KronVector y1(d.getM(), d.getN(), d.getDepth()-1);
+			KronVector y2(d.getM(), d.getN(), d.getDepth()-1);
 			if ((*di).isReal()) {
-				solviipRealAndEliminate(alpha, betas, di, dsi, d, eig_min);
+				solviipRealAndEliminate(alpha, betas, di, dsi, d, eig_min,
+										y1, y2, jend);
 			} else {
-				solviipComplexAndEliminate(alpha, betas, di, dsi, d, eig_min);
+				KronVector y11(d.getM(), d.getN(), d.getDepth()-1);
+				KronVector y22(d.getM(), d.getN(), d.getDepth()-1);
+				solviipComplexAndEliminate(alpha, betas, di, dsi, d, eig_min,
+										   y1, y11, y2, y22, jend);
 			}
 		}
 	}
@@ -120,7 +433,8 @@ void TriangularSylvester::solviip(double alpha, double betas,
 
 
 void TriangularSylvester::solviRealAndEliminate(double r, const_diag_iter di,
-												KronVector& d, double& eig_min) const
+												KronVector& d, double& eig_min,
+												KronVector& y, int jend) const
 {
 	// di is real
 	int jbar = (*di).getIndex();
@@ -131,18 +445,19 @@ void TriangularSylvester::solviRealAndEliminate(double r, const_diag_iter di,
 		solvi(r*f, dj, eig_min);
 	}
 	// calculate y
-	KronVector y((const KronVector&)dj);
+	y = (const KronVector&)dj;
 	KronUtils::multKron(*matrixF, *matrixK, y);
 	y.mult(r);
 	double divisor = 1.0;
-	solviEliminateReal(di, d, y, divisor);
+	solviEliminateReal(di, d, y, divisor, jend);
 }
 
 void TriangularSylvester::solviEliminateReal(const_diag_iter di, KronVector& d,
-											 const KronVector& y, double divisor) const
+											 const KronVector& y, double divisor,
+											 int jend) const
 {
 	for (const_row_iter ri = matrixF->row_begin(*di);
-		 ri != matrixF->row_end(*di);
+		 ri != matrixF->row_end(*di) && ri.getCol() < jend;
 		 ++ri) {
 		KronVector dk(d, ri.getCol());
 		dk.add(-(*ri)/divisor, y);
@@ -150,7 +465,9 @@ void TriangularSylvester::solviEliminateReal(const_diag_iter di, KronVector& d,
 }
 
 void TriangularSylvester::solviComplexAndEliminate(double r, const_diag_iter di,
-												   KronVector& d, double& eig_min) const
+												   KronVector& d, double& eig_min,
+												   KronVector& y1, KronVector& y2,
+												   int jend) const
 {
 	// di is complex
 	int jbar = (*di).getIndex();
@@ -165,22 +482,22 @@ void TriangularSylvester::solviComplexAndEliminate(double r, const_diag_iter di,
 	if (r*r*aspbs > diag_zero_sq) { 
 		solvii(r*alpha, r*beta1, r*beta2, dj, djj, eig_min);
 	}
-	KronVector y1(dj);
-	KronVector y2(djj);
+	y1 = (const KronVector&)dj;
+	y2 = (const KronVector&)djj;
 	KronUtils::multKron(*matrixF, *matrixK, y1);
 	KronUtils::multKron(*matrixF, *matrixK, y2);
 	y1.mult(r);
 	y2.mult(r);
 	double divisor = 1.0;
-	solviEliminateComplex(di, d, y1, y2, divisor);
+	solviEliminateComplex(di, d, y1, y2, divisor, jend);
 }
 
 void TriangularSylvester::solviEliminateComplex(const_diag_iter di, KronVector& d,
 												const KronVector& y1, const KronVector& y2,
-												double divisor) const
+												double divisor, int jend) const
 {
 	for (const_row_iter ri = matrixF->row_begin(*di);
-		 ri != matrixF->row_end(*di);
+		 ri != matrixF->row_end(*di) && ri.getCol() < jend;
 		 ++ri) {
 		KronVector dk(d, ri.getCol());
 		dk.add(-ri.a()/divisor, y1);
@@ -190,7 +507,9 @@ void TriangularSylvester::solviEliminateComplex(const_diag_iter di, KronVector&
 
 void TriangularSylvester::solviipRealAndEliminate(double alpha, double betas,
 												  const_diag_iter di, const_diag_iter dsi,
-												  KronVector& d, double& eig_min) const
+												  KronVector& d, double& eig_min,
+												  KronVector& y1, KronVector& y2,
+												  int jend) const
 {
 	// di, and dsi are real		
 	int jbar = (*di).getIndex();
@@ -203,25 +522,26 @@ void TriangularSylvester::solviipRealAndEliminate(double alpha, double betas,
 	if (fs*aspbs > diag_zero_sq) {
 		solviip(f*alpha, fs*betas, dj, eig_min);
 	}
-	KronVector y1((const KronVector&)dj);
-	KronVector y2((const KronVector&)dj);
+	y1 = (const KronVector&)dj;
+	y2 = (const KronVector&)dj;
 	KronUtils::multKron(*matrixF, *matrixK, y1);
 	y1.mult(2*alpha);
 	KronUtils::multKron(*matrixFF, *matrixKK, y2);
 	y2.mult(aspbs);
 	double divisor = 1.0;
 	double divisor2 = 1.0;
-	solviipEliminateReal(di, dsi, d, y1, y2, divisor, divisor2);
+	solviipEliminateReal(di, dsi, d, y1, y2, divisor, divisor2, jend);
 }
 
 void TriangularSylvester::solviipEliminateReal(const_diag_iter di, const_diag_iter dsi,
 											   KronVector& d,
 											   const KronVector& y1, const KronVector& y2,
-											   double divisor, double divisor2) const
+											   double divisor, double divisor2,
+											   int jend) const
 {
 	const_row_iter ri = matrixF->row_begin(*di);
 	const_row_iter rsi = matrixFF->row_begin(*dsi);
-	for (; ri != matrixF->row_end(*di); ++ri, ++rsi) {
+	for (; ri != matrixF->row_end(*di) && ri.getCol() < jend; ++ri, ++rsi) {
 		KronVector dk(d, ri.getCol());
 		dk.add(-(*ri)/divisor, y1);
 		dk.add(-(*rsi)/divisor2, y2);
@@ -230,7 +550,10 @@ void TriangularSylvester::solviipEliminateReal(const_diag_iter di, const_diag_it
 
 void TriangularSylvester::solviipComplexAndEliminate(double alpha, double betas,
 													 const_diag_iter di, const_diag_iter dsi,
-													 KronVector& d, double& eig_min) const
+													 KronVector& d, double& eig_min,
+													 KronVector& y1, KronVector& y11,
+													 KronVector& y2, KronVector& y22,
+													 int jend) const
 {
 	// di, and dsi are complex
 	int jbar = (*di).getIndex();
@@ -247,24 +570,24 @@ void TriangularSylvester::solviipComplexAndEliminate(double alpha, double betas,
 	}
 	// here dj, djj is solution, set y1, y2, y11, y22
 	// y1
-	KronVector y1((const KronVector&) dj);
+	y1 = (const KronVector&) dj;
 	KronUtils::multKron(*matrixF, *matrixK, y1);
 	y1.mult(2*alpha);
 	// y11
-	KronVector y11((const KronVector&) djj);
+	y11 = (const KronVector&) djj;
 	KronUtils::multKron(*matrixF, *matrixK, y11);
 	y11.mult(2*alpha);
 	// y2
-	KronVector y2((const KronVector&) dj);
+	y2 = (const KronVector&) dj;
 	KronUtils::multKron(*matrixFF, *matrixKK, y2);
 	y2.mult(aspbs);
 	// y22
-	KronVector y22((const KronVector&) djj);
+	y22 = (const KronVector&) djj;
 	KronUtils::multKron(*matrixFF, *matrixKK, y22);
 	y22.mult(aspbs);
 
 	double divisor = 1.0;
-	solviipEliminateComplex(di, dsi, d, y1, y11, y2, y22, divisor);
+	solviipEliminateComplex(di, dsi, d, y1, y11, y2, y22, divisor, jend);
 }
 
 
@@ -293,11 +616,11 @@ void TriangularSylvester::solviipEliminateComplex(const_diag_iter di, const_diag
 												  KronVector& d,
 												  const KronVector& y1, const KronVector& y11,
 												  const KronVector& y2, const KronVector& y22,
-												  double divisor) const
+												  double divisor, int jend) const
 {
 	const_row_iter ri = matrixF->row_begin(*di);
 	const_row_iter rsi = matrixFF->row_begin(*dsi);
-	for (; ri != matrixF->row_end(*di); ++ri, ++rsi) {
+	for (; ri != matrixF->row_end(*di) && ri.getCol() < jend; ++ri, ++rsi) {
 		KronVector dk(d, ri.getCol());
 		dk.add(-ri.a()/divisor, y1);
 		dk.add(-ri.b()/divisor, y11);
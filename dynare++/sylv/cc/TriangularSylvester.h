@@ -11,18 +11,42 @@
 #include "QuasiTriangularZero.h"
 #include "SimilarityDecomp.h"
 
+#include <vector>
+#include <utility>
+
+/* If block_size is positive, the diagonal blocks of F are solved in
+ * panels of about block_size columns. Within a panel, the right hand
+ * side is eliminated block by block, the rest of it is updated at once
+ * by a matrix multiplication. Groups of diagonal blocks of F which are
+ * not coupled by F (the diagonal blocks of a block diagonal F) are
+ * independent; at the top level, they are solved by num_threads
+ * threads. */
 class TriangularSylvester : public SylvesterSolver {
 	const QuasiTriangular* const matrixKK;
 	const QuasiTriangular* const matrixFF;
+	const int block_size;
+	const int num_threads;
 public:
-	TriangularSylvester(const QuasiTriangular& k, const QuasiTriangular& f);
-	TriangularSylvester(const SchurDecompZero& kdecomp, const SchurDecomp& fdecomp);
-	TriangularSylvester(const SchurDecompZero& kdecomp, const SimilarityDecomp& fdecomp);
+	/* auxiliary typedefs */
+	typedef QuasiTriangular::const_diag_iter const_diag_iter;
+	typedef QuasiTriangular::const_row_iter const_row_iter;
+	typedef vector<pair<const_diag_iter, const_diag_iter> > Groups;
+
+	TriangularSylvester(const QuasiTriangular& k, const QuasiTriangular& f,
+						int bs = 0, int nt = 1);
+	TriangularSylvester(const SchurDecompZero& kdecomp, const SchurDecomp& fdecomp,
+						int bs = 0, int nt = 1);
+	TriangularSylvester(const SchurDecompZero& kdecomp, const SimilarityDecomp& fdecomp,
+						int bs = 0, int nt = 1);
 	virtual ~TriangularSylvester();
 	void print() const;
 	void solve(SylvParams& pars, KronVector& d) const;
 
 	void solvi(double r, KronVector& d, double& eig_min) const;
+	/* solves diagonal blocks [dbeg, dend) of F, which must be a group
+	   not coupled with the other blocks, see getGroups() */
+	void solviGroup(double r, const_diag_iter dbeg, const_diag_iter dend,
+					KronVector& d, double& eig_min) const;
 	void solvii(double alpha, double beta1, double beta2,
 				KronVector& d1, KronVector& d2,
 				double& eig_min) const;
@@ -62,41 +86,65 @@ public:
 		{quaEval(alpha, betas, gamma, delta1, delta2, x1, x2,
 				 ConstKronVector(d1), ConstKronVector(d2));}
 private:
+	/* groups of diagonal blocks of F not coupled by F */
+	Groups groups;
+	/* solves the groups in parallel, called from solve */
+	void solveGroups(KronVector& d, double& eig_min) const;
 	/* returns square of size of minimal eigenvalue of the system solved,
 	   now obsolete */ 
 	double getEigSep(int depth) const;
 	/* recursivelly calculates kronecker product of complex vectors (used in getEigSep) */
 	static void multEigVector(KronVector& eig, const Vector& feig, const Vector& keig);
-	/* auxiliary typedefs */
-	typedef QuasiTriangular::const_diag_iter const_diag_iter;
-	typedef QuasiTriangular::const_row_iter const_row_iter;
+	/* splits the diagonal blocks of F to groups not coupled by F */
+	void getGroups(Groups& groups) const;
+	/* returns the end of a panel starting at di and not crossing dend */
+	const_diag_iter panelEnd(const_diag_iter di, const_diag_iter dend) const;
+	/* returns the column after the last nonzero of F in rows [di, dend) */
+	int panelRowEnd(const_diag_iter di, const_diag_iter dend) const;
+	/* called from solviGroup, the panel versions eliminate only columns
+	   below jend and store y's to the columns of a matrix */
+	void solviPanel(double r, const_diag_iter dbeg, const_diag_iter dend,
+					KronVector& d, double& eig_min) const;
+	void solviipPanel(double alpha, double betas,
+					  const_diag_iter dbeg, const_diag_iter dend,
+					  const_diag_iter dsbeg,
+					  KronVector& d, double& eig_min) const;
 	/* called from solvi */
 	void solviRealAndEliminate(double r, const_diag_iter di,
-							   KronVector& d, double& eig_min) const;
+							   KronVector& d, double& eig_min,
+							   KronVector& y, int jend) const;
 	void solviComplexAndEliminate(double r, const_diag_iter di,
-								  KronVector& d, double& eig_min) const;
+								  KronVector& d, double& eig_min,
+								  KronVector& y1, KronVector& y2,
+								  int jend) const;
 	/* called from solviip */
 	void solviipRealAndEliminate(double alpha, double betas,
 								 const_diag_iter di, const_diag_iter dsi,
-								 KronVector& d, double& eig_min) const;
+								 KronVector& d, double& eig_min,
+								 KronVector& y1, KronVector& y2,
+								 int jend) const;
 	void solviipComplexAndEliminate(double alpha, double betas,
 									const_diag_iter di, const_diag_iter dsi,
-									KronVector& d, double& eig_min) const;
-	/* eliminations */
+									KronVector& d, double& eig_min,
+									KronVector& y1, KronVector& y11,
+									KronVector& y2, KronVector& y22,
+									int jend) const;
+	/* eliminations of columns below jend */
 	void solviEliminateReal(const_diag_iter di, KronVector& d,
-							const KronVector& y, double divisor) const;
+							const KronVector& y, double divisor,
+							int jend) const;
 	void solviEliminateComplex(const_diag_iter di, KronVector& d,
 							   const KronVector& y1, const KronVector& y2,
-							   double divisor) const;
+							   double divisor, int jend) const;
 	void solviipEliminateReal(const_diag_iter di, const_diag_iter dsi,
 							  KronVector& d,
 							  const KronVector& y1, const KronVector& y2,
-							  double divisor, double divisor2) const;
+							  double divisor, double divisor2, int jend) const;
 	void solviipEliminateComplex(const_diag_iter di, const_diag_iter dsi,
 								 KronVector& d,
 								 const KronVector& y1, const KronVector& y11,
 								 const KronVector& y2, const KronVector& y22,
-								 double divisor) const;
+								 double divisor, int jend) const;
 	/* Lemma 2 */
 	void solviipComplex(double alpha, double betas, double gamma,
 						double delta1, double delta2,
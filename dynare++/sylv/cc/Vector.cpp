@@ -18,13 +18,13 @@ using namespace std;
 ZeroPad zero_pad;
 
 Vector::Vector(const Vector& v)
-	: len(v.length()), s(1), data(new double[len]), destroy(true)
+	: len(v.length()), s(1), data(SylvMemoryPool::allocate(len)), destroy(true)
 {
 	copy(v.base(), v.skip());
 }
 
 Vector::Vector(const ConstVector& v)
-	: len(v.length()), s(1), data(new double[len]), destroy(true)
+	: len(v.length()), s(1), data(SylvMemoryPool::allocate(len)), destroy(true)
 {
 	copy(v.base(), v.skip());
 }
@@ -79,7 +79,7 @@ Vector::Vector(Vector& v, int off, int l)
 }
 
 Vector::Vector(const Vector& v, int off, int l)
-	: len(l), s(1), data(new double[len]), destroy(true)
+	: len(l), s(1), data(SylvMemoryPool::allocate(len)), destroy(true)
 {
 	if (off < 0 || off + length() > v.length())
 		throw SYLV_MES_EXCEPTION("Subvector not contained in supvector.");
@@ -156,7 +156,7 @@ void Vector::infs()
 Vector::~Vector()
 {
 	if (destroy) {
-		delete [] data;
+		SylvMemoryPool::release(data);
 	}
 }
 
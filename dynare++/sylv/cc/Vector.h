@@ -9,6 +9,8 @@
  * to avoid running virtual method invokation mechanism. Some
  * members, and methods are thus duplicated */ 
 
+#include "SylvMemory.h"
+
 #include <cstdio>
 
 class GeneralMatrix;
@@ -22,12 +24,12 @@ protected:
 	bool destroy;
 public:
 	Vector() : len(0), s(1), data(0), destroy(false) {}
-	Vector(int l) : len(l), s(1), data(new double[l]), destroy(true) {}
+	Vector(int l) : len(l), s(1), data(SylvMemoryPool::allocate(l)), destroy(true) {}
 	Vector(Vector& v) : len(v.length()), s(v.skip()), data(v.base()), destroy(false) {}
 	Vector(const Vector& v);
 	Vector(const ConstVector& v);
 	Vector(const double* d, int l)
-		: len(l), s(1), data(new double[len]), destroy(true)
+		: len(l), s(1), data(SylvMemoryPool::allocate(l)), destroy(true)
 		{copy(d, 1);}
 	Vector(double* d, int l)
 		: len(l), s(1), data(d), destroy(false) {}
@@ -22,10 +22,12 @@
 %       returned by the check. This is a list of the struct
 %       members, some of them may be missing in actual returned
 %       value:
-%       method     = method used for solution recursive/iterative
+%       method     = method used for solution recursive/iterative/blocked
 %       convergence_tol = convergence tolerance for iter. method
 %       max_num_iter    = max number of steps for iter. method
 %       bs_norm    = Bavely Stewart log10 norm for diagonalization
+%       block_size = number of columns of F in a block for blocked method
+%       num_threads = number of threads for blocked method
 %       converged  = convergence status for iterative method
 %       iter_last_norm  = residual norm of the last step of iterations
 %       num_iter   = number of iterations performed
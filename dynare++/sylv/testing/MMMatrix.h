@@ -6,13 +6,12 @@
 #define MM_MATRIX_H
 
 #include "GeneralMatrix.h"
-#include "SylvMemory.h"
 
 #include <string>
 
 using namespace std;
 
-class MMException : public MallocAllocator {
+class MMException {
 	string message;
 public:
 	MMException(string mes) : message(mes) {}
@@ -20,7 +19,7 @@ public:
 	const char* getMessage() const {return message.data();}
 };
 
-class MMMatrixIn : public MallocAllocator {
+class MMMatrixIn {
 	double* data;
 	int rows;
 	int cols;
@@ -33,7 +32,7 @@ public:
 	int col() const {return cols;}
 };
 
-class MMMatrixOut : public MallocAllocator {
+class MMMatrixOut {
 public:
 	static void write(const char* fname, int rows, int cols, const double* data);
 	static void write(const char* fname, const GeneralMatrix& m);
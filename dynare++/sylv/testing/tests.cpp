@@ -21,10 +21,11 @@
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <sys/time.h>
 
 #include <cmath>
 
-class TestRunnable : public MallocAllocator {
+class TestRunnable {
 	char name[100];
 	static double eps_norm;
 public:
@@ -49,9 +50,13 @@ protected:
 						 double alpha, double betas, double gamma,
 						 double delta1, double delta2);
 	static bool tri_sylv(const char* m1name, const char* m2name, const char* vname,
-						 int m, int n, int depth);
+						 int m, int n, int depth, int block_size = 0);
 	static bool gen_sylv(const char* aname, const char* bname, const char* cname,
-						 const char* dname, int m, int n, int order);
+						 const char* dname, int m, int n, int order,
+						 SylvParams::solve_method method = SylvParams::recurse,
+						 int num_threads = 1);
+	static bool gen_sylv_bench(const char* aname, const char* bname, const char* cname,
+							   const char* dname, int m, int n, int order);
 	static bool eig_bubble(const char* aname, int from, int to);
 	static bool block_diag(const char* aname, double log10norm = 3.0);
 	static bool iter_sylv(const char* m1name, const char* m2name, const char* vname,
@@ -86,7 +91,7 @@ bool TestRunnable::quasi_solve(bool trans, const char* mname, const char* vname)
 	MMMatrixIn mmt(mname);
 	MMMatrixIn mmv(vname);
 
-	SylvMemoryDriver memdriver(1, mmt.row(), mmt.row(), 1);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular* t;
 	QuasiTriangular* tsave;
 	if (mmt.row()==mmt.col()) {
@@ -136,7 +141,7 @@ bool TestRunnable::mult_kron(bool trans, const char* mname, const char* vname,
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(1, m, n, depth);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t(mmt.getData(), mmt.row());
 	Vector vraw(mmv.getData(), mmv.row());
 	KronVector v(vraw, m, n, depth);
@@ -168,7 +173,7 @@ bool TestRunnable::level_kron(bool trans, const char* mname, const char* vname,
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(1, m, n, depth);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t(mmt.getData(), mmt.row());
 	Vector vraw(mmv.getData(), mmv.row());
 	ConstKronVector v(vraw, m, n, depth);
@@ -202,7 +207,7 @@ bool TestRunnable::kron_power(const char* m1name, const char* m2name, const char
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(2, m, n, depth);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t1(mmt1.getData(), mmt1.row());
 	QuasiTriangular t2(mmt2.getData(), mmt2.row());
 	Vector vraw(mmv.getData(), mmv.row());
@@ -210,9 +215,7 @@ bool TestRunnable::kron_power(const char* m1name, const char* m2name, const char
 	Vector craw(mmc.getData(), mmc.row());
 	KronVector c(craw, m, n, depth);
 	KronVector x(v);
-	memdriver.setStackMode(true);
 	KronUtils::multKron(t1, t2, x);
-	memdriver.setStackMode(false);
 	x.add(-1, c);
 	double norm = x.getNorm();
 	printf("\terror norm = %8.4g\n",norm);
@@ -237,7 +240,7 @@ bool TestRunnable::lin_eval(const char* m1name, const char* m2name, const char*
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(1, m, n, depth);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t1(mmt1.getData(), mmt1.row());
 	QuasiTriangular t2(mmt2.getData(), mmt2.row());
 	TriangularSylvester ts(t2, t1);
@@ -251,9 +254,7 @@ bool TestRunnable::lin_eval(const char* m1name, const char* m2name, const char*
 	KronVector c2(craw2, m, n, depth);
 	KronVector x1(m, n, depth);
 	KronVector x2(m, n, depth);
-	memdriver.setStackMode(true);
 	ts.linEval(alpha, beta1, beta2, x1, x2, v1, v2);
-	memdriver.setStackMode(false);
 	x1.add(-1, c1);
 	x2.add(-1, c2);
 	double norm1 = x1.getNorm();
@@ -282,7 +283,7 @@ bool TestRunnable::qua_eval(const char* m1name, const char* m2name, const char*
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(3, m, n, depth);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t1(mmt1.getData(), mmt1.row());
 	QuasiTriangular t2(mmt2.getData(), mmt2.row());
 	TriangularSylvester ts(t2, t1);
@@ -296,9 +297,7 @@ bool TestRunnable::qua_eval(const char* m1name, const char* m2name, const char*
 	KronVector c2(craw2, m, n, depth);
 	KronVector x1(m, n, depth);
 	KronVector x2(m, n, depth);
-	memdriver.setStackMode(true);
 	ts.quaEval(alpha, betas, gamma, delta1, delta2, x1, x2, v1, v2);
-	memdriver.setStackMode(false);
 	x1.add(-1, c1);
 	x2.add(-1, c2);
 	double norm1 = x1.getNorm();
@@ -308,7 +307,7 @@ bool TestRunnable::qua_eval(const char* m1name, const char* m2name, const char*
 }
 
 bool TestRunnable::tri_sylv(const char* m1name, const char* m2name, const char* vname,
-							int m, int n, int depth)
+							int m, int n, int depth, int block_size)
 {
 	MMMatrixIn mmt1(m1name);
 	MMMatrixIn mmt2(m2name);
@@ -322,11 +321,10 @@ bool TestRunnable::tri_sylv(const char* m1name, const char* m2name, const char*
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(4, m, n, depth); // need extra 2 for checks done via KronUtils::multKron
-	memdriver.setStackMode(true);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t1(mmt1.getData(), mmt1.row());
 	QuasiTriangular t2(mmt2.getData(), mmt2.row());
-	TriangularSylvester ts(t2, t1);
+	TriangularSylvester ts(t2, t1, block_size);
 	Vector vraw(mmv.getData(), length);
 	ConstKronVector v(vraw, m, n, depth);
 	KronVector d(v); // copy of v
@@ -343,12 +341,12 @@ bool TestRunnable::tri_sylv(const char* m1name, const char* m2name, const char*
 	double max = dcheck.getMax();
 	double xmax = v.getMax();
 	printf("\trel. error max = %8.4g\n", max/xmax);
-	memdriver.setStackMode(false);
 	return (norm < xnorm*eps_norm);
 }
 
 bool TestRunnable::gen_sylv(const char* aname, const char* bname, const char* cname,
-							const char* dname, int m, int n, int order)
+							const char* dname, int m, int n, int order,
+							SylvParams::solve_method method, int num_threads)
 {
 	MMMatrixIn mma(aname);
 	MMMatrixIn mmb(bname);
@@ -364,6 +362,8 @@ bool TestRunnable::gen_sylv(const char* aname, const char* bname, const char* cn
 	}
 
 	SylvParams ps(true);
+	ps.method = method;
+	ps.num_threads = num_threads;
 	GeneralSylvester gs(order, n, m, n-mmb.col(),
 						mma.getData(), mmb.getData(),
 						mmc.getData(), mmd.getData(),
@@ -377,6 +377,66 @@ bool TestRunnable::gen_sylv(const char* aname, const char* bname, const char* cn
 			*(pars.vec_errI) < eps_norm);
 }
 
+/* Solves the same system by the iterative, recursive and blocked
+ * methods, the latter with one and more threads, and prints the CPU
+ * and wall clock times. Passes if all solutions are accurate and agree
+ * with the recursive one. */
+bool TestRunnable::gen_sylv_bench(const char* aname, const char* bname, const char* cname,
+								  const char* dname, int m, int n, int order)
+{
+	MMMatrixIn mma(aname);
+	MMMatrixIn mmb(bname);
+	MMMatrixIn mmc(cname);
+	MMMatrixIn mmd(dname);
+
+	if (m != mmc.row() || m != mmc.col() ||
+		n != mma.row() || n != mma.col() ||
+		n != mmb.row() || n <  mmb.col() ||
+		n != mmd.row() || power(m, order) != mmd.col()) {
+		printf("  Incompatible sizes for gen_sylv_bench.\n");
+		return false;
+	}
+
+	const int num = 4;
+	const char* names[num] = {"iterative", "recursive", "blocked", "blocked"};
+	SylvParams::solve_method methods[num] = {SylvParams::iter, SylvParams::recurse,
+											 SylvParams::blocked, SylvParams::blocked};
+	int threads[num] = {1, 1, 1, 4};
+	int length = n*power(m, order);
+	Vector xrec(length);
+	bool passed = true;
+	for (int i = 0; i < num; i++) {
+		SylvParams ps(true);
+		ps.method = methods[i];
+		ps.num_threads = threads[i];
+		GeneralSylvester gs(order, n, m, n-mmb.col(),
+							mma.getData(), mmb.getData(),
+							mmc.getData(), mmd.getData(),
+							ps);
+		struct timeval start, end;
+		gettimeofday(&start, NULL);
+		gs.solve();
+		gettimeofday(&end, NULL);
+		gs.check(mmd.getData());
+		const SylvParams& pars = gs.getParams();
+		ConstVector x(gs.getResult(), length);
+		if (methods[i] == SylvParams::recurse)
+			xrec = x;
+		double diff = 0.0;
+		if (methods[i] == SylvParams::blocked) {
+			Vector xdiff(x);
+			xdiff.add(-1.0, xrec);
+			diff = xdiff.getMax()/xrec.getMax();
+		}
+		printf("\t%-10s threads=%d  CPU time %8.4g  wall time %8.4g  rel. error %8.4g  diff %8.4g\n",
+			   names[i], threads[i], *(pars.cpu_time),
+			   (end.tv_sec-start.tv_sec) + 1.e-6*(end.tv_usec-start.tv_usec),
+			   *(pars.mat_errF), diff);
+		passed = passed && *(pars.mat_errF) < eps_norm && diff < eps_norm;
+	}
+	return passed;
+}
+
 bool TestRunnable::eig_bubble(const char* aname, int from, int to)
 {
 	MMMatrixIn mma(aname);
@@ -387,7 +447,7 @@ bool TestRunnable::eig_bubble(const char* aname, int from, int to)
 	}
 
 	int n = mma.row();
-	SylvMemoryDriver memdriver(3, n, n, 2);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular orig(mma.getData(), n);
 	SchurDecompEig dec((const QuasiTriangular&)orig);
 	QuasiTriangular::diag_iter itf = dec.getT().diag_begin();
@@ -421,7 +481,7 @@ bool TestRunnable::block_diag(const char* aname, double log10norm)
 	}
 
 	int n = mma.row();
-	SylvMemoryDriver memdriver(3, n, n, 2);
+	SylvMemoryDriver memdriver;
 	SqSylvMatrix orig(mma.getData(), n);
 	SimilarityDecomp dec(orig.base(), orig.numRows(), log10norm);
 	dec.getB().printInfo();
@@ -464,8 +524,7 @@ bool TestRunnable::iter_sylv(const char* m1name, const char* m2name, const char*
 		return false;
 	}
 
-	SylvMemoryDriver memdriver(4, m, n, depth); // need extra 2 for checks done via KronUtils::multKron
-	memdriver.setStackMode(true);
+	SylvMemoryDriver memdriver;
 	QuasiTriangular t1(mmt1.getData(), mmt1.row());
 	QuasiTriangular t2(mmt2.getData(), mmt2.row());
 	IterativeSylvester is(t2, t1);
@@ -486,7 +545,6 @@ bool TestRunnable::iter_sylv(const char* m1name, const char* m2name, const char*
 	double max = dcheck.getMax();
 	double xmax = v.getMax();
 	printf("\trel. error max = %8.4g\n", max/xmax);
-	memdriver.setStackMode(false);
 	return (cnorm < xnorm*eps_norm);
 }
 
@@ -656,6 +714,18 @@ public:
 	bool run() const;
 };
 
+class TriSylvBlockedTest : public TestRunnable {
+public:
+	TriSylvBlockedTest() : TestRunnable("triangular sylvester blocked solve (48000=40x40x30)") {}
+	bool run() const;
+};
+
+class TriSylvLargeBlockedTest : public TestRunnable {
+public:
+	TriSylvLargeBlockedTest() : TestRunnable("triangular sylvester large blocked solve (1920000=40x40x40x30)") {}
+	bool run() const;
+};
+
 class IterSylvTest : public TestRunnable {
 public:
 	IterSylvTest() : TestRunnable("iterative sylvester solve (245=7x7x5)") {}
@@ -692,6 +762,18 @@ public:
 	bool run() const;
 };
 
+class GenSylvLargeBlockedTest : public TestRunnable {
+public:
+	GenSylvLargeBlockedTest() : TestRunnable("general sylvester blocked threaded solve (2500000=50x50x50x20)") {}
+	bool run() const;
+};
+
+class GenSylvBenchTest : public TestRunnable {
+public:
+	GenSylvBenchTest() : TestRunnable("general sylvester methods benchmark (2500000=50x50x50x20)") {}
+	bool run() const;
+};
+
 class EigBubFrankTest : public TestRunnable {
 public:
 	EigBubFrankTest() : TestRunnable("eig. bubble frank test (12x12)") {}
@@ -879,6 +961,16 @@ bool TriSylvLargeTest::run() const
 	return tri_sylv("qt40x40.mm", "qt30x30eig011-095.mm", "v1920000.mm", 40, 30, 3);
 }
 
+bool TriSylvBlockedTest::run() const
+{
+	return tri_sylv("qt40x40.mm", "qt30x30eig011-095.mm", "v48000.mm", 40, 30, 2, 8);
+}
+
+bool TriSylvLargeBlockedTest::run() const
+{
+	return tri_sylv("qt40x40.mm", "qt30x30eig011-095.mm", "v1920000.mm", 40, 30, 3, 16);
+}
+
 bool IterSylvTest::run() const
 {
 	return iter_sylv("qt7x7eig06-09.mm", "qt5x5.mm", "v245r.mm", 7, 5, 2);
@@ -909,6 +1001,17 @@ bool GenSylvLargeTest::run() const
 	return gen_sylv("a20x20.mm", "b20x15.mm", "c50x50.mm", "d20x125000.mm", 50, 20, 3);
 }
 
+bool GenSylvLargeBlockedTest::run() const
+{
+	return gen_sylv("a20x20.mm", "b20x15.mm", "c50x50.mm", "d20x125000.mm", 50, 20, 3,
+					SylvParams::blocked, 4);
+}
+
+bool GenSylvBenchTest::run() const
+{
+	return gen_sylv_bench("a20x20.mm", "b20x15.mm", "c50x50.mm", "d20x125000.mm", 50, 20, 3);
+}
+
 bool EigBubFrankTest::run() const
 {
 	return eig_bubble("qt_frank12x12.mm", 8, 0);
@@ -987,12 +1090,16 @@ int main()
 	all_tests[num_tests++] = new TriSylvTest();
 	all_tests[num_tests++] = new TriSylvBigTest();
 	all_tests[num_tests++] = new TriSylvLargeTest();
+	all_tests[num_tests++] = new TriSylvBlockedTest();
+	all_tests[num_tests++] = new TriSylvLargeBlockedTest();
 	all_tests[num_tests++] = new IterSylvTest();
 	all_tests[num_tests++] = new IterSylvLargeTest();
 	all_tests[num_tests++] = new GenSylvSmallTest();
 	all_tests[num_tests++] = new GenSylvTest();
 	all_tests[num_tests++] = new GenSylvSingTest();
 	all_tests[num_tests++] = new GenSylvLargeTest();
+	all_tests[num_tests++] = new GenSylvLargeBlockedTest();
+	all_tests[num_tests++] = new GenSylvBenchTest();
 
 	// launch the tests
 	int success = 0;
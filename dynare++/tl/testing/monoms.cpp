@@ -386,6 +386,7 @@ FSSparseTensor* Monom4Vector::deriv(int dim) const
 			}
 		}
 	}
+	res->compress();
 
 	return res;
 }
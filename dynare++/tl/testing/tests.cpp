@@ -79,6 +79,15 @@ protected:
 
 	static bool poly_eval(int r, int nv, int maxdim);
 
+	static bool poly_eval_batch(int r, int nv, int maxdim, int npoints);
+
+	static bool poly_eval_powers(int r, int nv, int maxdim, int npoints);
+
+	static bool kron_prod_speed(int r, const IntSequence& rows, const IntSequence& cols,
+								int nrep);
+
+	static bool nested_groups(int nthreads, int nouter, int ninner);
+
 
 };
 
@@ -546,6 +555,213 @@ bool TestRunnable::poly_eval(int r, int nv, int maxdim)
 	delete x;
 	return (max_ft+max_fh+max_uh < 1.0e-10);
 }
+bool TestRunnable::poly_eval_batch(int r, int nv, int maxdim, int npoints)
+{
+	Factory fact;
+	Vector* xv = fact.makeVector(nv*npoints);
+	TwoDMatrix x(nv, npoints);
+	x.getData() = *xv;
+
+	FTensorPolynomial* fp = fact.makePoly<FFSTensor, FTensorPolynomial>(r, nv, maxdim);
+	UTensorPolynomial up(*fp);
+
+	TwoDMatrix out_fb(r, npoints);
+	clock_t fb_cl = clock();
+	fp->evalTrad(out_fb, x);
+	fb_cl = clock() - fb_cl;
+	printf("\ttime for folded batch eval:    %8.4g\n",
+		   ((double)fb_cl)/CLOCKS_PER_SEC);
+
+	TwoDMatrix out_ub(r, npoints);
+	clock_t ub_cl = clock();
+	up.evalTrad(out_ub, x);
+	ub_cl = clock() - ub_cl;
+	printf("\ttime for unfolded batch eval:  %8.4g\n",
+		   ((double)ub_cl)/CLOCKS_PER_SEC);
+
+	TwoDMatrix out_fh(r, npoints);
+	clock_t fh_cl = clock();
+	for (int j = 0; j < npoints; j++) {
+		Vector col(out_fh, j);
+		fp->evalHorner(col, ConstVector(x, j));
+	}
+	fh_cl = clock() - fh_cl;
+	printf("\ttime for folded horner evals:  %8.4g\n",
+		   ((double)fh_cl)/CLOCKS_PER_SEC);
+
+	out_fb.add(-1.0, out_fh);
+	double max_fb = out_fb.getData().getMax();
+	out_ub.add(-1.0, out_fh);
+	double max_ub = out_ub.getData().getMax();
+
+	printf("\tfolded batch error norm max:     %10.6g\n", max_fb);
+	printf("\tunfolded batch error norm max:   %10.6g\n", max_ub);
+
+	delete fp;
+	delete xv;
+	return (max_fb+max_ub < 1.0e-10);
+}
+
+bool TestRunnable::poly_eval_powers(int r, int nv, int maxdim, int npoints)
+{
+	Factory fact;
+	Vector* xv = fact.makeVector(nv*npoints);
+	TwoDMatrix x(nv, npoints);
+	x.getData() = *xv;
+
+	FTensorPolynomial* fp1 = fact.makePoly<FFSTensor, FTensorPolynomial>(r, nv, maxdim-1);
+	FTensorPolynomial* fp2 = fact.makePoly<FFSTensor, FTensorPolynomial>(r, nv, maxdim);
+
+	TwoDMatrix out_p1(r, npoints);
+	TwoDMatrix out_p2(r, npoints);
+	clock_t p_cl = clock();
+	for (int j = 0; j < npoints; j++) {
+		FPowerContainer pows(ConstVector(x, j));
+		Vector col1(out_p1, j);
+		fp1->evalTrad(col1, pows);
+		Vector col2(out_p2, j);
+		fp2->evalTrad(col2, pows);
+	}
+	p_cl = clock() - p_cl;
+	printf("\ttime for shared powers evals:  %8.4g\n",
+		   ((double)p_cl)/CLOCKS_PER_SEC);
+
+	TwoDMatrix out_h1(r, npoints);
+	TwoDMatrix out_h2(r, npoints);
+	clock_t h_cl = clock();
+	for (int j = 0; j < npoints; j++) {
+		Vector col1(out_h1, j);
+		fp1->evalHorner(col1, ConstVector(x, j));
+		Vector col2(out_h2, j);
+		fp2->evalHorner(col2, ConstVector(x, j));
+	}
+	h_cl = clock() - h_cl;
+	printf("\ttime for folded horner evals:  %8.4g\n",
+		   ((double)h_cl)/CLOCKS_PER_SEC);
+
+	out_p1.add(-1.0, out_h1);
+	double max_p1 = out_p1.getData().getMax();
+	out_p2.add(-1.0, out_h2);
+	double max_p2 = out_p2.getData().getMax();
+
+	printf("\tshared powers error norm max:   %10.6g\n", max_p1+max_p2);
+
+	delete fp2;
+	delete fp1;
+	delete xv;
+	return (max_p1+max_p2 < 1.0e-10);
+}
+
+/* this multiplies a random matrix by a Kronecker product of random
+ * matrices given by their rows and cols nrep times and reports the
+ * speed; the result is checked against the product with the explicitly
+ * formed Kronecker product */
+bool TestRunnable::kron_prod_speed(int r, const IntSequence& rows, const IntSequence& cols,
+								   int nrep)
+{
+	Factory fact;
+	int dim = rows.size();
+	KronProdAll kp(dim);
+	vector<TwoDMatrix*> mats;
+	for (int i = 0; i < dim; i++) {
+		Vector* d = fact.makeVector(rows[i]*cols[i]);
+		TwoDMatrix* m = new TwoDMatrix(rows[i], cols[i]);
+		m->getData() = *d;
+		delete d;
+		mats.push_back(m);
+		kp.setMat(i, *m);
+	}
+	Vector* d = fact.makeVector(r*rows.mult());
+	TwoDMatrix in(r, rows.mult());
+	in.getData() = *d;
+	delete d;
+
+	// flops of B(A_1\otimes I)...(I\otimes A_n)
+	double flops = 0;
+	for (int i = 0; i < dim; i++)
+		flops += 2.0*r*cols.mult(0, i)*rows[i]*cols[i]*rows.mult(i+1, dim);
+
+	TwoDMatrix out(r, cols.mult());
+	clock_t kp_cl = clock();
+	for (int i = 0; i < nrep; i++)
+		kp.mult(in, out);
+	kp_cl = clock() - kp_cl;
+	double secs = ((double)kp_cl)/CLOCKS_PER_SEC;
+	printf("\ttime for %d Kronecker mults:  %8.4g\n", nrep, secs);
+	if (secs > 0)
+		printf("\tspeed in GFLOP/s:             %8.4g\n", nrep*flops/secs/1.0e9);
+
+	TwoDMatrix* kron = new TwoDMatrix(*(mats[0]));
+	for (int i = 1; i < dim; i++) {
+		TwoDMatrix* newkron = new TwoDMatrix(kron->nrows()*rows[i], kron->ncols()*cols[i]);
+		for (int j = 0; j < kron->ncols(); j++)
+			for (int k = 0; k < cols[i]; k++)
+				for (int l = 0; l < kron->nrows(); l++)
+					for (int m = 0; m < rows[i]; m++)
+						newkron->get(l*rows[i]+m, j*cols[i]+k) = kron->get(l, j)*mats[i]->get(m, k);
+		delete kron;
+		kron = newkron;
+	}
+	TwoDMatrix check(r, cols.mult());
+	check.mult(in, *kron);
+	delete kron;
+	check.add(-1.0, out);
+	double max = check.getData().getMax();
+	printf("\terror norm max:               %10.6g\n", max);
+
+	for (int i = 0; i < dim; i++)
+		delete mats[i];
+	return max < 1.0e-10;
+}
+
+/* workers of nested_groups: each outer worker runs a group of inner
+ * workers adding their number to the sum */
+class InnerSumWorker : public THREAD {
+	long& sum;
+	int k;
+public:
+	InnerSumWorker(long& s, int kk)
+		: sum(s), k(kk) {}
+	void operator()()
+		{
+			SYNCHRO syn(&sum, "InnerSumWorker");
+			sum += k;
+		}
+};
+
+class OuterSumWorker : public THREAD {
+	long& sum;
+	int ninner;
+public:
+	OuterSumWorker(long& s, int n)
+		: sum(s), ninner(n) {}
+	void operator()()
+		{
+			THREAD_GROUP gr;
+			for (int k = 0; k < ninner; k++)
+				gr.insert(new InnerSumWorker(sum, k));
+			gr.run();
+		}
+};
+
+bool TestRunnable::nested_groups(int nthreads, int nouter, int ninner)
+{
+	int save_threads = THREAD_GROUP::max_parallel_threads;
+	THREAD_GROUP::max_parallel_threads = nthreads;
+	long sum = 0;
+	{
+		THREAD_GROUP gr;
+		for (int i = 0; i < nouter; i++)
+			gr.insert(new OuterSumWorker(sum, ninner));
+		gr.run();
+	}
+	THREAD_GROUP::max_parallel_threads = save_threads;
+
+	long expected = (long)nouter*ninner*(ninner-1)/2;
+	printf("\tsum of nested groups:       %ld\n", sum);
+	printf("\texpected sum:               %ld\n", expected);
+	return sum == expected;
+}
 
 
 /****************************************************/
@@ -894,6 +1110,50 @@ public:
 		}
 };
 
+class PolyEvalBatch : public TestRunnable {
+public:
+	PolyEvalBatch()
+		: TestRunnable("polynomial batch evaluation (r=30, nv=20, maxdim=3, points=500)", 3, 20) {}
+	bool run() const
+		{
+			return poly_eval_batch(30, 20, 3, 500);
+		}
+};
+
+class PolyEvalPowers : public TestRunnable {
+public:
+	PolyEvalPowers()
+		: TestRunnable("polynomial evaluation with shared powers (r=10, nv=6, maxdim=5, points=200)", 5, 6) {}
+	bool run() const
+		{
+			return poly_eval_powers(10, 6, 5, 200);
+		}
+};
+
+class KronProdSpeed : public TestRunnable {
+public:
+	KronProdSpeed()
+		: TestRunnable("Kronecker product speed (r=50, rows=(10,10,10), cols=(13,13,13))", 3, 13) {}
+	bool run() const
+		{
+			IntSequence rows(3, 10);
+			IntSequence cols(3, 13);
+			return kron_prod_speed(50, rows, cols, 20);
+		}
+};
+
+class KronProdSpeedSmall : public TestRunnable {
+public:
+	KronProdSpeedSmall()
+		: TestRunnable("Kronecker product speed small blocks (r=100, rows=(3,3,3,3), cols=(4,4,4,4))", 4, 4) {}
+	bool run() const
+		{
+			IntSequence rows(4, 3);
+			IntSequence cols(4, 4);
+			return kron_prod_speed(100, rows, cols, 200);
+		}
+};
+
 class FoldZContSmall : public TestRunnable {
 public:
 	FoldZContSmall()
@@ -939,6 +1199,17 @@ public:
 };
 
 
+class NestedGroups : public TestRunnable {
+public:
+	NestedGroups()
+		: TestRunnable("nested thread groups (threads=4,outer=50,inner=200)",
+					   0, 0) {}
+	bool run() const
+		{
+			return nested_groups(4, 50, 200);
+		}
+};
+
 
 int main()
 {
@@ -976,10 +1247,15 @@ int main()
 	all_tests[num_tests++] = new UnfoldedContractionBig();
 	all_tests[num_tests++] = new PolyEvalSmall();
 	all_tests[num_tests++] = new PolyEvalBig();
+	all_tests[num_tests++] = new PolyEvalBatch();
+	all_tests[num_tests++] = new PolyEvalPowers();
+	all_tests[num_tests++] = new KronProdSpeed();
+	all_tests[num_tests++] = new KronProdSpeedSmall();
 	all_tests[num_tests++] = new FoldZContSmall();
 	all_tests[num_tests++] = new FoldZCont();
 	all_tests[num_tests++] = new UnfoldZContSmall();
 	all_tests[num_tests++] = new UnfoldZCont();
+	all_tests[num_tests++] = new NestedGroups();
 
 	// find maximum dimension and maximum nvar
 	int dmax=0;
@@ -77,6 +77,8 @@ options_.huge_number = 1e7;
 options_.threads.kronecker.A_times_B_kronecker_C = 1;
 options_.threads.kronecker.sparse_hessian_times_B_kronecker_C = 1;
 options_.threads.local_state_space_iteration_2 = 1;
+options_.threads.bytecode = 1;
+options_.threads.logMHMCMCposterior = 1;
 
 % steady state
 options_.jacobian_flag = 1;
@@ -315,6 +317,7 @@ options_.linear = 0;
 % Deterministic simulation
 options_.stack_solve_algo = 0;
 options_.markowitz = 0.5;
+options_.simplified_newton = 0;
 options_.minimal_solving_periods = 1;
 options_.endogenous_terminal_period = 0;
 options_.no_homotopy = 0;
@@ -418,6 +421,7 @@ options_.first_obs = NaN;
 options_.nobs = NaN;
 options_.kalman_algo = 0;
 options_.fast_kalman_filter = 0;
+options_.square_root_kalman_filter = 0; % only used by the estimation DLL
 options_.kalman_tol = 1e-10;
 options_.kalman.keep_kalman_algo_if_singularity_is_detected = 0;
 options_.diffuse_kalman_tol = 1e-6;
@@ -43,6 +43,10 @@ switch mexname
     options_.threads.kronecker.sparse_hessian_times_B_kronecker_C = n;
   case 'local_state_space_iteration_2'
     options_.threads.local_state_space_iteration_2 = n;
+  case 'bytecode'
+    options_.threads.bytecode = n;
+  case 'logMHMCMCposterior'
+    options_.threads.logMHMCMCposterior = n;
   otherwise
     message = [ mexname ' is not a known parallel mex file.' ];
     message_id  = 'Dynare:Threads:UnknownParallelMex';
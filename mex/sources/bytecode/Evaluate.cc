@@ -21,6 +21,10 @@
 #include <sstream>
 #include <math.h>
 #include "Evaluate.hh"
+#include "Jit.hh"
+#ifdef USE_OMP
+# include <omp.h>
+#endif
 
 #ifdef MATLAB_MEX_FILE
 extern "C" bool utIsInterruptPending();
@@ -33,6 +37,9 @@ Evaluate::Evaluate()
   Block_List_Max_Lead = 0;
   u_count_int = 0;
   block = -1;
+  legacy_interpreter = false;
+  use_jit = false;
+  nb_threads = 1;
 }
 
 Evaluate::Evaluate(const int y_size_arg, const int y_kmin_arg, const int y_kmax_arg, const bool print_it_arg, const bool steady_state_arg, const int periods_arg, const int minimal_solving_periods_arg, const double slowc_arg):
@@ -49,6 +56,14 @@ print_it(print_it_arg),  minimal_solving_periods(minimal_solving_periods_arg)
   periods = periods_arg;
   steady_state = steady_state_arg;
   slowc = slowc_arg;
+  legacy_interpreter = false;
+  use_jit = false;
+  nb_threads = 1;
+}
+
+Evaluate::~Evaluate()
+{
+  release_flat_codes();
 }
 
 double
@@ -140,7 +155,19 @@ Evaluate::compute_block_time(const int Per_u_, const bool evaluate, /*const int
 	if ( utIsInterruptPending() )
 		throw UserExceptionHandling();
 #endif
-  
+
+  if (!legacy_interpreter)
+    {
+      flat_code_type &flat_code = get_flat_code(it_code);
+      if (flat_code.usable)
+        {
+          if (use_jit && compute_block_time_jit(flat_code, Per_u_, evaluate, no_derivative, jacob, jacob_other_endo, jacob_exo, jacob_exo_det))
+            return;
+          compute_block_time_flat(flat_code, Per_u_, evaluate, no_derivative, jacob, jacob_other_endo, jacob_exo, jacob_exo_det);
+          return;
+        }
+    }
+
   while (go_on)
     {
 #ifdef DEBUG
@@ -1496,6 +1523,825 @@ Evaluate::compute_block_time(const int Per_u_, const bool evaluate, /*const int
 
 
 
+flat_code_type &
+Evaluate::get_flat_code(it_code_type begin_code)
+{
+  size_t begin_pos = begin_code - code_liste.begin();
+  map<size_t, flat_code_type>::iterator it_flat = flat_codes.find(begin_pos);
+  if (it_flat == flat_codes.end())
+    {
+      it_flat = flat_codes.insert(make_pair(begin_pos, flat_code_type())).first;
+      flatten_block(begin_code, it_flat->second);
+    }
+  return it_flat->second;
+}
+
+void
+Evaluate::flatten_block(it_code_type begin_code, flat_code_type &flat_code)
+{
+  vector<flat_instruction_type> &instructions = flat_code.instructions;
+  /* For each instruction of the block in code_liste, the index of the first
+     flat instruction generated from it or from one of its successors */
+  vector<size_t> first_flat;
+  /* Flat jump instructions and the position of their target relatively to begin_code */
+  vector<pair<size_t, size_t> > jumps;
+  unsigned int expr_equation = 0;
+  ExpressionType expr_type = TemporaryTerm;
+  size_t begin_pos = begin_code - code_liste.begin();
+  bool done = false;
+  flat_code.usable = true;
+  flat_code.jit = NULL;
+  flat_code.jit_tried = false;
+  instructions.clear();
+  for (it_code_type it = begin_code; !done && flat_code.usable && it != code_liste.end(); it++)
+    {
+      size_t pos = it - code_liste.begin();
+      first_flat.push_back(instructions.size());
+      flat_instruction_type fi;
+      fi.op = FLAT_OK;
+      fi.sub_op = 0;
+      fi.arg = 0;
+      fi.arg2 = 0;
+      fi.pos = int (pos);
+      fi.value = 0;
+      bool emit = true;
+      switch (it->first)
+        {
+        case FNUMEXPR:
+          expr_type = ((FNUMEXPR_ *) it->second)->get_expression_type();
+          expr_equation = ((FNUMEXPR_ *) it->second)->get_equation();
+          fi.op = FLAT_NUMEXPR;
+          fi.arg = expr_type;
+          fi.arg2 = expr_equation;
+          break;
+        case FLDV:
+          switch (((FLDV_ *) it->second)->get_type())
+            {
+            case eParameter:
+              fi.op = FLAT_LDPARAM;
+              fi.arg = ((FLDV_ *) it->second)->get_pos();
+              break;
+            case eEndogenous:
+              fi.op = FLAT_LDENDO;
+              fi.arg = ((FLDV_ *) it->second)->get_lead_lag()*y_size + ((FLDV_ *) it->second)->get_pos();
+              break;
+            case eExogenous:
+              fi.op = FLAT_LDEXO;
+              fi.arg = ((FLDV_ *) it->second)->get_lead_lag() + ((FLDV_ *) it->second)->get_pos()*nb_row_x;
+              break;
+            case eExogenousDet:
+              fi.op = FLAT_LDEXO;
+              fi.arg = ((FLDV_ *) it->second)->get_lead_lag() + ((FLDV_ *) it->second)->get_pos()*nb_row_xd;
+              break;
+            default:
+              emit = false;
+            }
+          break;
+        case FLDSV:
+          switch (((FLDSV_ *) it->second)->get_type())
+            {
+            case eParameter:
+              fi.op = FLAT_LDPARAM;
+              break;
+            case eEndogenous:
+              fi.op = FLAT_LDSENDO;
+              break;
+            case eExogenous:
+            case eExogenousDet:
+              fi.op = FLAT_LDSEXO;
+              break;
+            default:
+              emit = false;
+            }
+          fi.arg = ((FLDSV_ *) it->second)->get_pos();
+          break;
+        case FLDVS:
+          switch (((FLDVS_ *) it->second)->get_type())
+            {
+            case eParameter:
+              fi.op = FLAT_LDPARAM;
+              break;
+            case eEndogenous:
+              fi.op = FLAT_LDSTEADY;
+              break;
+            case eExogenous:
+            case eExogenousDet:
+              fi.op = FLAT_LDSEXO;
+              break;
+            default:
+              emit = false;
+            }
+          fi.arg = ((FLDVS_ *) it->second)->get_pos();
+          break;
+        case FLDT:
+          fi.op = FLAT_LDT;
+          fi.arg = ((FLDT_ *) it->second)->get_pos()*(periods+y_kmin+y_kmax);
+          break;
+        case FLDST:
+          fi.op = FLAT_LDST;
+          fi.arg = ((FLDST_ *) it->second)->get_pos();
+          break;
+        case FLDU:
+          fi.op = FLAT_LDU;
+          fi.arg = ((FLDU_ *) it->second)->get_pos();
+          break;
+        case FLDSU:
+          fi.op = FLAT_LDSU;
+          fi.arg = ((FLDSU_ *) it->second)->get_pos();
+          break;
+        case FLDR:
+          fi.op = FLAT_LDR;
+          fi.arg = ((FLDR_ *) it->second)->get_pos();
+          break;
+        case FLDZ:
+          fi.op = FLAT_LDC;
+          fi.value = 0.0;
+          break;
+        case FLDC:
+          fi.op = FLAT_LDC;
+          fi.value = ((FLDC_ *) it->second)->get_value();
+          break;
+        case FSTPV:
+          switch (((FSTPV_ *) it->second)->get_type())
+            {
+            case eParameter:
+              fi.op = FLAT_STPPARAM;
+              fi.arg = ((FSTPV_ *) it->second)->get_pos();
+              break;
+            case eEndogenous:
+              fi.op = FLAT_STPENDO;
+              fi.arg = ((FSTPV_ *) it->second)->get_lead_lag()*y_size + ((FSTPV_ *) it->second)->get_pos();
+              break;
+            case eExogenous:
+              fi.op = FLAT_STPEXO;
+              fi.arg = ((FSTPV_ *) it->second)->get_lead_lag() + ((FSTPV_ *) it->second)->get_pos()*nb_row_x;
+              break;
+            case eExogenousDet:
+              fi.op = FLAT_STPEXO;
+              fi.arg = ((FSTPV_ *) it->second)->get_lead_lag() + ((FSTPV_ *) it->second)->get_pos()*nb_row_xd;
+              break;
+            default:
+              flat_code.usable = false;
+            }
+          break;
+        case FSTPSV:
+          switch (((FSTPSV_ *) it->second)->get_type())
+            {
+            case eParameter:
+              fi.op = FLAT_STPPARAM;
+              break;
+            case eEndogenous:
+              fi.op = FLAT_STPSENDO;
+              break;
+            case eExogenous:
+            case eExogenousDet:
+              fi.op = FLAT_STPSEXO;
+              break;
+            default:
+              flat_code.usable = false;
+            }
+          fi.arg = ((FSTPSV_ *) it->second)->get_pos();
+          break;
+        case FSTPT:
+          fi.op = FLAT_STPT;
+          fi.arg = ((FSTPT_ *) it->second)->get_pos()*(periods+y_kmin+y_kmax);
+          break;
+        case FSTPST:
+          fi.op = FLAT_STPST;
+          fi.arg = ((FSTPST_ *) it->second)->get_pos();
+          break;
+        case FSTPU:
+          fi.op = FLAT_STPU;
+          fi.arg = ((FSTPU_ *) it->second)->get_pos();
+          break;
+        case FSTPSU:
+          fi.op = FLAT_STPSU;
+          fi.arg = ((FSTPSU_ *) it->second)->get_pos();
+          break;
+        case FSTPR:
+          fi.op = FLAT_STPR;
+          fi.arg = ((FSTPR_ *) it->second)->get_pos();
+          break;
+        case FSTPG:
+          fi.op = FLAT_STPG;
+          fi.arg = ((FSTPG_ *) it->second)->get_pos();
+          break;
+        case FSTPG2:
+          if (expr_type != FirstEndoDerivative)
+            flat_code.usable = false;
+          fi.op = FLAT_STPG2;
+          fi.arg = ((FSTPG2_ *) it->second)->get_row() + size*((FSTPG2_ *) it->second)->get_col();
+          break;
+        case FSTPG3:
+          switch (expr_type)
+            {
+            case FirstEndoDerivative:
+              fi.op = FLAT_STPJACOB;
+              fi.arg = ((FSTPG3_ *) it->second)->get_row() + size*((FSTPG3_ *) it->second)->get_col_pos();
+              break;
+            case FirstOtherEndoDerivative:
+              fi.op = FLAT_STPJACOBOTHER;
+              fi.arg = expr_equation + size*((FSTPG3_ *) it->second)->get_col_pos();
+              break;
+            case FirstExoDerivative:
+              fi.op = FLAT_STPJACOBEXO;
+              fi.arg = expr_equation + size*((FSTPG3_ *) it->second)->get_col_pos();
+              break;
+            case FirstExodetDerivative:
+              fi.op = FLAT_STPJACOBEXODET;
+              fi.arg = expr_equation + size*((FSTPG3_ *) it->second)->get_col_pos();
+              break;
+            default:
+              flat_code.usable = false;
+            }
+          break;
+        case FUNARY:
+          fi.op = FLAT_UNARY;
+          fi.sub_op = ((FUNARY_ *) it->second)->get_op_type();
+          if (fi.sub_op > oSqrt && fi.sub_op != oErf)
+            flat_code.usable = false;
+          break;
+        case FBINARY:
+          fi.op = FLAT_BINARY;
+          fi.sub_op = ((FBINARY_ *) it->second)->get_op_type();
+          if (fi.sub_op > oDifferent)
+            flat_code.usable = false;
+          break;
+        case FTRINARY:
+          fi.op = FLAT_TRINARY;
+          fi.sub_op = ((FTRINARY_ *) it->second)->get_op_type();
+          if (fi.sub_op > oNormpdf)
+            flat_code.usable = false;
+          break;
+        case FCUML:
+          fi.op = FLAT_CUML;
+          break;
+        case FPUSH:
+          emit = false;
+          break;
+        case FENDEQU:
+          fi.op = FLAT_ENDEQU;
+          break;
+        case FENDBLOCK:
+          fi.op = FLAT_ENDBLOCK;
+          done = true;
+          break;
+        case FJMPIFEVAL:
+          fi.op = FLAT_JMPIFEVAL;
+          jumps.push_back(make_pair(instructions.size(), pos - begin_pos + ((FJMPIFEVAL_ *) it->second)->get_pos() + 1));
+          break;
+        case FJMP:
+          fi.op = FLAT_JMP;
+          jumps.push_back(make_pair(instructions.size(), pos - begin_pos + ((FJMP_ *) it->second)->get_pos() + 1));
+          break;
+        case FOK:
+          fi.op = FLAT_OK;
+          break;
+        default:
+          /* External functions (FCALL and the related FLDTEF* / FSTPTEF* instructions)
+             are left to the legacy interpreter */
+          flat_code.usable = false;
+        }
+      if (emit)
+        instructions.push_back(fi);
+    }
+  if (!done)
+    flat_code.usable = false;
+  for (vector<pair<size_t, size_t> >::const_iterator it = jumps.begin(); flat_code.usable && it != jumps.end(); it++)
+    if (it->second < first_flat.size())
+      instructions[it->first].arg = int (first_flat[it->second]);
+    else
+      flat_code.usable = false;
+  if (!flat_code.usable)
+    instructions.clear();
+  // Each instruction pushes at most one element on the stack
+  flat_code.stack_size = instructions.size() + 1;
+  flat_code.parallel_safe = flat_code.usable;
+  for (vector<flat_instruction_type>::const_iterator it = instructions.begin(); flat_code.parallel_safe && it != instructions.end(); it++)
+    switch (it->op)
+      {
+      case FLAT_STPPARAM:
+      case FLAT_STPENDO:
+      case FLAT_STPSENDO:
+      case FLAT_STPEXO:
+      case FLAT_STPSEXO:
+      case FLAT_STPST:
+      case FLAT_STPSU:
+      case FLAT_STPG:
+        flat_code.parallel_safe = false;
+        break;
+      default:
+        break;
+      }
+}
+
+/* Floating point checks of the flat interpreter. They have the semantic of
+   Evaluate::divide, pow1, log1 and log10_1 but record the error in the run
+   instead of throwing, so that they can be used concurrently. */
+static void
+flat_fp_error(flat_run_type &run, FlatFPErrors op, double v1, double v2)
+{
+  if (!run.fp_error)
+    {
+      run.fp_error = true;
+      run.fp_error_op = op;
+      run.fp_error_v1 = v1;
+      run.fp_error_v2 = v2;
+    }
+}
+
+static double
+flat_divide(double a, double b, flat_run_type &run)
+{
+  double r = a / b;
+  if (isnan(r) || isinf(r))
+    {
+      flat_fp_error(run, FLAT_FP_DIVIDE, a, b);
+      r = 1e70;
+    }
+  return r;
+}
+
+static double
+flat_pow(double a, double b, flat_run_type &run)
+{
+  double r = pow_(a, b);
+  if (isnan(r) || isinf(r))
+    {
+      flat_fp_error(run, FLAT_FP_POW, a, b);
+      r = 0.0000000000000000000000001;
+    }
+  return r;
+}
+
+static double
+flat_log(double a, FlatFPErrors op, flat_run_type &run)
+{
+  // log10 is computed as log, as in Evaluate::log10_1
+  double r = log(a);
+  if (isnan(r) || isinf(r))
+    {
+      flat_fp_error(run, op, a, 0);
+      r = -1e70;
+    }
+  return r;
+}
+
+void
+Evaluate::run_flat_code(const flat_code_type &flat_code, flat_run_type &run, const bool evaluate, const bool no_derivative,
+                        double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det) const
+{
+  // The period dependent state comes from the run and hides the data members
+  const int it_ = run.it_, Per_u_ = run.Per_u_;
+  double *r = run.r;
+  double *stack = run.stack;
+  int sp = 0;
+  const flat_instruction_type *code = &flat_code.instructions[0];
+  const double *yy = evaluate ? ya : y;
+  const int Per_y = it_*y_size;
+  size_t ip = 0;
+  double v1, v2, v3;
+  bool go_on = true;
+  run.fp_error = false;
+  run.numexpr_ip = -1;
+
+  while (go_on)
+    {
+      const flat_instruction_type &fi = code[ip++];
+      switch (fi.op)
+        {
+        case FLAT_NUMEXPR:
+          run.numexpr_ip = ip-1;
+          break;
+        case FLAT_LDPARAM:
+          stack[sp++] = params[fi.arg];
+          break;
+        case FLAT_LDENDO:
+          stack[sp++] = yy[Per_y+fi.arg];
+          break;
+        case FLAT_LDSENDO:
+          stack[sp++] = yy[fi.arg];
+          break;
+        case FLAT_LDSTEADY:
+          stack[sp++] = steady_y[fi.arg];
+          break;
+        case FLAT_LDEXO:
+          stack[sp++] = x[it_+fi.arg];
+          break;
+        case FLAT_LDSEXO:
+          stack[sp++] = x[fi.arg];
+          break;
+        case FLAT_LDT:
+          stack[sp++] = T[fi.arg+it_];
+          break;
+        case FLAT_LDST:
+          stack[sp++] = T[fi.arg];
+          break;
+        case FLAT_LDU:
+          stack[sp++] = u[fi.arg+Per_u_];
+          break;
+        case FLAT_LDSU:
+          stack[sp++] = u[fi.arg];
+          break;
+        case FLAT_LDR:
+          stack[sp++] = r[fi.arg];
+          break;
+        case FLAT_LDC:
+          stack[sp++] = fi.value;
+          break;
+        case FLAT_STPPARAM:
+          params[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPENDO:
+          y[Per_y+fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPSENDO:
+          y[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPEXO:
+          x[it_+fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPSEXO:
+          x[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPT:
+          T[fi.arg+it_] = stack[--sp];
+          break;
+        case FLAT_STPST:
+          T[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPU:
+          u[fi.arg+Per_u_] = stack[--sp];
+          break;
+        case FLAT_STPSU:
+          u[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPR:
+          r[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPG:
+          g1[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPG2:
+          // As in the legacy interpreter, the value is left on the stack
+          jacob[fi.arg] = stack[sp-1];
+          break;
+        case FLAT_STPJACOB:
+          jacob[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPJACOBOTHER:
+          jacob_other_endo[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPJACOBEXO:
+          jacob_exo[fi.arg] = stack[--sp];
+          break;
+        case FLAT_STPJACOBEXODET:
+          jacob_exo_det[fi.arg] = stack[--sp];
+          break;
+        case FLAT_BINARY:
+          v2 = stack[--sp];
+          v1 = stack[--sp];
+          switch (fi.sub_op)
+            {
+            case oPlus:
+              stack[sp++] = v1 + v2;
+              break;
+            case oMinus:
+              stack[sp++] = v1 - v2;
+              break;
+            case oTimes:
+              stack[sp++] = v1 * v2;
+              break;
+            case oDivide:
+              stack[sp++] = flat_divide(v1, v2, run);
+              break;
+            case oLess:
+              stack[sp++] = double (v1 < v2);
+              break;
+            case oGreater:
+              stack[sp++] = double (v1 > v2);
+              break;
+            case oLessEqual:
+              stack[sp++] = double (v1 <= v2);
+              break;
+            case oGreaterEqual:
+              stack[sp++] = double (v1 >= v2);
+              break;
+            case oEqualEqual:
+              stack[sp++] = double (v1 == v2);
+              break;
+            case oDifferent:
+              stack[sp++] = double (v1 != v2);
+              break;
+            case oPower:
+              stack[sp++] = flat_pow(v1, v2, run);
+              break;
+            case oPowerDeriv:
+              {
+                int derivOrder = int (nearbyint(stack[--sp]));
+                if (fabs(v1) < NEAR_ZERO && v2 > 0
+                    && derivOrder > v2
+                    && fabs(v2-nearbyint(v2)) < NEAR_ZERO)
+                  stack[sp++] = 0.0;
+                else
+                  {
+                    double dxp = flat_pow(v1, v2-derivOrder, run);
+                    for (int i = 0; i < derivOrder; i++)
+                      dxp *= v2--;
+                    stack[sp++] = dxp;
+                  }
+              }
+              break;
+            case oMax:
+              stack[sp++] = max(v1, v2);
+              break;
+            case oMin:
+              stack[sp++] = min(v1, v2);
+              break;
+            case oEqual:
+              // Nothing to do
+              break;
+            }
+          break;
+        case FLAT_UNARY:
+          v1 = stack[--sp];
+          switch (fi.sub_op)
+            {
+            case oUminus:
+              stack[sp++] = -v1;
+              break;
+            case oExp:
+              stack[sp++] = exp(v1);
+              break;
+            case oLog:
+              stack[sp++] = flat_log(v1, FLAT_FP_LOG, run);
+              break;
+            case oLog10:
+              stack[sp++] = flat_log(v1, FLAT_FP_LOG10, run);
+              break;
+            case oCos:
+              stack[sp++] = cos(v1);
+              break;
+            case oSin:
+              stack[sp++] = sin(v1);
+              break;
+            case oTan:
+              stack[sp++] = tan(v1);
+              break;
+            case oAcos:
+              stack[sp++] = acos(v1);
+              break;
+            case oAsin:
+              stack[sp++] = asin(v1);
+              break;
+            case oAtan:
+              stack[sp++] = atan(v1);
+              break;
+            case oCosh:
+              stack[sp++] = cosh(v1);
+              break;
+            case oSinh:
+              stack[sp++] = sinh(v1);
+              break;
+            case oTanh:
+              stack[sp++] = tanh(v1);
+              break;
+            case oAcosh:
+              stack[sp++] = acosh(v1);
+              break;
+            case oAsinh:
+              stack[sp++] = asinh(v1);
+              break;
+            case oAtanh:
+              stack[sp++] = atanh(v1);
+              break;
+            case oSqrt:
+              stack[sp++] = sqrt(v1);
+              break;
+            case oErf:
+              stack[sp++] = erf(v1);
+              break;
+            }
+          break;
+        case FLAT_TRINARY:
+          v3 = stack[--sp];
+          v2 = stack[--sp];
+          v1 = stack[--sp];
+          switch (fi.sub_op)
+            {
+            case oNormcdf:
+              stack[sp++] = 0.5*(1+erf((v1-v2)/v3/M_SQRT2));
+              break;
+            case oNormpdf:
+              stack[sp++] = 1/(v3*sqrt(2*M_PI)*exp(pow((v1-v2)/v3, 2)/2));
+              break;
+            }
+          break;
+        case FLAT_CUML:
+          v1 = stack[--sp];
+          v2 = stack[--sp];
+          stack[sp++] = v1 + v2;
+          break;
+        case FLAT_ENDEQU:
+          if (no_derivative)
+            go_on = false;
+          break;
+        case FLAT_ENDBLOCK:
+          go_on = false;
+          break;
+        case FLAT_JMPIFEVAL:
+          if (evaluate)
+            ip = fi.arg;
+          break;
+        case FLAT_JMP:
+          ip = fi.arg;
+          break;
+        case FLAT_OK:
+          if (sp > 0)
+            {
+              ostringstream tmp;
+              tmp << " in compute_block_time, stack not empty\n";
+              throw FatalExceptionHandling(tmp.str());
+            }
+          break;
+        }
+      if (run.fp_error && print_error)
+        go_on = false;
+    }
+  run.exit_ip = ip-1;
+}
+
+void
+Evaluate::end_flat_run(const flat_code_type &flat_code, const flat_run_type &run, const bool evaluate)
+{
+  if (run.numexpr_ip >= 0)
+    {
+      const flat_instruction_type &fi = flat_code.instructions[run.numexpr_ip];
+      it_code_expr = code_liste.begin() + fi.pos;
+      EQN_type = (ExpressionType) fi.arg;
+      EQN_equation = fi.arg2;
+      // Derivation variables and lags, set as in the FNUMEXPR case of the legacy interpreter
+      FNUMEXPR_ *numexpr = (FNUMEXPR_ *) it_code_expr->second;
+      switch (EQN_type)
+        {
+        case FirstEndoDerivative:
+        case FirstOtherEndoDerivative:
+        case FirstExoDerivative:
+        case FirstExodetDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          EQN_lag1 = numexpr->get_lag1();
+          break;
+        case FirstParamDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          break;
+        case SecondEndoDerivative:
+        case SecondExoDerivative:
+        case SecondExodetDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          EQN_lag1 = numexpr->get_lag1();
+          EQN_dvar2 = numexpr->get_dvariable2();
+          EQN_lag2 = numexpr->get_lag2();
+          break;
+        case SecondParamDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          EQN_dvar2 = numexpr->get_dvariable2();
+          break;
+        case ThirdEndoDerivative:
+        case ThirdExoDerivative:
+        case ThirdExodetDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          EQN_lag1 = numexpr->get_lag1();
+          EQN_dvar2 = numexpr->get_dvariable2();
+          EQN_lag2 = numexpr->get_lag2();
+          EQN_dvar3 = numexpr->get_dvariable3();
+          EQN_lag3 = numexpr->get_lag3();
+          break;
+        case ThirdParamDerivative:
+          EQN_dvar1 = numexpr->get_dvariable1();
+          EQN_dvar2 = numexpr->get_dvariable2();
+          EQN_dvar3 = numexpr->get_dvariable3();
+          break;
+        default:
+          break;
+        }
+    }
+  if (run.fp_error)
+    {
+      res1 = NAN;
+      if (print_error)
+        {
+          string msg;
+          switch (run.fp_error_op)
+            {
+            case FLAT_FP_DIVIDE:
+              msg = DivideExceptionHandling(run.fp_error_v1, run.fp_error_v2).GetErrorMsg();
+              break;
+            case FLAT_FP_POW:
+              msg = PowExceptionHandling(run.fp_error_v1, run.fp_error_v2).GetErrorMsg();
+              break;
+            case FLAT_FP_LOG:
+              msg = LogExceptionHandling(run.fp_error_v1).GetErrorMsg();
+              break;
+            case FLAT_FP_LOG10:
+              msg = Log10ExceptionHandling(run.fp_error_v1).GetErrorMsg();
+              break;
+            default:
+              msg = FloatingPointExceptionHandling("NaN or Inf\n").GetErrorMsg();
+            }
+          mexPrintf("%s      %s\n", msg.c_str(), error_location(evaluate, steady_state, size, block_num, run.it_, run.Per_u_).c_str());
+        }
+    }
+  // Leaves it_code where the legacy interpreter would have left it
+  it_code = code_liste.begin() + flat_code.instructions[run.exit_ip].pos + 1;
+}
+
+void
+Evaluate::compute_block_time_flat(const flat_code_type &flat_code, const int Per_u_, const bool evaluate, const bool no_derivative,
+                                  double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det)
+{
+  if (flat_stack.size() < flat_code.stack_size)
+    flat_stack.resize(flat_code.stack_size);
+  flat_run_type run;
+  run.it_ = it_;
+  run.Per_u_ = Per_u_;
+  run.r = r;
+  run.stack = &flat_stack[0];
+  run_flat_code(flat_code, run, evaluate, no_derivative, jacob, jacob_other_endo, jacob_exo, jacob_exo_det);
+  end_flat_run(flat_code, run, evaluate);
+}
+
+void
+Evaluate::release_flat_codes()
+{
+  for (map<size_t, flat_code_type>::iterator it = flat_codes.begin(); it != flat_codes.end(); it++)
+    JitBlock::release(it->second.jit);
+  flat_codes.clear();
+}
+
+bool
+Evaluate::prepare_jit(flat_code_type &flat_code)
+{
+  if (!flat_code.jit_tried)
+    {
+      flat_code.jit = JitBlock::get(flat_code.instructions);
+      flat_code.jit_tried = true;
+    }
+  return flat_code.jit != NULL;
+}
+
+void
+Evaluate::run_jit_code(const flat_code_type &flat_code, flat_run_type &run, const bool evaluate, const bool no_derivative,
+                       double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det) const
+{
+  double run_res1 = 0;
+  jit_context_type context;
+  context.yy = evaluate ? ya : y;
+  context.yy_per = context.yy + run.it_*y_size;
+  context.y = y;
+  context.y_per = y + run.it_*y_size;
+  context.steady_y = steady_y;
+  context.x = x;
+  context.x_it = x + run.it_;
+  context.T = T;
+  context.T_it = T + run.it_;
+  context.u = u;
+  context.u_per = u + run.Per_u_;
+  context.r = run.r;
+  context.g1 = g1;
+  context.params = params;
+  context.jacob = jacob;
+  context.jacob_other_endo = jacob_other_endo;
+  context.jacob_exo = jacob_exo;
+  context.jacob_exo_det = jacob_exo_det;
+  context.res1 = &run_res1;
+  context.evaluate = evaluate;
+  context.no_derivative = no_derivative;
+  context.print_error = print_error;
+  run.exit_ip = flat_code.jit->run(context, run.stack);
+  run.numexpr_ip = context.numexpr_index;
+  // The generated code does not report which operation failed
+  run.fp_error = isnan(run_res1);
+  run.fp_error_op = FLAT_FP_UNKNOWN;
+}
+
+bool
+Evaluate::compute_block_time_jit(flat_code_type &flat_code, const int Per_u_, const bool evaluate, const bool no_derivative,
+                                 double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det)
+{
+  if (!prepare_jit(flat_code))
+    return false;
+  if (flat_stack.size() < flat_code.stack_size)
+    flat_stack.resize(flat_code.stack_size);
+  flat_run_type run;
+  run.it_ = it_;
+  run.Per_u_ = Per_u_;
+  run.r = r;
+  run.stack = &flat_stack[0];
+  run_jit_code(flat_code, run, evaluate, no_derivative, jacob, jacob_other_endo, jacob_exo, jacob_exo_det);
+  end_flat_run(flat_code, run, evaluate);
+  return true;
+}
+
 void
 Evaluate::evaluate_over_periods(const bool forward)
 {
@@ -1635,6 +2481,17 @@ Evaluate::compute_complete_2b(const bool no_derivatives, double *_res1, double *
   *_res1 = 0;
   *_res2 = 0;
   *_max_res = 0;
+#ifdef USE_OMP
+  if (nb_threads > 1 && periods > 1 && !legacy_interpreter)
+    {
+      flat_code_type &flat_code = get_flat_code(start_code);
+      if (flat_code.usable && flat_code.parallel_safe)
+        {
+          compute_complete_2b_parallel(flat_code, no_derivatives, _res1, _res2, _max_res, _max_res_idx);
+          return;
+        }
+    }
+#endif
   for (it_ = y_kmin; it_ < periods+y_kmin; it_++)
     {
       Per_u_ = (it_-y_kmin)*u_count_int;
@@ -1666,6 +2523,80 @@ Evaluate::compute_complete_2b(const bool no_derivatives, double *_res1, double *
   return;
 }
 
+#ifdef USE_OMP
+void
+Evaluate::compute_complete_2b_parallel(flat_code_type &flat_code, const bool no_derivatives, double *_res1, double *_res2, double *_max_res, int *_max_res_idx)
+{
+#ifdef MATLAB_MEX_FILE
+  if (utIsInterruptPending())
+    throw UserExceptionHandling();
+#endif
+  EQN_block = block_num;
+  // The compilation modifies flat_code, it has to be done before the parallel region
+  bool jit = use_jit && prepare_jit(flat_code);
+  if (flat_stack.size() < nb_threads * flat_code.stack_size)
+    flat_stack.resize(nb_threads * flat_code.stack_size);
+  vector<flat_run_type> runs(periods);
+  bool fatal_error = false;
+  string fatal_error_msg;
+  /* Each period writes its residuals directly in res, the temporary terms and
+     the jacobian elements (u) of the period are at distinct locations */
+#pragma omp parallel for num_threads(nb_threads) schedule(static)
+  for (int t = 0; t < periods; t++)
+    {
+      flat_run_type &run = runs[t];
+      run.it_ = t + y_kmin;
+      run.Per_u_ = t * u_count_int;
+      run.r = res + t * size;
+      run.stack = &flat_stack[omp_get_thread_num() * flat_code.stack_size];
+      run.fp_error = false;
+      run.exit_ip = 0;
+      run.numexpr_ip = -1;
+      try
+        {
+          if (jit)
+            run_jit_code(flat_code, run, false, no_derivatives, NULL, NULL, NULL, NULL);
+          else
+            run_flat_code(flat_code, run, false, no_derivatives, NULL, NULL, NULL, NULL);
+        }
+      catch (GeneralExceptionHandling &feh)
+        {
+#pragma omp critical
+          if (!fatal_error)
+            {
+              fatal_error = true;
+              fatal_error_msg = feh.GetErrorMsg();
+            }
+        }
+    }
+  if (fatal_error)
+    throw GeneralExceptionHandling(fatal_error_msg);
+
+  // The results are reduced in the order of the sequential loop, which stops on the first error
+  for (it_ = y_kmin; it_ < periods+y_kmin; it_++)
+    {
+      const flat_run_type &run = runs[it_-y_kmin];
+      Per_u_ = run.Per_u_;
+      Per_y_ = it_*y_size;
+      end_flat_run(flat_code, run, false);
+      int shift = (it_-y_kmin) * size;
+      memcpy(r, res + shift, size * sizeof(double));
+      if (isnan(res1) || isinf(res1))
+        return;
+      for (int i = 0; i < size; i++)
+        {
+          double rr = r[i];
+          if (max_res < fabs(rr))
+            {
+              *_max_res = fabs(rr);
+              *_max_res_idx = i;
+            }
+          *_res2 += rr*rr;
+          *_res1 += fabs(rr);
+        }
+    }
+}
+#endif
 
 bool
 Evaluate::compute_complete(const bool no_derivatives, double &_res1, double &_res2, double &_max_res, int &_max_res_idx)
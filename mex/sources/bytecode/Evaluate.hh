@@ -24,6 +24,7 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <map>
 #define BYTE_CODE
 #include "CodeInterpreter.hh"
 #ifdef LINBCG
@@ -38,6 +39,109 @@
 
 #define pow_ pow
 
+class JitBlock;
+
+/*! Opcodes of the flattened form of a block code (see Evaluate::flatten_block).
+    Every operand is resolved at translation time into an offset in the data
+    array it refers to, so that the interpreter loop only adds the current
+    period and dereferences. */
+enum FlatTags
+  {
+    FLAT_NUMEXPR,       //!< Records the current expression (for error messages)
+    FLAT_LDPARAM,       //!< Loads params[arg]
+    FLAT_LDENDO,        //!< Loads y[it_*y_size+arg] (ya when evaluating)
+    FLAT_LDSENDO,       //!< Loads y[arg] (ya when evaluating)
+    FLAT_LDSTEADY,      //!< Loads steady_y[arg]
+    FLAT_LDEXO,         //!< Loads x[it_+arg]
+    FLAT_LDSEXO,        //!< Loads x[arg]
+    FLAT_LDT,           //!< Loads T[arg+it_]
+    FLAT_LDST,          //!< Loads T[arg]
+    FLAT_LDU,           //!< Loads u[arg+Per_u_]
+    FLAT_LDSU,          //!< Loads u[arg]
+    FLAT_LDR,           //!< Loads r[arg]
+    FLAT_LDC,           //!< Loads a numerical constant
+    FLAT_STPPARAM,      //!< Stores in params[arg]
+    FLAT_STPENDO,       //!< Stores in y[it_*y_size+arg]
+    FLAT_STPSENDO,      //!< Stores in y[arg]
+    FLAT_STPEXO,        //!< Stores in x[it_+arg]
+    FLAT_STPSEXO,       //!< Stores in x[arg]
+    FLAT_STPT,          //!< Stores in T[arg+it_]
+    FLAT_STPST,         //!< Stores in T[arg]
+    FLAT_STPU,          //!< Stores in u[arg+Per_u_]
+    FLAT_STPSU,         //!< Stores in u[arg]
+    FLAT_STPR,          //!< Stores in r[arg]
+    FLAT_STPG,          //!< Stores in g1[arg]
+    FLAT_STPG2,         //!< Copies the top of the stack in jacob[arg] (static jacobian)
+    FLAT_STPJACOB,      //!< Stores in jacob[arg]
+    FLAT_STPJACOBOTHER, //!< Stores in jacob_other_endo[arg]
+    FLAT_STPJACOBEXO,   //!< Stores in jacob_exo[arg]
+    FLAT_STPJACOBEXODET, //!< Stores in jacob_exo_det[arg]
+    FLAT_UNARY,         //!< Unary operator sub_op
+    FLAT_BINARY,        //!< Binary operator sub_op
+    FLAT_TRINARY,       //!< Trinary operator sub_op
+    FLAT_CUML,          //!< Cumulates the two top elements of the stack
+    FLAT_ENDEQU,        //!< End of the equations, stops if no derivatives are required
+    FLAT_ENDBLOCK,      //!< End of the block
+    FLAT_JMPIFEVAL,     //!< Jumps to instruction arg if evaluate = true
+    FLAT_JMP,           //!< Jumps to instruction arg
+    FLAT_OK             //!< Checks that the stack is empty
+  };
+
+//! One instruction of the flattened code
+struct flat_instruction_type
+{
+  uint8_t op, sub_op;
+  int arg, arg2;
+  //! Position of the originating instruction in code_liste
+  int pos;
+  double value;
+};
+
+//! Flattened code of a block, built once and reused over periods and iterations
+struct flat_code_type
+{
+  //! False if the block uses instructions the flat interpreter does not handle (external functions)
+  bool usable;
+  vector<flat_instruction_type> instructions;
+  unsigned int stack_size;
+  //! Native code of the block (see Jit.hh), NULL if not compiled
+  JitBlock *jit;
+  //! True once the compilation has been attempted
+  bool jit_tried;
+  /*! True if the block only writes in per period locations (T, u and the
+    residuals of the current period and the jacobians), so that several periods
+    can be evaluated concurrently */
+  bool parallel_safe;
+};
+
+//! Floating point errors detected by the flat interpreter
+enum FlatFPErrors
+  {
+    FLAT_FP_DIVIDE,
+    FLAT_FP_POW,
+    FLAT_FP_LOG,
+    FLAT_FP_LOG10,
+    FLAT_FP_UNKNOWN     //!< Error reported by the native code
+  };
+
+//! State of one evaluation of a flattened block for a given period
+struct flat_run_type
+{
+  int it_, Per_u_;
+  //! Residuals of the period
+  double *r;
+  //! Value stack, of size flat_code_type::stack_size at least
+  double *stack;
+  //! First floating point error met during the evaluation
+  bool fp_error;
+  FlatFPErrors fp_error_op;
+  double fp_error_v1, fp_error_v2;
+  //! Index of the instruction on which the evaluation stopped
+  size_t exit_ip;
+  //! Index of the last FLAT_NUMEXPR instruction executed, -1 if none
+  int numexpr_ip;
+};
+
 class Evaluate : public ErrorMsg
 {
 private:
@@ -54,6 +158,27 @@ protected:
   void solve_simple_one_periods();
   void solve_simple_over_periods(const bool forward);
   void compute_block_time(const int Per_u_, const bool evaluate, const bool no_derivatives);
+  //! Returns the flattened code of the block starting at begin_code, building it on the first call
+  flat_code_type &get_flat_code(it_code_type begin_code);
+  void flatten_block(it_code_type begin_code, flat_code_type &flat_code);
+  void compute_block_time_flat(const flat_code_type &flat_code, const int Per_u_, const bool evaluate, const bool no_derivatives,
+                               double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det);
+  bool compute_block_time_jit(flat_code_type &flat_code, const int Per_u_, const bool evaluate, const bool no_derivatives,
+                              double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det);
+  /*! Evaluates a flattened block for the period of run. Only run and the
+    locations written by the block are modified, so that the evaluations of
+    periods can be run concurrently on parallel_safe blocks */
+  void run_flat_code(const flat_code_type &flat_code, flat_run_type &run, const bool evaluate, const bool no_derivatives,
+                     double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det) const;
+  //! Same as run_flat_code with the native code, prepare_jit must have returned true
+  void run_jit_code(const flat_code_type &flat_code, flat_run_type &run, const bool evaluate, const bool no_derivatives,
+                    double *jacob, double *jacob_other_endo, double *jacob_exo, double *jacob_exo_det) const;
+  //! Compiles the block if it has not been attempted yet, returns true if native code is available
+  bool prepare_jit(flat_code_type &flat_code);
+  //! Drops the flattened blocks and gives their native code back to the JIT cache, to be called when code_liste is reloaded
+  void release_flat_codes();
+  //! Reports the errors of a run and updates the interpreter state as the legacy interpreter does
+  void end_flat_run(const flat_code_type &flat_code, const flat_run_type &run, const bool evaluate);
   code_liste_type code_liste;
   it_code_type it_code;
   int Block_Count, Per_u_, Per_y_;
@@ -80,17 +205,30 @@ protected:
   int type, block_num, symbol_table_endo_nbr, Block_List_Max_Lag, Block_List_Max_Lead, u_count_int, block;
   string file_name, bin_base_name;
   bool Gaussian_Elimination, is_linear;
+  //! If true, the code is interpreted directly from code_liste instead of its flattened form
+  bool legacy_interpreter;
+  map<size_t, flat_code_type> flat_codes;
+  vector<double> flat_stack;
+  //! If true, the flattened blocks are compiled to native code when the platform allows it
+  bool use_jit;
+  //! Number of threads used to evaluate the periods of two boundaries blocks
+  int nb_threads;
 public:
   bool steady_state;
   double slowc;
   Evaluate();
   Evaluate(const int y_size_arg, const int y_kmin_arg, const int y_kmax_arg, const bool print_it_arg, const bool steady_state_arg, const int periods_arg, const int minimal_solving_periods_arg, const double slowc);
+  ~Evaluate();
   //typedef  void (Interpreter::*InterfpreterMemFn)(const int block_num, const int size, const bool steady_state, int it);
   void set_block(const int size_arg, const int type_arg, string file_name_arg, string bin_base_name_arg, const int block_num_arg,
           const bool is_linear_arg, const int symbol_table_endo_nbr_arg, const int Block_List_Max_Lag_arg, const int Block_List_Max_Lead_arg, const int u_count_int_arg, const int block_arg);
   void evaluate_complete(const bool no_derivatives);
   bool compute_complete(const bool no_derivatives, double &res1, double &res2, double &max_res, int &max_res_idx);
   void compute_complete_2b(const bool no_derivatives, double *_res1, double *_res2, double *_max_res, int *_max_res_idx);
+#ifdef USE_OMP
+  //! Evaluates the periods of compute_complete_2b concurrently, with nb_threads threads
+  void compute_complete_2b_parallel(flat_code_type &flat_code, const bool no_derivatives, double *_res1, double *_res2, double *_max_res, int *_max_res_idx);
+#endif
 
   bool compute_complete(double lambda, double *crit);
 };
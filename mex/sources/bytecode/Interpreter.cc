@@ -35,7 +35,7 @@ Interpreter::Interpreter(double *params_arg, double *y_arg, double *ya_arg, doub
                          int maxit_arg_, double solve_tolf_arg, size_t size_of_direction_arg, double slowc_arg, int y_decal_arg, double markowitz_c_arg,
                          string &filename_arg, int minimal_solving_periods_arg, int stack_solve_algo_arg, int solve_algo_arg,
                          bool global_temporary_terms_arg, bool print_arg, bool print_error_arg, mxArray *GlobalTemporaryTerms_arg,
-                         bool steady_state_arg, bool print_it_arg, int col_x_arg
+                         bool steady_state_arg, bool print_it_arg, int col_x_arg, bool legacy_interpreter_arg, bool jit_arg, int nb_threads_arg, int simplified_newton_arg
 #ifdef CUDA
                          , const int CUDA_device_arg, cublasHandle_t cublas_handle_arg, cusparseHandle_t cusparse_handle_arg, cusparseMatDescr_t descr_arg
 #endif
@@ -78,7 +78,10 @@ Interpreter::Interpreter(double *params_arg, double *y_arg, double *ya_arg, doub
   print_error = print_error_arg;
   //steady_state = steady_state_arg;
   print_it = print_it_arg;
-
+  legacy_interpreter = legacy_interpreter_arg;
+  use_jit = jit_arg;
+  nb_threads = nb_threads_arg;
+  simplified_newton = simplified_newton_arg;
 }
 
 void
@@ -567,12 +570,16 @@ Interpreter::ReadCodeFile(string file_name, CodeLoad &code)
     file_name += "_dynamic";
  
   //First read and store in memory the code
+  release_flat_codes();
   code_liste = code.get_op_code(file_name);
   EQN_block_number = code.get_block_number();
   if (!code_liste.size())
     {
       ostringstream tmp;
-      tmp << " in compute_blocks, " << file_name.c_str() << " cannot be opened\n";
+      if (code.get_error().size())
+        tmp << " in compute_blocks, " << code.get_error();
+      else
+        tmp << " in compute_blocks, " << file_name.c_str() << " cannot be opened\n";
       throw FatalExceptionHandling(tmp.str());
     }
   if (block >= (int) code.get_block_number())
@@ -726,8 +733,6 @@ Interpreter::MainLoop(string bin_basename, CodeLoad code, bool evaluate, int blo
                 if (result == ERROR_ON_EXIT)
                   return ERROR_ON_EXIT;
               }
-            if (last_call)
-              delete fb;
           }
           if (block >= 0)
             {
@@ -932,8 +937,7 @@ Interpreter::extended_path(string file_name, string bin_basename, bool evaluate,
     y[i]  = y_save[i];
   for (int j = 0; j < col_x* nb_row_x; j++)
     x[j] = x_save[j];
-    
-  mxFree(Init_Code->second);
+
   mxFree(y_save);
   mxFree(x_save);
   nb_blocks = Block_Count+1;
@@ -950,14 +954,11 @@ Interpreter::compute_blocks(string file_name, string bin_basename, bool evaluate
   
   //The big loop on intructions
   it_code = code_liste.begin();
-  it_code_type Init_Code = it_code;
   vector<s_plan> s_plan_junk;
   vector_table_conditional_local_type vector_table_conditional_local_junk;
 
   MainLoop(bin_basename, code, evaluate, block, true, false, s_plan_junk, vector_table_conditional_local_junk);
-  
-  
-  mxFree(Init_Code->second);
+
   nb_blocks = Block_Count+1;
   if (T && !global_temporary_terms)
     mxFree(T);
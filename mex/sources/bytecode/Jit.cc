@@ -0,0 +1,803 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <climits>
+#include <cstring>
+#include <cmath>
+#include "Jit.hh"
+#ifdef BYTECODE_JIT
+# include <sys/mman.h>
+#endif
+
+JitBlock::Cache JitBlock::cache;
+
+JitBlock::Cache::~Cache()
+{
+  for (list<entry_type>::iterator it = entries.begin(); it != entries.end(); it++)
+    delete it->block;
+}
+
+void
+JitBlock::Cache::trim()
+{
+  list<entry_type>::iterator it = entries.end();
+  while (entries.size() > max_blocks && it != entries.begin())
+    {
+      it--;
+      if (it->block && it->block->users > 0)
+        continue;
+      pair<multimap<size_t, list<entry_type>::iterator>::iterator,
+           multimap<size_t, list<entry_type>::iterator>::iterator> range = index.equal_range(it->checksum);
+      for (multimap<size_t, list<entry_type>::iterator>::iterator it_index = range.first; it_index != range.second; it_index++)
+        if (it_index->second == it)
+          {
+            index.erase(it_index);
+            break;
+          }
+      delete it->block;
+      it = entries.erase(it);
+    }
+}
+
+JitBlock::JitBlock(const vector<uint8_t> &machine_code)
+{
+  code = NULL;
+  code_size = machine_code.size();
+  function = NULL;
+  users = 0;
+#ifdef BYTECODE_JIT
+  void *mem = mmap(NULL, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (mem == MAP_FAILED)
+    return;
+  memcpy(mem, &machine_code[0], code_size);
+  if (mprotect(mem, code_size, PROT_READ | PROT_EXEC))
+    {
+      munmap(mem, code_size);
+      return;
+    }
+  code = mem;
+  function = (jit_function_type) code;
+#endif
+}
+
+JitBlock::~JitBlock()
+{
+#ifdef BYTECODE_JIT
+  if (code)
+    munmap(code, code_size);
+#endif
+}
+
+int
+JitBlock::run(jit_context_type &context, double *stack) const
+{
+  context.stop = 0;
+  context.exit_index = -1;
+  context.numexpr_index = -1;
+  function(&context, stack);
+  return context.exit_index;
+}
+
+size_t
+JitBlock::checksum(const vector<flat_instruction_type> &instructions)
+{
+  // FNV-1a over the significant fields of the instructions
+  size_t h = 2166136261U;
+  for (vector<flat_instruction_type>::const_iterator it = instructions.begin(); it != instructions.end(); it++)
+    {
+      int fields[5] = { it->op, it->sub_op, it->arg, it->arg2, it->pos };
+      const unsigned char *p = reinterpret_cast<const unsigned char *>(fields);
+      for (size_t i = 0; i < sizeof(fields); i++)
+        h = (h ^ p[i]) * 16777619U;
+      p = reinterpret_cast<const unsigned char *>(&it->value);
+      for (size_t i = 0; i < sizeof(double); i++)
+        h = (h ^ p[i]) * 16777619U;
+    }
+  return h;
+}
+
+bool
+JitBlock::same_code(const vector<flat_instruction_type> &a, const vector<flat_instruction_type> &b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (a[i].op != b[i].op || a[i].sub_op != b[i].sub_op || a[i].arg != b[i].arg
+        || a[i].arg2 != b[i].arg2 || a[i].pos != b[i].pos
+        || memcmp(&a[i].value, &b[i].value, sizeof(double)))
+      return false;
+  return true;
+}
+
+JitBlock *
+JitBlock::get(const vector<flat_instruction_type> &instructions)
+{
+#ifdef BYTECODE_JIT
+  size_t h = checksum(instructions);
+  JitBlock *jb = NULL;
+  pair<multimap<size_t, list<Cache::entry_type>::iterator>::iterator,
+       multimap<size_t, list<Cache::entry_type>::iterator>::iterator> range = cache.index.equal_range(h);
+  multimap<size_t, list<Cache::entry_type>::iterator>::iterator it = range.first;
+  while (it != range.second && !same_code(it->second->instructions, instructions))
+    it++;
+  if (it != range.second)
+    {
+      cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+      jb = it->second->block;
+    }
+  else
+    {
+      // Failures are cached too, so that the compilation is not retried
+      jb = compile(instructions);
+      Cache::entry_type entry;
+      entry.checksum = h;
+      entry.instructions = instructions;
+      entry.block = jb;
+      cache.entries.push_front(entry);
+      cache.index.insert(make_pair(h, cache.entries.begin()));
+    }
+  if (jb)
+    jb->users++;
+  cache.trim();
+  return jb;
+#else
+  return NULL;
+#endif
+}
+
+void
+JitBlock::release(JitBlock *jb)
+{
+  if (!jb)
+    return;
+  jb->users--;
+  cache.trim();
+}
+
+#ifdef BYTECODE_JIT
+
+/* Functions called from the generated code. They must not throw: the
+   floating point errors are reported through the context, with the same
+   semantic as Evaluate::divide, pow1, log1 and log10_1. */
+
+static void
+jit_fp_error(jit_context_type *context)
+{
+  *context->res1 = NAN;
+  if (context->print_error)
+    context->stop = 1;
+}
+
+static double
+jit_divide(jit_context_type *context, double a, double b)
+{
+  double r = a / b;
+  if (isnan(r) || isinf(r))
+    {
+      jit_fp_error(context);
+      r = 1e70;
+    }
+  return r;
+}
+
+static double
+jit_pow(jit_context_type *context, double a, double b)
+{
+  double r = pow(a, b);
+  if (isnan(r) || isinf(r))
+    {
+      jit_fp_error(context);
+      r = 0.0000000000000000000000001;
+    }
+  return r;
+}
+
+static double
+jit_log(jit_context_type *context, double a)
+{
+  double r = log(a);
+  if (isnan(r) || isinf(r))
+    {
+      jit_fp_error(context);
+      r = -1e70;
+    }
+  return r;
+}
+
+static double
+jit_log10(jit_context_type *context, double a)
+{
+  // Same computation as Evaluate::log10_1
+  double r = log(a);
+  if (isnan(r) || isinf(r))
+    {
+      jit_fp_error(context);
+      r = -1e70;
+    }
+  return r;
+}
+
+static double
+jit_power_deriv(jit_context_type *context, double v1, double v2, double order)
+{
+  int derivOrder = int (nearbyint(order));
+  if (fabs(v1) < NEAR_ZERO && v2 > 0
+      && derivOrder > v2
+      && fabs(v2-nearbyint(v2)) < NEAR_ZERO)
+    return 0.0;
+  double dxp = jit_pow(context, v1, v2-derivOrder);
+  if (context->stop)
+    return dxp;
+  for (int i = 0; i < derivOrder; i++)
+    dxp *= v2--;
+  return dxp;
+}
+
+static double jit_less(double a, double b) { return double (a < b); }
+static double jit_greater(double a, double b) { return double (a > b); }
+static double jit_less_equal(double a, double b) { return double (a <= b); }
+static double jit_greater_equal(double a, double b) { return double (a >= b); }
+static double jit_equal_equal(double a, double b) { return double (a == b); }
+static double jit_different(double a, double b) { return double (a != b); }
+static double jit_max(double a, double b) { return max(a, b); }
+static double jit_min(double a, double b) { return min(a, b); }
+
+static double jit_exp(double a) { return exp(a); }
+static double jit_cos(double a) { return cos(a); }
+static double jit_sin(double a) { return sin(a); }
+static double jit_tan(double a) { return tan(a); }
+static double jit_acos(double a) { return acos(a); }
+static double jit_asin(double a) { return asin(a); }
+static double jit_atan(double a) { return atan(a); }
+static double jit_cosh(double a) { return cosh(a); }
+static double jit_sinh(double a) { return sinh(a); }
+static double jit_tanh(double a) { return tanh(a); }
+static double jit_acosh(double a) { return acosh(a); }
+static double jit_asinh(double a) { return asinh(a); }
+static double jit_atanh(double a) { return atanh(a); }
+static double jit_sqrt(double a) { return sqrt(a); }
+static double jit_erf(double a) { return erf(a); }
+
+static double
+jit_normcdf(double v1, double v2, double v3)
+{
+  return 0.5*(1+erf((v1-v2)/v3/M_SQRT2));
+}
+
+static double
+jit_normpdf(double v1, double v2, double v3)
+{
+  return 1/(v3*sqrt(2*M_PI)*exp(pow((v1-v2)/v3, 2)/2));
+}
+
+/* x86-64 code emitter.
+   Register usage in the generated function:
+   - rbx: pointer to the jit_context_type (first argument),
+   - r12: top of the value stack (second argument), which grows upward,
+   - rax, xmm0-xmm2: scratch. */
+class X86Emitter
+{
+public:
+  vector<uint8_t> buf;
+  void
+  bytes(const char *b, size_t n)
+  {
+    buf.insert(buf.end(), (const uint8_t *) b, (const uint8_t *) b + n);
+  }
+  void
+  u8(uint8_t v)
+  {
+    buf.push_back(v);
+  }
+  void
+  u32(uint32_t v)
+  {
+    for (int i = 0; i < 4; i++)
+      buf.push_back((v >> (8*i)) & 0xFF);
+  }
+  void
+  u64(uint64_t v)
+  {
+    for (int i = 0; i < 8; i++)
+      buf.push_back((v >> (8*i)) & 0xFF);
+  }
+  void
+  patch32(size_t at, uint32_t v)
+  {
+    for (int i = 0; i < 4; i++)
+      buf[at+i] = (v >> (8*i)) & 0xFF;
+  }
+  //! mov rax, [rbx+offset]
+  void
+  load_context_pointer(size_t offset)
+  {
+    bytes("\x48\x8B\x83", 3);
+    u32((uint32_t) offset);
+  }
+  //! push [rax+disp] on the value stack
+  void
+  push_from_rax(int disp)
+  {
+    bytes("\xF2\x0F\x10\x80", 4);           // movsd xmm0, [rax+disp32]
+    u32((uint32_t) disp);
+    bytes("\xF2\x41\x0F\x11\x04\x24", 6);   // movsd [r12], xmm0
+    bytes("\x49\x83\xC4\x08", 4);           // add r12, 8
+  }
+  //! pop the value stack into xmm0
+  void
+  pop_xmm0()
+  {
+    bytes("\x49\x83\xEC\x08", 4);           // sub r12, 8
+    bytes("\xF2\x41\x0F\x10\x04\x24", 6);   // movsd xmm0, [r12]
+  }
+  //! mov [rax+disp], xmm0
+  void
+  store_xmm0_to_rax(int disp)
+  {
+    bytes("\xF2\x0F\x11\x80", 4);
+    u32((uint32_t) disp);
+  }
+  //! xmm0 = [r12-8*k], xmm1 = ..., for k = 1, 2, 3
+  void
+  load_stack(int xmm, int k)
+  {
+    static const char modrm[3] = { 0x44, 0x4C, 0x54 };
+    bytes("\xF2\x41\x0F\x10", 4);
+    u8(modrm[xmm]);
+    u8(0x24);
+    u8((uint8_t) (-8*k));
+  }
+  //! [r12-8] = xmm0
+  void
+  store_stack_top()
+  {
+    bytes("\xF2\x41\x0F\x11\x44\x24\xF8", 7);
+  }
+  void
+  sub_stack(int n)
+  {
+    bytes("\x49\x83\xEC", 3);               // sub r12, 8*n
+    u8((uint8_t) (8*n));
+  }
+  //! mov rdi, rbx ; mov rax, function ; call rax
+  void
+  call(const void *function, bool with_context)
+  {
+    if (with_context)
+      bytes("\x48\x89\xDF", 3);
+    bytes("\x48\xB8", 2);
+    u64((uint64_t) (size_t) function);
+    bytes("\xFF\xD0", 2);
+  }
+  //! mov dword [rbx+offset], value ; jmp epilogue (returns the patch position)
+  size_t
+  exit(size_t offset, int value)
+  {
+    bytes("\xC7\x83", 2);
+    u32((uint32_t) offset);
+    u32((uint32_t) value);
+    u8(0xE9);
+    size_t at = buf.size();
+    u32(0);
+    return at;
+  }
+  //! Length of the sequence emitted by exit()
+  static const uint8_t exit_length = 15;
+  //! cmp byte [rbx+offset], 0
+  void
+  test_context_flag(size_t offset)
+  {
+    bytes("\x80\xBB", 2);
+    u32((uint32_t) offset);
+    u8(0);
+  }
+};
+
+JitBlock *
+JitBlock::compile(const vector<flat_instruction_type> &instructions)
+{
+  X86Emitter e;
+  // Position of each flat instruction in the machine code
+  vector<size_t> location(instructions.size());
+  // Jumps to flat instructions (patch position, target instruction)
+  vector<pair<size_t, size_t> > jumps;
+  // Jumps to the epilogue
+  vector<size_t> exits;
+
+  e.bytes("\x53", 1);                       // push rbx
+  e.bytes("\x41\x54", 2);                   // push r12
+  e.bytes("\x48\x83\xEC\x08", 4);           // sub rsp, 8 (keeps rsp aligned on 16 bytes for the calls)
+  e.bytes("\x48\x89\xFB", 3);               // mov rbx, rdi
+  e.bytes("\x49\x89\xF4", 3);               // mov r12, rsi
+
+  for (size_t i = 0; i < instructions.size(); i++)
+    {
+      const flat_instruction_type &fi = instructions[i];
+      /* The displacement of the loads and stores is a signed 32 bits
+         immediate: if it does not fit, the block is left to the flat
+         interpreter */
+      const int64_t disp64 = 8*(int64_t) fi.arg;
+      if (disp64 < INT_MIN || disp64 > INT_MAX)
+        return NULL;
+      const int disp = (int) disp64;
+      location[i] = e.buf.size();
+      bool may_fail = false;
+      switch (fi.op)
+        {
+        case FLAT_NUMEXPR:
+          e.bytes("\xC7\x83", 2);           // mov dword [rbx+numexpr_index], i
+          e.u32(offsetof(jit_context_type, numexpr_index));
+          e.u32((uint32_t) i);
+          break;
+        case FLAT_LDPARAM:
+          e.load_context_pointer(offsetof(jit_context_type, params));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDENDO:
+          e.load_context_pointer(offsetof(jit_context_type, yy_per));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDSENDO:
+          e.load_context_pointer(offsetof(jit_context_type, yy));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDSTEADY:
+          e.load_context_pointer(offsetof(jit_context_type, steady_y));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDEXO:
+          e.load_context_pointer(offsetof(jit_context_type, x_it));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDSEXO:
+          e.load_context_pointer(offsetof(jit_context_type, x));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDT:
+          e.load_context_pointer(offsetof(jit_context_type, T_it));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDST:
+          e.load_context_pointer(offsetof(jit_context_type, T));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDU:
+          e.load_context_pointer(offsetof(jit_context_type, u_per));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDSU:
+          e.load_context_pointer(offsetof(jit_context_type, u));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDR:
+          e.load_context_pointer(offsetof(jit_context_type, r));
+          e.push_from_rax(disp);
+          break;
+        case FLAT_LDC:
+          {
+            uint64_t bits;
+            memcpy(&bits, &fi.value, sizeof(bits));
+            e.bytes("\x48\xB8", 2);         // mov rax, value
+            e.u64(bits);
+            e.bytes("\x49\x89\x04\x24", 4); // mov [r12], rax
+            e.bytes("\x49\x83\xC4\x08", 4); // add r12, 8
+          }
+          break;
+        case FLAT_STPPARAM:
+        case FLAT_STPENDO:
+        case FLAT_STPSENDO:
+        case FLAT_STPEXO:
+        case FLAT_STPSEXO:
+        case FLAT_STPT:
+        case FLAT_STPST:
+        case FLAT_STPU:
+        case FLAT_STPSU:
+        case FLAT_STPR:
+        case FLAT_STPG:
+        case FLAT_STPJACOB:
+        case FLAT_STPJACOBOTHER:
+        case FLAT_STPJACOBEXO:
+        case FLAT_STPJACOBEXODET:
+        case FLAT_STPG2:
+          {
+            size_t offset = 0;
+            switch (fi.op)
+              {
+              case FLAT_STPPARAM:
+                offset = offsetof(jit_context_type, params);
+                break;
+              case FLAT_STPENDO:
+                offset = offsetof(jit_context_type, y_per);
+                break;
+              case FLAT_STPSENDO:
+                offset = offsetof(jit_context_type, y);
+                break;
+              case FLAT_STPEXO:
+                offset = offsetof(jit_context_type, x_it);
+                break;
+              case FLAT_STPSEXO:
+                offset = offsetof(jit_context_type, x);
+                break;
+              case FLAT_STPT:
+                offset = offsetof(jit_context_type, T_it);
+                break;
+              case FLAT_STPST:
+                offset = offsetof(jit_context_type, T);
+                break;
+              case FLAT_STPU:
+                offset = offsetof(jit_context_type, u_per);
+                break;
+              case FLAT_STPSU:
+                offset = offsetof(jit_context_type, u);
+                break;
+              case FLAT_STPR:
+                offset = offsetof(jit_context_type, r);
+                break;
+              case FLAT_STPG:
+                offset = offsetof(jit_context_type, g1);
+                break;
+              case FLAT_STPJACOB:
+              case FLAT_STPG2:
+                offset = offsetof(jit_context_type, jacob);
+                break;
+              case FLAT_STPJACOBOTHER:
+                offset = offsetof(jit_context_type, jacob_other_endo);
+                break;
+              case FLAT_STPJACOBEXO:
+                offset = offsetof(jit_context_type, jacob_exo);
+                break;
+              case FLAT_STPJACOBEXODET:
+                offset = offsetof(jit_context_type, jacob_exo_det);
+                break;
+              }
+            if (fi.op == FLAT_STPG2)
+              e.load_stack(0, 1);           // the value is left on the stack
+            else
+              e.pop_xmm0();
+            e.load_context_pointer(offset);
+            e.store_xmm0_to_rax(disp);
+          }
+          break;
+        case FLAT_BINARY:
+          if (fi.sub_op == oEqual)
+            {
+              e.sub_stack(2);
+              break;
+            }
+          e.load_stack(0, 2);
+          e.load_stack(1, 1);
+          e.sub_stack(1);
+          switch (fi.sub_op)
+            {
+            case oPlus:
+              e.bytes("\xF2\x0F\x58\xC1", 4); // addsd xmm0, xmm1
+              break;
+            case oMinus:
+              e.bytes("\xF2\x0F\x5C\xC1", 4); // subsd xmm0, xmm1
+              break;
+            case oTimes:
+              e.bytes("\xF2\x0F\x59\xC1", 4); // mulsd xmm0, xmm1
+              break;
+            case oDivide:
+              e.call((const void *) &jit_divide, true);
+              may_fail = true;
+              break;
+            case oPower:
+              e.call((const void *) &jit_pow, true);
+              may_fail = true;
+              break;
+            case oPowerDeriv:
+              // The derivation order is below the two operands
+              e.load_stack(2, 2);
+              e.sub_stack(1);
+              e.call((const void *) &jit_power_deriv, true);
+              may_fail = true;
+              break;
+            case oLess:
+              e.call((const void *) &jit_less, false);
+              break;
+            case oGreater:
+              e.call((const void *) &jit_greater, false);
+              break;
+            case oLessEqual:
+              e.call((const void *) &jit_less_equal, false);
+              break;
+            case oGreaterEqual:
+              e.call((const void *) &jit_greater_equal, false);
+              break;
+            case oEqualEqual:
+              e.call((const void *) &jit_equal_equal, false);
+              break;
+            case oDifferent:
+              e.call((const void *) &jit_different, false);
+              break;
+            case oMax:
+              e.call((const void *) &jit_max, false);
+              break;
+            case oMin:
+              e.call((const void *) &jit_min, false);
+              break;
+            default:
+              return NULL;
+            }
+          e.store_stack_top();
+          break;
+        case FLAT_UNARY:
+          if (fi.sub_op == oUminus)
+            {
+              e.bytes("\x48\xB8", 2);       // mov rax, sign bit
+              e.u64(0x8000000000000000ULL);
+              e.bytes("\x49\x31\x44\x24\xF8", 5); // xor [r12-8], rax
+              break;
+            }
+          e.load_stack(0, 1);
+          switch (fi.sub_op)
+            {
+            case oLog:
+              e.call((const void *) &jit_log, true);
+              may_fail = true;
+              break;
+            case oLog10:
+              e.call((const void *) &jit_log10, true);
+              may_fail = true;
+              break;
+            case oExp:
+              e.call((const void *) &jit_exp, false);
+              break;
+            case oCos:
+              e.call((const void *) &jit_cos, false);
+              break;
+            case oSin:
+              e.call((const void *) &jit_sin, false);
+              break;
+            case oTan:
+              e.call((const void *) &jit_tan, false);
+              break;
+            case oAcos:
+              e.call((const void *) &jit_acos, false);
+              break;
+            case oAsin:
+              e.call((const void *) &jit_asin, false);
+              break;
+            case oAtan:
+              e.call((const void *) &jit_atan, false);
+              break;
+            case oCosh:
+              e.call((const void *) &jit_cosh, false);
+              break;
+            case oSinh:
+              e.call((const void *) &jit_sinh, false);
+              break;
+            case oTanh:
+              e.call((const void *) &jit_tanh, false);
+              break;
+            case oAcosh:
+              e.call((const void *) &jit_acosh, false);
+              break;
+            case oAsinh:
+              e.call((const void *) &jit_asinh, false);
+              break;
+            case oAtanh:
+              e.call((const void *) &jit_atanh, false);
+              break;
+            case oSqrt:
+              e.call((const void *) &jit_sqrt, false);
+              break;
+            case oErf:
+              e.call((const void *) &jit_erf, false);
+              break;
+            default:
+              return NULL;
+            }
+          e.store_stack_top();
+          break;
+        case FLAT_TRINARY:
+          e.load_stack(0, 3);
+          e.load_stack(1, 2);
+          e.load_stack(2, 1);
+          e.sub_stack(2);
+          switch (fi.sub_op)
+            {
+            case oNormcdf:
+              e.call((const void *) &jit_normcdf, false);
+              break;
+            case oNormpdf:
+              e.call((const void *) &jit_normpdf, false);
+              break;
+            default:
+              return NULL;
+            }
+          e.store_stack_top();
+          break;
+        case FLAT_CUML:
+          e.load_stack(0, 1);
+          e.load_stack(1, 2);
+          e.sub_stack(1);
+          e.bytes("\xF2\x0F\x58\xC1", 4);   // addsd xmm0, xmm1
+          e.store_stack_top();
+          break;
+        case FLAT_ENDEQU:
+          e.test_context_flag(offsetof(jit_context_type, no_derivative));
+          e.u8(0x74);                       // je over the exit
+          e.u8(X86Emitter::exit_length);
+          exits.push_back(e.exit(offsetof(jit_context_type, exit_index), (int) i));
+          break;
+        case FLAT_ENDBLOCK:
+          exits.push_back(e.exit(offsetof(jit_context_type, exit_index), (int) i));
+          break;
+        case FLAT_JMPIFEVAL:
+          e.test_context_flag(offsetof(jit_context_type, evaluate));
+          e.bytes("\x0F\x85", 2);           // jne target
+          jumps.push_back(make_pair(e.buf.size(), (size_t) fi.arg));
+          e.u32(0);
+          break;
+        case FLAT_JMP:
+          e.u8(0xE9);                       // jmp target
+          jumps.push_back(make_pair(e.buf.size(), (size_t) fi.arg));
+          e.u32(0);
+          break;
+        case FLAT_OK:
+          // Debugging check of the legacy interpreter, not reproduced
+          break;
+        default:
+          return NULL;
+        }
+      if (may_fail)
+        {
+          e.test_context_flag(offsetof(jit_context_type, stop));
+          e.u8(0x74);                       // je over the exit
+          e.u8(X86Emitter::exit_length);
+          exits.push_back(e.exit(offsetof(jit_context_type, exit_index), (int) i));
+        }
+    }
+
+  size_t epilogue = e.buf.size();
+  e.bytes("\x48\x83\xC4\x08", 4);           // add rsp, 8
+  e.bytes("\x41\x5C", 2);                   // pop r12
+  e.bytes("\x5B", 1);                       // pop rbx
+  e.bytes("\xC3", 1);                       // ret
+
+  for (vector<pair<size_t, size_t> >::const_iterator it = jumps.begin(); it != jumps.end(); it++)
+    {
+      if (it->second >= location.size())
+        return NULL;
+      e.patch32(it->first, (uint32_t) (location[it->second] - (it->first + 4)));
+    }
+  for (vector<size_t>::const_iterator it = exits.begin(); it != exits.end(); it++)
+    e.patch32(*it, (uint32_t) (epilogue - (*it + 4)));
+
+  JitBlock *jb = new JitBlock(e.buf);
+  if (!jb->function)
+    {
+      delete jb;
+      return NULL;
+    }
+  return jb;
+}
+
+#else
+
+JitBlock *
+JitBlock::compile(const vector<flat_instruction_type> &instructions)
+{
+  return NULL;
+}
+
+#endif
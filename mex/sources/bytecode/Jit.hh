@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JIT_HH_INCLUDED
+#define JIT_HH_INCLUDED
+
+#include <vector>
+#include <map>
+#include <list>
+#include "Evaluate.hh"
+
+/* Native code generation is only available for the x86-64 System V ABI
+   (Linux, Mac OS X). On other platforms JitBlock::get always returns NULL and
+   the flat interpreter is used. */
+#if defined(__x86_64__) && !defined(_WIN32)
+# define BYTECODE_JIT
+#endif
+
+using namespace std;
+
+//! Data accessed by the generated code, filled by Evaluate before each call
+struct jit_context_type
+{
+  /* Base pointers already shifted by the current period:
+     yy_per = (ya or y)+it_*y_size, y_per = y+it_*y_size, x_it = x+it_, T_it = T+it_, u_per = u+Per_u_ */
+  double *yy_per, *yy, *y_per, *y, *steady_y, *x_it, *x, *T_it, *T, *u_per, *u, *r, *g1, *params;
+  double *jacob, *jacob_other_endo, *jacob_exo, *jacob_exo_det;
+  //! Points to Evaluate::res1, set to NaN on floating point errors
+  double *res1;
+  uint8_t evaluate, no_derivative, print_error;
+  //! Set when a floating point error has to stop the evaluation (print_error = true)
+  uint8_t stop;
+  //! Index of the flat instruction on which the code returned
+  int exit_index;
+  //! Index of the last FLAT_NUMEXPR instruction executed, -1 if none
+  int numexpr_index;
+};
+
+//! Native code of a block, generated from its flattened code
+class JitBlock
+{
+public:
+  /*! Returns the native code for the given flat code, compiling it if it is
+    not already in the cache. The cache is shared by all the calls to the MEX
+    in the process and is keyed by a checksum of the flat code, in which the
+    content of the .cod file and the dimensions of the problem are embedded.
+    Returns NULL if the code cannot be compiled. The returned block is pinned
+    in the cache until it is given back to release(). */
+  static JitBlock *get(const vector<flat_instruction_type> &instructions);
+  //! Unpins a block returned by get(), which may then be evicted from the cache
+  static void release(JitBlock *jb);
+  //! Runs the code with the given value stack, returns the index of the exit instruction
+  int run(jit_context_type &context, double *stack) const;
+  ~JitBlock();
+private:
+  typedef void (*jit_function_type)(jit_context_type *, double *);
+  JitBlock(const vector<uint8_t> &machine_code);
+  void *code;
+  size_t code_size;
+  jit_function_type function;
+  //! Number of get() not yet matched by a release()
+  int users;
+  static JitBlock *compile(const vector<flat_instruction_type> &instructions);
+  static size_t checksum(const vector<flat_instruction_type> &instructions);
+  static bool same_code(const vector<flat_instruction_type> &a, const vector<flat_instruction_type> &b);
+  /*! Owns the compiled blocks of the process. Only the max_blocks most
+    recently used blocks are kept (failed compilations included), so that
+    loops regenerating the .cod files do not accumulate native code; the
+    blocks still pinned by an Evaluate are never evicted. */
+  class Cache
+  {
+  public:
+    ~Cache();
+    struct entry_type
+    {
+      size_t checksum;
+      vector<flat_instruction_type> instructions;
+      JitBlock *block;
+    };
+    //! Most recently used first
+    list<entry_type> entries;
+    multimap<size_t, list<entry_type>::iterator> index;
+    //! Evicts the least recently used unpinned blocks beyond max_blocks
+    void trim();
+  };
+  static const size_t max_blocks = 64;
+  static Cache cache;
+};
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include "SparseLU.hh"
+
+const double SparseLU::pivot_tolerance = 0.1;
+
+SparseLU::SparseLU()
+{
+  n = 0;
+  factorized = false;
+  nb_symbolic = 0;
+  nb_numeric = 0;
+}
+
+bool
+SparseLU::same_pattern(int n_arg, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai) const
+{
+  if (n_arg != n || Ap[n] != A_p[n])
+    return false;
+  for (int k = 0; k <= n; k++)
+    if (Ap[k] != A_p[k])
+      return false;
+  for (SuiteSparse_long p = 0; p < Ap[n]; p++)
+    if (Ai[p] != A_i[p])
+      return false;
+  return true;
+}
+
+bool
+SparseLU::factorize(int n_arg, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax)
+{
+  if (factorized && same_pattern(n_arg, Ap, Ai))
+    {
+      if (refactorize(Ap, Ai, Ax))
+        {
+          nb_numeric++;
+          return true;
+        }
+    }
+  else
+    {
+      n = n_arg;
+      A_p.assign(Ap, Ap + n + 1);
+      A_i.assign(Ai, Ai + Ap[n]);
+    }
+  factorized = full_factorize(Ap, Ai, Ax);
+  if (factorized)
+    nb_symbolic++;
+  return factorized;
+}
+
+int
+SparseLU::reach(int k, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai)
+{
+  int top = n;
+  for (SuiteSparse_long p = Ap[k]; p < Ap[k+1]; p++)
+    {
+      if (mark[Ai[p]] == k)
+        continue;
+      // Non recursive depth-first search in the graph of L, starting from row Ai[p]
+      int head = 0;
+      stk[0] = Ai[p];
+      while (head >= 0)
+        {
+          int i = stk[head];
+          int j = pinv[i];
+          if (mark[i] != k)
+            {
+              mark[i] = k;
+              pstk[head] = (j < 0) ? 0 : Lp[j];
+            }
+          bool done = true;
+          int pend = (j < 0) ? 0 : Lp[j+1];
+          for (int q = pstk[head]; q < pend; q++)
+            {
+              int r = Li[q];
+              if (mark[r] == k)
+                continue;
+              pstk[head] = q+1;
+              stk[++head] = r;
+              done = false;
+              break;
+            }
+          if (done)
+            {
+              head--;
+              xi[--top] = i;
+            }
+        }
+    }
+  return top;
+}
+
+bool
+SparseLU::full_factorize(const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax)
+{
+  Lp.clear();
+  Li.clear();
+  Lx.clear();
+  Up.clear();
+  Ui.clear();
+  Ux.clear();
+  Lp.push_back(0);
+  Up.push_back(0);
+  pinv.assign(n, -1);
+  prow.assign(n, -1);
+  x.assign(n, 0.0);
+  xi.resize(n);
+  stk.resize(n);
+  pstk.resize(n);
+  mark.assign(n, -1);
+  for (int k = 0; k < n; k++)
+    {
+      int top = reach(k, Ap, Ai);
+      for (int px = top; px < n; px++)
+        x[xi[px]] = 0;
+      for (SuiteSparse_long p = Ap[k]; p < Ap[k+1]; p++)
+        x[Ai[p]] = Ax[p];
+      // Sparse triangular solve with the columns of L already computed
+      for (int px = top; px < n; px++)
+        {
+          int j = pinv[xi[px]];
+          if (j < 0)
+            continue;
+          double ujk = x[xi[px]];
+          for (int q = Lp[j]; q < Lp[j+1]; q++)
+            x[Li[q]] -= Lx[q] * ujk;
+        }
+      int ipiv = -1;
+      double amax = 0;
+      for (int px = top; px < n; px++)
+        {
+          int i = xi[px];
+          if (pinv[i] < 0)
+            {
+              if (fabs(x[i]) > amax)
+                {
+                  amax = fabs(x[i]);
+                  ipiv = i;
+                }
+            }
+          else
+            {
+              Ui.push_back(pinv[i]);
+              Ux.push_back(x[i]);
+            }
+        }
+      if (ipiv < 0)
+        return false;
+      // The diagonal element is preferred if it is large enough
+      if (pinv[k] < 0 && mark[k] == k && fabs(x[k]) >= pivot_tolerance * amax)
+        ipiv = k;
+      double pivot = x[ipiv];
+      Ui.push_back(k);
+      Ux.push_back(pivot);
+      Up.push_back(Ui.size());
+      pinv[ipiv] = k;
+      prow[k] = ipiv;
+      for (int px = top; px < n; px++)
+        {
+          int i = xi[px];
+          if (pinv[i] < 0)
+            {
+              Li.push_back(i);
+              Lx.push_back(x[i] / pivot);
+            }
+        }
+      Lp.push_back(Li.size());
+    }
+  return true;
+}
+
+bool
+SparseLU::refactorize(const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax)
+{
+  for (int k = 0; k < n; k++)
+    {
+      int diag = Up[k+1]-1;
+      for (int p = Up[k]; p < diag; p++)
+        x[prow[Ui[p]]] = 0;
+      x[prow[k]] = 0;
+      for (int q = Lp[k]; q < Lp[k+1]; q++)
+        x[Li[q]] = 0;
+      for (SuiteSparse_long p = Ap[k]; p < Ap[k+1]; p++)
+        x[Ai[p]] = Ax[p];
+      for (int p = Up[k]; p < diag; p++)
+        {
+          int j = Ui[p];
+          double ujk = x[prow[j]];
+          Ux[p] = ujk;
+          for (int q = Lp[j]; q < Lp[j+1]; q++)
+            x[Li[q]] -= Lx[q] * ujk;
+        }
+      double pivot = x[prow[k]];
+      double amax = fabs(pivot);
+      for (int q = Lp[k]; q < Lp[k+1]; q++)
+        if (fabs(x[Li[q]]) > amax)
+          amax = fabs(x[Li[q]]);
+      if (pivot == 0 || fabs(pivot) < pivot_tolerance * amax)
+        return false;
+      Ux[diag] = pivot;
+      for (int q = Lp[k]; q < Lp[k+1]; q++)
+        Lx[q] = x[Li[q]] / pivot;
+    }
+  return true;
+}
+
+void
+SparseLU::solve(double *b)
+{
+  for (int i = 0; i < n; i++)
+    x[i] = b[i];
+  // Forward substitution: L*z = P*b, z is stored in b
+  for (int k = 0; k < n; k++)
+    {
+      double zk = x[prow[k]];
+      b[k] = zk;
+      for (int q = Lp[k]; q < Lp[k+1]; q++)
+        x[Li[q]] -= Lx[q] * zk;
+    }
+  // Backward substitution: U*x = z
+  for (int k = n-1; k >= 0; k--)
+    {
+      int diag = Up[k+1]-1;
+      b[k] /= Ux[diag];
+      for (int p = Up[k]; p < diag; p++)
+        b[Ui[p]] -= Ux[p] * b[k];
+    }
+}
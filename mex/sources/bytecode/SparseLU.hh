@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPARSELU_HH_INCLUDED
+#define SPARSELU_HH_INCLUDED
+
+#include <vector>
+#if !(defined _MSC_VER)
+# include "dynumfpack.h"
+#else
+# include <stdint.h>
+typedef int64_t SuiteSparse_long;
+#endif
+
+using namespace std;
+
+/*! Sparse LU factorization of a square matrix in compressed sparse column
+  form (the format built by dynSparseMatrix::Init_UMFPACK_Sparse), with
+  threshold partial pivoting (P*A = L*U, no column permutation).
+
+  The factors are stored in contiguous CSC arrays. The first factorization
+  computes the nonzero patterns of L and U and the pivot sequence (left-looking
+  Gilbert-Peierls algorithm). As long as the pattern of the matrix does not
+  change, the next factorizations only recompute the values of L and U over
+  these patterns, with the same pivots. A complete factorization is done again
+  if the pattern changes or if one of the pivots becomes too small. */
+class SparseLU
+{
+public:
+  SparseLU();
+  /*! Factorizes the n x n matrix (Ap, Ai, Ax).
+    Returns false if the matrix is numerically singular. */
+  bool factorize(int n, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax);
+  //! Solves A*x = b, b is overwritten by x
+  void solve(double *b);
+  //! Number of complete factorizations (with pivot search)
+  int get_nb_symbolic() const
+  {
+    return nb_symbolic;
+  };
+  //! Number of numerical refactorizations reusing the symbolic analysis
+  int get_nb_numeric() const
+  {
+    return nb_numeric;
+  };
+  //! Number of nonzero elements in L+U
+  size_t get_nnz() const
+  {
+    return Li.size() + Ui.size();
+  };
+private:
+  //! Relative threshold used to accept a pivot (with respect to the largest element of the column)
+  static const double pivot_tolerance;
+  bool full_factorize(const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax);
+  bool refactorize(const SuiteSparse_long *Ap, const SuiteSparse_long *Ai, const double *Ax);
+  bool same_pattern(int n_arg, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai) const;
+  //! Computes in xi[top..n-1] the rows reachable from the nonzeros of column k of A, in topological order
+  int reach(int k, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai);
+  int n;
+  bool factorized;
+  int nb_symbolic, nb_numeric;
+  //! Pattern of the factorized matrix
+  vector<SuiteSparse_long> A_p, A_i;
+  /*! Strictly lower part of L (the diagonal is unit), with the row indices of
+    the original matrix */
+  vector<int> Lp, Li;
+  vector<double> Lx;
+  /*! U with the row indices in pivotal order. In each column, the entries are
+    stored in topological order and the diagonal comes last */
+  vector<int> Up, Ui;
+  vector<double> Ux;
+  //! pinv[i] is the step at which row i has been chosen as pivot, prow is its inverse
+  vector<int> pinv, prow;
+  //! Workspaces
+  vector<double> x;
+  vector<int> xi, stk, pstk, mark;
+};
+
+#endif
@@ -22,6 +22,7 @@
 
 #include <cstring>
 #include <ctime>
+#include <algorithm>
 #include <sstream>
 //#include <gsl/gsl_min.h>
 //#include <minimize.h>
@@ -40,6 +41,8 @@ HINSTANCE hinstLib;
 #define UMFPACK_CONTROL 20
 /* used in all UMFPACK_report_* routines: */
 #define UMFPACK_PRL 0			/* print level */
+/* used in umfpack_*_solve: */
+#define UMFPACK_IRSTEP 7		/* max # of iterative refinements */
 /* returned by all routines that use Info: */
 #define UMFPACK_OK (0)
 #define UMFPACK_STATUS 0	/* UMFPACK_OK, or other result */
@@ -92,6 +95,8 @@ t_umfpack_dl_defaults umfpack_dl_defaults;
 dynSparseMatrix::dynSparseMatrix()
 {
   pivotva = NULL;
+  SaveCode = NULL;
+  SaveCode_pos = 0;
   g_save_op = NULL;
   g_nop_all = 0;
   mem_mngr.init_Mem();
@@ -106,8 +111,7 @@ dynSparseMatrix::dynSparseMatrix()
   restart = 0;
   IM_i.clear();
   lu_inc_tol = 1e-10;
-  Symbolic = NULL;
-  Numeric = NULL;
+  simplified_newton = 0;
 #ifdef _MSC_VER
   // Get a handle to the DLL module.
   hinstLib = LoadLibrary(TEXT("libmwumfpack.dll"));
@@ -191,6 +195,8 @@ dynSparseMatrix::dynSparseMatrix(const int y_size_arg, const int y_kmin_arg, con
   Evaluate(y_size_arg, y_kmin_arg, y_kmax_arg, print_it_arg, steady_state_arg, periods_arg, minimal_solving_periods_arg, slowc_arg)
 {
   pivotva = NULL;
+  SaveCode = NULL;
+  SaveCode_pos = 0;
   g_save_op = NULL;
   g_nop_all = 0;
   mem_mngr.init_Mem();
@@ -205,8 +211,7 @@ dynSparseMatrix::dynSparseMatrix(const int y_size_arg, const int y_kmin_arg, con
   restart = 0;
   IM_i.clear();
   lu_inc_tol = 1e-10;
-  Symbolic = NULL;
-  Numeric = NULL;
+  simplified_newton = 0;
 #ifdef CUDA
   CUDA_device = CUDA_device_arg;
   cublas_handle = cublas_handle_arg;
@@ -520,7 +525,21 @@ dynSparseMatrix::Insert(const int r, const int c, const int u_index, const int l
 void
 dynSparseMatrix::Close_SaveCode()
 {
-  SaveCode.close();
+  SaveCode = NULL;
+  SaveCode_pos = 0;
+}
+
+void
+dynSparseMatrix::Read_SaveCode(void *dest, size_t size)
+{
+  if (SaveCode_pos + size > SaveCode->size)
+    {
+      ostringstream tmp;
+      tmp << " in Read_SparseMatrix, " << filename << (steady_state ? "_static.bin" : "_dynamic.bin") << " is truncated\n";
+      throw FatalExceptionHandling(tmp.str());
+    }
+  memcpy(dest, SaveCode->data + SaveCode_pos, size);
+  SaveCode_pos += size;
 }
 
 void
@@ -532,13 +551,14 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
   mem_mngr.fixe_file_name(file_name);
   /*mexPrintf("steady_state=%d, size=%d, solve_algo=%d, stack_solve_algo=%d, two_boundaries=%d\n",steady_state, Size, solve_algo, stack_solve_algo, two_boundaries);
   mexEvalString("drawnow;");*/
-  if (!SaveCode.is_open())
+  if (!SaveCode)
     {
       if (steady_state)
-        SaveCode.open((file_name + "_static.bin").c_str(), ios::in | ios::binary);
+        SaveCode = LoadedFile::get(file_name + "_static.bin");
       else
-        SaveCode.open((file_name + "_dynamic.bin").c_str(), ios::in | ios::binary);
-      if (!SaveCode.is_open())
+        SaveCode = LoadedFile::get(file_name + "_dynamic.bin");
+      SaveCode_pos = 0;
+      if (!SaveCode)
         {
           ostringstream tmp;
           if (steady_state)
@@ -556,24 +576,24 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
           for (int i = 0; i < u_count_init-Size; i++)
             {
               int val;
-              SaveCode.read(reinterpret_cast<char *>(&eq), sizeof(eq));
-              SaveCode.read(reinterpret_cast<char *>(&var), sizeof(var));
-              SaveCode.read(reinterpret_cast<char *>(&lag), sizeof(lag));
-              SaveCode.read(reinterpret_cast<char *>(&val), sizeof(val));
+              Read_SaveCode(&eq, sizeof(eq));
+              Read_SaveCode(&var, sizeof(var));
+              Read_SaveCode(&lag, sizeof(lag));
+              Read_SaveCode(&val, sizeof(val));
               IM_i[make_pair(make_pair(eq, var), lag)] = val;
             }
           for (int j = 0; j < Size; j++)
             IM_i[make_pair(make_pair(j, Size*(periods+y_kmax)), 0)] = j;
         }
-      else if (stack_solve_algo >= 0 && stack_solve_algo <= 4)
+      else if ((stack_solve_algo >= 0 && stack_solve_algo <= 4) || stack_solve_algo == 8 || stack_solve_algo == 9)
         {
           for (int i = 0; i < u_count_init-Size; i++)
             {
               int val;
-              SaveCode.read(reinterpret_cast<char *>(&eq), sizeof(eq));
-              SaveCode.read(reinterpret_cast<char *>(&var), sizeof(var));
-              SaveCode.read(reinterpret_cast<char *>(&lag), sizeof(lag));
-              SaveCode.read(reinterpret_cast<char *>(&val), sizeof(val));
+              Read_SaveCode(&eq, sizeof(eq));
+              Read_SaveCode(&var, sizeof(var));
+              Read_SaveCode(&lag, sizeof(lag));
+              Read_SaveCode(&val, sizeof(val));
               IM_i[make_pair(make_pair(var - lag*Size, -lag), eq)] = val;
             }
           for (int j = 0; j < Size; j++)
@@ -584,10 +604,10 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
           for (int i = 0; i < u_count_init-Size; i++)
             {
               int val;
-              SaveCode.read(reinterpret_cast<char *>(&eq), sizeof(eq));
-              SaveCode.read(reinterpret_cast<char *>(&var), sizeof(var));
-              SaveCode.read(reinterpret_cast<char *>(&lag), sizeof(lag));
-              SaveCode.read(reinterpret_cast<char *>(&val), sizeof(val));
+              Read_SaveCode(&eq, sizeof(eq));
+              Read_SaveCode(&var, sizeof(var));
+              Read_SaveCode(&lag, sizeof(lag));
+              Read_SaveCode(&val, sizeof(val));
               IM_i[make_pair(make_pair(eq, lag), var - lag * Size)] = val;
             }
           for (int j = 0; j < Size; j++)
@@ -601,10 +621,10 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
           for (int i = 0; i < u_count_init; i++)
             {
               int val;
-              SaveCode.read(reinterpret_cast<char *>(&eq), sizeof(eq));
-              SaveCode.read(reinterpret_cast<char *>(&var), sizeof(var));
-              SaveCode.read(reinterpret_cast<char *>(&lag), sizeof(lag));
-              SaveCode.read(reinterpret_cast<char *>(&val), sizeof(val));
+              Read_SaveCode(&eq, sizeof(eq));
+              Read_SaveCode(&var, sizeof(var));
+              Read_SaveCode(&lag, sizeof(lag));
+              Read_SaveCode(&val, sizeof(val));
               IM_i[make_pair(make_pair(eq, var), lag)] = val;
             }
         }
@@ -613,17 +633,17 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
           for (int i = 0; i < u_count_init; i++)
             {
               int val;
-              SaveCode.read(reinterpret_cast<char *>(&eq), sizeof(eq));
-              SaveCode.read(reinterpret_cast<char *>(&var), sizeof(var));
-              SaveCode.read(reinterpret_cast<char *>(&lag), sizeof(lag));
-              SaveCode.read(reinterpret_cast<char *>(&val), sizeof(val));
+              Read_SaveCode(&eq, sizeof(eq));
+              Read_SaveCode(&var, sizeof(var));
+              Read_SaveCode(&lag, sizeof(lag));
+              Read_SaveCode(&val, sizeof(val));
               IM_i[make_pair(make_pair(var - lag*Size, -lag), eq)] = val;
             }
         }
     }
   index_vara = (int *) mxMalloc(Size*(periods+y_kmin+y_kmax)*sizeof(int));
   for (int j = 0; j < Size; j++)
-    SaveCode.read(reinterpret_cast<char *>(&index_vara[j]), sizeof(*index_vara));
+    Read_SaveCode(&index_vara[j], sizeof(*index_vara));
   if (periods+y_kmin+y_kmax > 1)
     for (int i = 1; i < periods+y_kmin+y_kmax; i++)
       {
@@ -632,7 +652,7 @@ dynSparseMatrix::Read_SparseMatrix(string file_name, const int Size, int periods
       }
   index_equa = (int *) mxMalloc(Size*sizeof(int));
   for (int j = 0; j < Size; j++)
-    SaveCode.read(reinterpret_cast<char *>(&index_equa[j]), sizeof(*index_equa));
+    Read_SaveCode(&index_equa[j], sizeof(*index_equa));
 }
 
 void
@@ -3240,13 +3260,25 @@ dynSparseMatrix::Solve_Matlab_LU_UMFPack(mxArray *A_m, mxArray *b_m, int Size, d
   mxDestroyArray(z);
 }
 
+dynSparseMatrix::~dynSparseMatrix()
+{
+  for (map<int, umfpack_factorization_type>::iterator it = umfpack_factorizations.begin(); it != umfpack_factorizations.end(); it++)
+    {
+      if (it->second.Symbolic)
+        umfpack_dl_free_symbolic(&it->second.Symbolic);
+      if (it->second.Numeric)
+        umfpack_dl_free_numeric(&it->second.Numeric);
+    }
+}
+
 void
 dynSparseMatrix::End_Matlab_LU_UMFPack()
 {
-  if (Symbolic)
-    umfpack_dl_free_symbolic (&Symbolic) ;
-  if (Numeric)
-    umfpack_dl_free_numeric (&Numeric) ;
+  /* The symbolic analysis of the block is kept for its next simulation (next
+     step of an extended path), only its numeric factorization is released */
+  map<int, umfpack_factorization_type>::iterator it = umfpack_factorizations.find(block_num);
+  if (it != umfpack_factorizations.end() && it->second.Numeric)
+    umfpack_dl_free_numeric(&it->second.Numeric);
 }
 
 
@@ -3284,25 +3316,48 @@ dynSparseMatrix::Print_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, doubl
         mexPrintf("(%d, %d)    %f\n", Ai[j]+1, i+1, Ax[k++]);
 }
 
+static size_t
+pattern_checksum(int n, const SuiteSparse_long *Ap, const SuiteSparse_long *Ai)
+{
+  // FNV-1a hash of the column pointers and row indices
+  size_t h = 2166136261U;
+  for (int k = 0; k <= n; k++)
+    h = (h ^ size_t (Ap[k])) * 16777619U;
+  for (SuiteSparse_long p = 0; p < Ap[n]; p++)
+    h = (h ^ size_t (Ai[p])) * 16777619U;
+  return h;
+}
+
 void
-dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, vector_table_conditional_local_type vector_table_conditional_local)
+dynSparseMatrix::Solve_UMFPack_System(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, double *res, int n, int Size, bool is_two_boundaries, int  it_, bool simplified_newton_allowed)
 {
   SuiteSparse_long status, sys = 0;
 #ifndef _MSC_VER
-  double Control [UMFPACK_CONTROL], Info [UMFPACK_INFO], res [n];
+  double Control [UMFPACK_CONTROL], Info [UMFPACK_INFO];
 #else
-  double *Control, *Info, *res;
+  double *Control, *Info;
   Control = (double*)mxMalloc(UMFPACK_CONTROL * sizeof(double));
   Info = (double*)mxMalloc(UMFPACK_INFO * sizeof(double));
-  res = (double*)mxMalloc(n * sizeof(double));
 #endif
 
   umfpack_dl_defaults(Control);
   Control [UMFPACK_PRL] = 5;
-  status = 0;
-  if (iter == 0)
-    {
-      status = umfpack_dl_symbolic(n, n, Ap, Ai, Ax, &Symbolic, Control, Info);
+  /* The sparsity pattern of the jacobian of a block does not change across
+     the Newton iterations, the periods of a one boundary block and the steps
+     of an extended path: its symbolic analysis is done once and kept until
+     the pattern changes */
+  umfpack_factorization_type &fact = umfpack_factorizations[block_num];
+  size_t hash = pattern_checksum(n, Ap, Ai);
+  bool same_pattern = fact.Symbolic && fact.n == n && fact.hash == hash
+    && equal(Ap, Ap + n + 1, fact.Ap.begin())
+    && equal(Ai, Ai + Ap[n], fact.Ai.begin());
+  if (!same_pattern)
+    {
+      if (fact.Symbolic)
+        umfpack_dl_free_symbolic(&fact.Symbolic);
+      if (fact.Numeric)
+        umfpack_dl_free_numeric(&fact.Numeric);
+      status = umfpack_dl_symbolic(n, n, Ap, Ai, Ax, &fact.Symbolic, Control, Info);
       if (status < 0)
         {
           umfpack_dl_report_info(Control, Info);
@@ -3311,19 +3366,60 @@ dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, do
           Error << " umfpack_dl_symbolic failed\n";
           throw FatalExceptionHandling(Error.str());
         }
+      fact.n = n;
+      fact.hash = hash;
+      fact.Ap.assign(Ap, Ap + n + 1);
+      fact.Ai.assign(Ai, Ai + Ap[n]);
+      fact.nb_symbolic++;
+    }
+  /* Simplified Newton: the numeric factorization of the first iteration is
+     reused for simplified_newton iterations */
+  bool reuse_numeric = simplified_newton_allowed && simplified_newton > 0 && iter > 0
+    && fact.Numeric && fact.numeric_age < simplified_newton;
+  if (!reuse_numeric)
+    {
+      if (fact.Numeric)
+        umfpack_dl_free_numeric(&fact.Numeric);
+      status = umfpack_dl_numeric(Ap, Ai, Ax, fact.Symbolic, &fact.Numeric, Control, Info);
+      if (status < 0)
+        {
+          umfpack_dl_report_info(Control, Info);
+          umfpack_dl_report_status(Control, status);
+          ostringstream  Error;
+          Error << " umfpack_dl_numeric failed\n";
+          throw FatalExceptionHandling(Error.str());
+        }
+      if (simplified_newton > 0)
+        fact.Ax.assign(Ax, Ax + Ap[n]);
+      fact.numeric_age = 0;
+      fact.nb_numeric++;
     }
-  if (iter > 0)
-    umfpack_dl_free_numeric(&Numeric) ;
-  status = umfpack_dl_numeric (Ap, Ai, Ax, Symbolic, &Numeric, Control, Info);
-  if (status < 0)
+  else
     {
-      umfpack_dl_report_info(Control, Info);
-      umfpack_dl_report_status(Control, status);
-      ostringstream  Error;
-      Error << " umfpack_dl_numeric failed\n";
-      throw FatalExceptionHandling(Error.str());
+      /* The linear system is J*z = b with b = F-J*y, z = -y_new and F the
+         residuals: the compiled code of a block subtracts the terms of its
+         own variables from the residuals (the contemporaneous ones for a
+         one boundary block), and Init_UMFPACK_Sparse adds back those lying
+         outside the stacked periods of a two boundaries block. With the
+         factorized jacobian J0, only the residuals are kept, the right hand
+         side becomes F-J0*y = b+(J-J0)*y, so that y_new = y-J0^{-1}*F.
+         y is read where Update_Newton_Step writes it: in the stacked periods
+         of a two boundaries block, in period it_ of a one boundary block */
+      for (int j = 0; j < n; j++)
+        {
+          double yj;
+          if (is_two_boundaries)
+            yj = y[index_vara[j+Size*y_kmin]];
+          else
+            yj = y[index_vara[j]+it_*y_size];
+          for (SuiteSparse_long p = Ap[j]; p < Ap[j+1]; p++)
+            b[Ai[p]] += (Ax[p] - fact.Ax[p]) * yj;
+        }
+      // No iterative refinement: it would be done with J instead of J0
+      Control [UMFPACK_IRSTEP] = 0;
+      fact.numeric_age++;
     }
-  status = umfpack_dl_solve(sys, Ap, Ai, Ax, res, b, Numeric, Control, Info);
+  status = umfpack_dl_solve(sys, Ap, Ai, reuse_numeric ? &fact.Ax[0] : Ax, res, b, fact.Numeric, Control, Info);
   if (status != UMFPACK_OK)
     {
       umfpack_dl_report_info(Control, Info);
@@ -3332,55 +3428,77 @@ dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, do
       Error << " umfpack_dl_solve failed\n";
       throw FatalExceptionHandling(Error.str());
     }
+  if (print_it)
+    mexPrintf("UMFPACK: %d symbolic analysis(es), %d numeric factorization(s)%s\n",
+              fact.nb_symbolic, fact.nb_numeric, reuse_numeric ? ", simplified Newton step" : "");
+#ifdef _MSC_VER
+  mxFree(Control);
+  mxFree(Info);
+#endif
+}
 
-  if (vector_table_conditional_local.size())
+void
+dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, vector_table_conditional_local_type vector_table_conditional_local)
+{
+#ifndef _MSC_VER
+  double res [n];
+#else
+  double *res = (double*)mxMalloc(n * sizeof(double));
+#endif
+  // The columns of the conditioned variables do not follow b = F-J*y, they exclude the simplified Newton step
+  Solve_UMFPack_System(Ap, Ai, Ax, b, res, n, Size, is_two_boundaries, it_, vector_table_conditional_local.size() == 0);
+  Update_Newton_Step(res, n, Size, slowc_l, is_two_boundaries, it_, vector_table_conditional_local);
+  mxFree(Ap);
+  mxFree(Ai);
+  mxFree(Ax);
+  mxFree(b);
+#ifdef _MSC_VER
+  mxFree(res);
+#endif
+}
+
+void
+dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_)
+{
+  Solve_LU_UMFPack(Ap, Ai, Ax, b, n, Size, slowc_l, is_two_boundaries, it_, vector_table_conditional_local_type());
+}
+
+
+void
+dynSparseMatrix::Update_Newton_Step(const double *res, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, vector_table_conditional_local_type &vector_table_conditional_local)
+{
+  if (is_two_boundaries)
     {
-      if (is_two_boundaries)
-        for (int t = 0; t < n / Size; t++)
-          if (t == 0)
+      if (vector_table_conditional_local.size())
+        {
+          for (int i = 0; i < Size; i++)
             {
-              for (int i = 0; i < Size; i++)
+              bool fliped = vector_table_conditional_local[i].is_cond;
+              if (fliped)
                 {
-                  bool fliped = vector_table_conditional_local[i].is_cond;
-                  if (fliped)
-                    {
-                      int eq = index_vara[i+Size*(y_kmin)];
-                      int flip_exo = vector_table_conditional_local[i].var_exo;
-                      double  yy = -(res[i] + x[y_kmin + flip_exo*/*row_x*/nb_row_x]);
-                      direction[eq] = 0;
-                      x[flip_exo*/*row_x*/nb_row_x + y_kmin] += slowc_l * yy;
-                    }
-                  else
-                    {
-                      int eq = index_vara[i+Size*(y_kmin)];
-                      double yy = -(res[i ] + y[eq]);
-                      direction[eq] = yy;
-                      y[eq] += slowc_l * yy;
-                    }
+                  int eq = index_vara[i+Size*(y_kmin)];
+                  int flip_exo = vector_table_conditional_local[i].var_exo;
+                  double  yy = -(res[i] + x[y_kmin + flip_exo*nb_row_x]);
+                  direction[eq] = 0;
+                  x[flip_exo*nb_row_x + y_kmin] += slowc_l * yy;
                 }
-            }
-          else
-            {
-              for (int i = 0; i < Size; i++)
+              else
                 {
-                  int eq = index_vara[i+Size*(t + y_kmin)];
-                  double yy = -(res[i + Size * t] + y[eq]);
+                  int eq = index_vara[i+Size*(y_kmin)];
+                  double yy = -(res[i] + y[eq]);
                   direction[eq] = yy;
                   y[eq] += slowc_l * yy;
                 }
             }
+          for (int i = Size; i < n; i++)
+            {
+              int eq = index_vara[i+Size*y_kmin];
+              double yy = -(res[i] + y[eq]);
+              direction[eq] = yy;
+              y[eq] += slowc_l * yy;
+            }
+        }
       else
-        for (int i = 0; i < n; i++)
-          {
-            int eq = index_vara[i];
-            double yy = -(res[i] + y[eq+it_*y_size]);
-            direction[eq] = yy;
-            y[eq+it_*y_size] += slowc_l * yy;
-          }
-    }
-  else
-    {
-      if (is_two_boundaries)
         for (int i = 0; i < n; i++)
           {
             int eq = index_vara[i+Size*y_kmin];
@@ -3388,105 +3506,101 @@ dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, do
             direction[eq] = yy;
             y[eq] += slowc_l * yy;
           }
-      else
-        for (int i = 0; i < n; i++)
-          {
-            int eq = index_vara[i];
-            double yy = -(res[i] + y[eq+it_*y_size]);
-            direction[eq] = yy;
-            y[eq+it_*y_size] += slowc_l * yy;
-          }
+    }
+  else
+    for (int i = 0; i < n; i++)
+      {
+        int eq = index_vara[i];
+        double yy = -(res[i] + y[eq+it_*y_size]);
+        direction[eq] = yy;
+        y[eq+it_*y_size] += slowc_l * yy;
       }
-  
+}
+
+void
+dynSparseMatrix::Solve_Sparse_LU(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, int block_num, vector_table_conditional_local_type vector_table_conditional_local)
+{
+  /* The factorization of a block is kept from one call to the other: the
+     sparsity pattern of its Jacobian does not change across the Newton
+     iterations nor, for one boundary blocks, across periods */
+  SparseLU &lu = sparse_lu[block_num];
+  if (!lu.factorize(n, Ap, Ai, Ax))
+    {
+      ostringstream  Error;
+      Error << " in Solve_Sparse_LU, singular Jacobian in block " << block_num+1 << "\n";
+      throw FatalExceptionHandling(Error.str());
+    }
+  lu.solve(b);
+  Update_Newton_Step(b, n, Size, slowc_l, is_two_boundaries, it_, vector_table_conditional_local);
+  if (print_it)
+    mexPrintf("Sparse LU: %d complete factorization(s), %d numerical refactorization(s), nnz(L+U)=%d\n",
+              lu.get_nb_symbolic(), lu.get_nb_numeric(), int (lu.get_nnz()));
   mxFree(Ap);
   mxFree(Ai);
   mxFree(Ax);
   mxFree(b);
-#ifdef _MSC_VER
-  mxFree(Control);
-  mxFree(Info);
-  mxFree(res);
-#endif
 }
 
-
 void
-dynSparseMatrix::Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_)
+dynSparseMatrix::Solve_Band_LU(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, int block_num, vector_table_conditional_local_type vector_table_conditional_local)
 {
-  SuiteSparse_long status, sys = 0;
-#ifndef _MSC_VER
-  double Control [UMFPACK_CONTROL], Info [UMFPACK_INFO], res [n];
-#else
-  double *Control, *Info, *res;
-  Control = (double*)mxMalloc(UMFPACK_CONTROL * sizeof(double));
-  Info = (double*)mxMalloc(UMFPACK_INFO * sizeof(double));
-  res = (double*)mxMalloc(n * sizeof(double));
-#endif
-
-  umfpack_dl_defaults(Control);
-  Control [UMFPACK_PRL] = 5;
-  status = 0;
-  if (iter == 0)
+  /* The stacked Jacobian of a two boundaries block is block-banded: the
+     equations of period t only involve the variables of periods t-y_kmin to
+     t+y_kmax. Its lower and upper bandwidths are computed from its pattern and
+     it is solved as a band matrix with LAPACK, at a cost linear in the
+     number of periods */
+  lapack_int kl = 0, ku = 0;
+  for (int j = 0; j < n; j++)
+    for (SuiteSparse_long p = Ap[j]; p < Ap[j+1]; p++)
+      {
+        lapack_int d = Ai[p] - j;
+        if (d > kl)
+          kl = d;
+        else if (-d > ku)
+          ku = -d;
+      }
+  lapack_int ldab = 2*kl+ku+1;
+  lapack_int n_l = n, nrhs = 1, info;
+  double *AB = (double *) mxMalloc(ldab*n*sizeof(double));
+  if (!AB)
     {
-      status = umfpack_dl_symbolic(n, n, Ap, Ai, Ax, &Symbolic, Control, Info);
-      if (status < 0)
-        {
-          umfpack_dl_report_info(Control, Info);
-          umfpack_dl_report_status(Control, status);
-          ostringstream  Error;
-          Error << " umfpack_dl_symbolic failed\n";
-          throw FatalExceptionHandling(Error.str());
-        }
+      ostringstream tmp;
+      tmp << " in Solve_Band_LU, can't allocate the band matrix (" << ldab << " x " << n << ")\n";
+      throw FatalExceptionHandling(tmp.str());
     }
-  if (iter > 0)
-    umfpack_dl_free_numeric(&Numeric) ;
-  status = umfpack_dl_numeric (Ap, Ai, Ax, Symbolic, &Numeric, Control, Info);
-  if (status < 0)
+  lapack_int *ipiv = (lapack_int *) mxMalloc(n*sizeof(lapack_int));
+  if (!ipiv)
     {
-      umfpack_dl_report_info(Control, Info);
-      umfpack_dl_report_status(Control, status);
-      ostringstream  Error;
-      Error << " umfpack_dl_numeric failed\n";
-      throw FatalExceptionHandling(Error.str());
+      mxFree(AB);
+      ostringstream tmp;
+      tmp << " in Solve_Band_LU, can't allocate the pivot indices (" << n << ")\n";
+      throw FatalExceptionHandling(tmp.str());
     }
-  status = umfpack_dl_solve(sys, Ap, Ai, Ax, res, b, Numeric, Control, Info);
-  if (status != UMFPACK_OK)
+  memset(AB, 0, ldab*n*sizeof(double));
+  for (int j = 0; j < n; j++)
+    for (SuiteSparse_long p = Ap[j]; p < Ap[j+1]; p++)
+      AB[kl+ku+Ai[p]-j+j*ldab] = Ax[p];
+  dgbsv(&n_l, &kl, &ku, &nrhs, AB, &ldab, ipiv, b, &n_l, &info);
+  mxFree(AB);
+  mxFree(ipiv);
+  if (info != 0)
     {
-      umfpack_dl_report_info(Control, Info);
-      umfpack_dl_report_status(Control, status);
       ostringstream  Error;
-      Error << " umfpack_dl_solve failed\n";
+      if (info > 0)
+        Error << " in Solve_Band_LU, singular Jacobian in block " << block_num+1 << "\n";
+      else
+        Error << " in Solve_Band_LU, dgbsv failed (info=" << info << ")\n";
       throw FatalExceptionHandling(Error.str());
     }
-
-  if (is_two_boundaries)
-    for (int i = 0; i < n; i++)
-      {
-        int eq = index_vara[i+Size*y_kmin];
-        double yy = -(res[i] + y[eq]);
-        direction[eq] = yy;
-        y[eq] += slowc_l * yy;
-      }
-  else
-    for (int i = 0; i < n; i++)
-      {
-        int eq = index_vara[i];
-        double yy = -(res[i] + y[eq+it_*y_size]);
-        direction[eq] = yy;
-        y[eq+it_*y_size] += slowc_l * yy;
-      }
+  if (print_it)
+    mexPrintf("Band LU: bandwidths (%d, %d)\n", int (kl), int (ku));
+  Update_Newton_Step(b, n, Size, slowc_l, true, 0, vector_table_conditional_local);
   mxFree(Ap);
   mxFree(Ai);
   mxFree(Ax);
   mxFree(b);
-#ifdef _MSC_VER
-  mxFree(Control);
-  mxFree(Info);
-  mxFree(res);
-#endif
 }
 
-
 void
 dynSparseMatrix::Solve_LU_UMFPack(mxArray *A_m, mxArray *b_m, int Size, double slowc_l, bool is_two_boundaries, int  it_)
 {
@@ -6323,7 +6437,7 @@ dynSparseMatrix::Simulate_One_Boundary(int block_num, int y_size, int y_kmin, in
           tmp << " in Simulate_One_Boundary, can't allocate x0_m vector\n";
           throw FatalExceptionHandling(tmp.str());
         }
-      if (!((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 4) && !steady_state)))
+      if (!((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 4 || stack_solve_algo == 8 || stack_solve_algo == 9) && !steady_state)))
         {
           Init_Matlab_Sparse_Simple(size, IM_i, A_m, b_m, zero_solution, x0_m);
           A_m_save = mxDuplicateArray(A_m);
@@ -6364,7 +6478,9 @@ dynSparseMatrix::Simulate_One_Boundary(int block_num, int y_size, int y_kmin, in
       else if ((solve_algo == 8 && steady_state) || (stack_solve_algo == 3 && !steady_state))
         Solve_Matlab_BiCGStab(A_m, b_m, size, slowc, block_num, false, it_, x0_m, preconditioner);
       else if ((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 1 || stack_solve_algo == 4) && !steady_state))
-        Solve_LU_UMFPack(Ap, Ai, Ax, b, size, size, slowc, true, 0);
+        Solve_LU_UMFPack(Ap, Ai, Ax, b, size, size, slowc, false, it_);
+      else if ((stack_solve_algo == 8 || stack_solve_algo == 9) && !steady_state)
+        Solve_Sparse_LU(Ap, Ai, Ax, b, size, size, slowc, false, it_, block_num, vector_table_conditional_local_type());
     }
   return singular_system;
 }
@@ -6422,7 +6538,7 @@ dynSparseMatrix::Simulate_Newton_One_Boundary(const bool forward)
   g1 = (double *) mxMalloc(size*size*sizeof(double));
   r = (double *) mxMalloc(size*sizeof(double));
   iter = 0;
-  if ((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 1 || stack_solve_algo == 4) && !steady_state))
+  if ((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 1 || stack_solve_algo == 4 || stack_solve_algo == 8 || stack_solve_algo == 9) && !steady_state))
     {
       Ap_save = (SuiteSparse_long*)mxMalloc((size + 1) * sizeof(SuiteSparse_long));
       Ap_save[size] = 0;
@@ -6464,7 +6580,7 @@ dynSparseMatrix::Simulate_Newton_One_Boundary(const bool forward)
             solve_linear(block_num, y_size, y_kmin, y_kmax, size, 0);
         }
     }
-  if ((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 1 || stack_solve_algo == 4) && !steady_state))
+  if ((solve_algo == 6 && steady_state) || ((stack_solve_algo == 0 || stack_solve_algo == 1 || stack_solve_algo == 4 || stack_solve_algo == 8 || stack_solve_algo == 9) && !steady_state))
     {
       mxFree(Ap_save);
       mxFree(Ai_save);
@@ -6674,6 +6790,12 @@ dynSparseMatrix::Simulate_Newton_Two_Boundaries(int blck, int y_size, int y_kmin
             case 7:
               mexPrintf(preconditioner_print_out("MODEL SIMULATION: (method=GPU BiCGStab)\n", preconditioner, false).c_str());
               break;
+            case 8:
+              mexPrintf("MODEL SIMULATION: (method=ByteCode sparse LU)\n");
+              break;
+            case 9:
+              mexPrintf("MODEL SIMULATION: (method=Band LU)\n");
+              break;
             default:
               mexPrintf("MODEL SIMULATION: (method=Unknown - %d - )\n", stack_solve_algo);
             }
@@ -6710,7 +6832,7 @@ dynSparseMatrix::Simulate_Newton_Two_Boundaries(int blck, int y_size, int y_kmin
               tmp << " in Simulate_Newton_Two_Boundaries, can't allocate x0_m vector\n";
               throw FatalExceptionHandling(tmp.str());
             }
-          if (stack_solve_algo != 0 && stack_solve_algo != 4 && stack_solve_algo != 7)
+          if (stack_solve_algo != 0 && stack_solve_algo != 4 && stack_solve_algo != 7 && stack_solve_algo != 8 && stack_solve_algo != 9)
             {
               A_m = mxCreateSparse(periods*Size, periods*Size, IM_i.size()* periods*2, mxREAL);
               if (!A_m)
@@ -6720,7 +6842,7 @@ dynSparseMatrix::Simulate_Newton_Two_Boundaries(int blck, int y_size, int y_kmin
                   throw FatalExceptionHandling(tmp.str());
                 }
             }
-          if (stack_solve_algo == 0 || stack_solve_algo == 4)
+          if (stack_solve_algo == 0 || stack_solve_algo == 4 || stack_solve_algo == 8 || stack_solve_algo == 9)
             Init_UMFPACK_Sparse(periods, y_kmin, y_kmax, Size, IM_i, &Ap, &Ai, &Ax, &b, x0_m, vector_table_conditional_local, blck);
 #ifdef CUDA
           else if (stack_solve_algo == 7)
@@ -6740,6 +6862,10 @@ dynSparseMatrix::Simulate_Newton_Two_Boundaries(int blck, int y_size, int y_kmin
         Solve_Matlab_BiCGStab(A_m, b_m, Size, slowc, blck, true, 0, x0_m, 1);
       else if (stack_solve_algo == 5)
         Solve_ByteCode_Symbolic_Sparse_GaussianElimination(Size, symbolic, blck);
+      else if (stack_solve_algo == 8)
+        Solve_Sparse_LU(Ap, Ai, Ax, b, Size * periods, Size, slowc, true, 0, blck, vector_table_conditional_local);
+      else if (stack_solve_algo == 9)
+        Solve_Band_LU(Ap, Ai, Ax, b, Size * periods, Size, slowc, blck, vector_table_conditional_local);
 #ifdef CUDA
       else if (stack_solve_algo == 7)
         Solve_CUDA_BiCGStab(Ap_i, Ai_i, Ax, Ap_i_tild, Ai_i_tild, A_tild, b, x0, Size * periods, Size, slowc, true, 0, nnz, nnz_tild, preconditioner, Size * periods, blck);
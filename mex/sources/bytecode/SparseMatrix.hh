@@ -26,6 +26,7 @@
 #include <map>
 #include <ctime>
 #include "dynblas.h"
+#include "dynlapack.h"
 #if !(defined _MSC_VER)
 #include "dynumfpack.h"
 #endif
@@ -38,6 +39,7 @@
 #endif
 
 #include "Mem_Mngr.hh"
+#include "SparseLU.hh"
 #include "ErrorHandling.hh"
 //#include "Interpreter.hh"
 #include "Evaluate.hh"
@@ -101,6 +103,24 @@ const double mem_increasing_factor = 1.1;
 
 
 
+//! UMFPACK factorization of the jacobian of a block (see dynSparseMatrix::Solve_UMFPack_System)
+struct umfpack_factorization_type
+{
+  umfpack_factorization_type() : n(0), hash(0), Symbolic(NULL), Numeric(NULL), numeric_age(0), nb_symbolic(0), nb_numeric(0)
+  {
+  };
+  //! Sparsity pattern of the symbolic analysis and its checksum
+  int n;
+  size_t hash;
+  vector<SuiteSparse_long> Ap, Ai;
+  //! Values of the matrix of the numeric factorization (only kept for the simplified Newton)
+  vector<double> Ax;
+  void *Symbolic, *Numeric;
+  //! Number of solves done with the numeric factorization after the one in which it has been computed
+  int numeric_age;
+  int nb_symbolic, nb_numeric;
+};
+
 class dynSparseMatrix : public Evaluate
 {
 public:
@@ -113,11 +133,14 @@ public:
                ,const int CUDA_device_arg, cublasHandle_t cublas_handle_arg, cusparseHandle_t cusparse_handle_arg, cusparseMatDescr_t descr_arg
 #endif
                );
+  ~dynSparseMatrix();
   void Simulate_Newton_Two_Boundaries(int blck, int y_size, int y_kmin, int y_kmax, int Size, int periods, bool cvg, int minimal_solving_periods, int stack_solve_algo, unsigned int endo_name_length, char *P_endo_names, vector_table_conditional_local_type vector_table_conditional_local);
   void Simulate_Newton_One_Boundary(bool forward);
   void fixe_u(double **u, int u_count_int, int max_lag_plus_max_lead_plus_1);
   void Read_SparseMatrix(string file_name, const int Size, int periods, int y_kmin, int y_kmax, bool two_boundaries, int stack_solve_algo, int solve_algo);
   void Close_SaveCode();
+  //! Copies the next size bytes of the .bin file into dest
+  void Read_SaveCode(void *dest, size_t size);
   void Read_file(string file_name, int periods, int u_size1, int y_size, int y_kmin, int y_kmax, int &nb_endo, int &u_count, int &u_count_init, double *u);
   void Singular_display(int block, int Size);
   void End_Solver();
@@ -150,6 +173,13 @@ private:
   void Solve_LU_UMFPack(mxArray *A_m, mxArray *b_m, int Size, double slowc_l, bool is_two_boundaries, int  it_);
   void Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, vector_table_conditional_local_type vector_table_conditional_local);
   void Solve_LU_UMFPack(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_);
+  /*! Solves the system (Ap, Ai, Ax) * res = b with UMFPACK, reusing the factorization of the
+    block when possible. b may be modified */
+  void Solve_UMFPack_System(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, double *res, int n, int Size, bool is_two_boundaries, int  it_, bool simplified_newton_allowed);
+  void Solve_Sparse_LU(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, int block_num, vector_table_conditional_local_type vector_table_conditional_local);
+  void Solve_Band_LU(SuiteSparse_long *Ap, SuiteSparse_long *Ai, double *Ax, double *b, int n, int Size, double slowc_l, int block_num, vector_table_conditional_local_type vector_table_conditional_local);
+  //! Updates y (and x for the conditional forecasts) with the Newton step computed by a linear solver
+  void Update_Newton_Step(const double *res, int n, int Size, double slowc_l, bool is_two_boundaries, int  it_, vector_table_conditional_local_type &vector_table_conditional_local);
 
   void End_Matlab_LU_UMFPack();
 #ifdef CUDA
@@ -186,7 +216,6 @@ private:
   void Delete_u(int pos);
   void Clear_u();
   void Print_u();
-  void *Symbolic, *Numeric ;
   void CheckIt(int y_size, int y_kmin, int y_kmax, int Size, int periods);
   void Check_the_Solution(int periods, int y_kmin, int y_kmax, int Size, double *u, int *pivot, int *b);
   int complete(int beg_t, int Size, int periods, int *b);
@@ -215,7 +244,9 @@ protected:
   int nb_prologue_table_y, nb_first_table_y, nb_middle_table_y, nb_last_table_y;
   int middle_count_loop;
   //char type;
-  fstream SaveCode;
+  //! The .bin file being read (shared by the calls to the MEX) and the position of the next read
+  LoadedFile *SaveCode;
+  size_t SaveCode_pos;
   string filename;
   int max_u, min_u;
   clock_t time00;
@@ -240,6 +271,10 @@ protected:
   double res1a;
   long int nop_all, nop1, nop2;
   map<pair<pair<int, int>, int>, int> IM_i;
+  //! LU factorizations used by stack_solve_algo=8, by block
+  map<int, SparseLU> sparse_lu;
+  //! UMFPACK factorizations, by block
+  map<int, umfpack_factorization_type> umfpack_factorizations;
 protected:
   vector<double> residual;
   int u_count_alloc, u_count_alloc_save;
@@ -250,6 +285,8 @@ protected:
   int *index_equa;
   int u_count, tbreak_g;
   int iter;
+  //! Number of Newton iterations on which a numeric UMFPACK factorization is reused (0: refactorized at each iteration)
+  int simplified_newton;
   int start_compare;
   int restart;
   double g_lambda1, g_lambda2, gp_0;
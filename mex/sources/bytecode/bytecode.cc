@@ -281,7 +281,7 @@ Get_Arguments_and_global_variables(int nrhs,
                                    bool &steady_state, bool &evaluate, int &block,
                                    mxArray *M_[], mxArray *oo_[], mxArray *options_[], bool &global_temporary_terms,
                                    bool &print,
-                                   bool &print_error,
+                                   bool &print_error, bool &legacy_interpreter, bool &jit,
                                    mxArray *GlobalTemporaryTerms[],
                                    string *plan_struct_name, string *pfplan_struct_name, bool *extended_path, mxArray *ep_struct[])
 {
@@ -346,6 +346,10 @@ Get_Arguments_and_global_variables(int nrhs,
             print = true;
           else if (Get_Argument(prhs[i]) == "no_print_error")
             print_error = false;
+          else if (Get_Argument(prhs[i]) == "legacy_interpreter")
+            legacy_interpreter = true;
+          else if (Get_Argument(prhs[i]) == "jit")
+            jit = true;
           else
             {
               pos = 0;
@@ -462,7 +466,7 @@ main(int nrhs, const char *prhs[])
   double *yd = NULL, *xd = NULL;
   int count_array_argument = 0;
   bool global_temporary_terms = false;
-  bool print = false, print_error = true, print_it = false;
+  bool print = false, print_error = true, print_it = false, legacy_interpreter = false, jit = false;
   double *steady_yd = NULL, *steady_xd = NULL;
   string plan, pfplan;
   bool extended_path;
@@ -494,7 +498,7 @@ main(int nrhs, const char *prhs[])
 #endif
                                          steady_state, evaluate, block,
                                          &M_, &oo_, &options_, global_temporary_terms,
-                                         print, print_error, &GlobalTemporaryTerms,
+                                         print, print_error, legacy_interpreter, jit, &GlobalTemporaryTerms,
                                          &plan, &pfplan, &extended_path, &extended_path_struct);
     }
   catch (GeneralExceptionHandling &feh)
@@ -998,6 +1002,22 @@ main(int nrhs, const char *prhs[])
   if (field < 0)
     DYN_MEX_FUNC_ERR_MSG_TXT("stack_solve_algo is not a field of options_");
   int stack_solve_algo = int (*(mxGetPr(mxGetFieldByNumber(options_, 0, field))));
+  // Number of threads used to evaluate the periods of two boundaries blocks (options_.threads.bytecode, optional)
+  int nb_threads = 1;
+  field = mxGetFieldNumber(options_, "threads");
+  if (field >= 0)
+    {
+      mxArray *threads = mxGetFieldByNumber(options_, 0, field);
+      field = mxGetFieldNumber(threads, "bytecode");
+      if (field >= 0)
+        nb_threads = int (*(mxGetPr(mxGetFieldByNumber(threads, 0, field))));
+      if (nb_threads < 1)
+        nb_threads = 1;
+    }
+  field = mxGetFieldNumber(options_, "simplified_newton");
+  int simplified_newton = 0;
+  if (field >= 0)
+    simplified_newton = int (*(mxGetPr(mxGetFieldByNumber(options_, 0, field))));
   int solve_algo;
   double solve_tolf;
 
@@ -1079,7 +1099,7 @@ main(int nrhs, const char *prhs[])
   clock_t t0 = clock();
   Interpreter interprete(params, y, ya, x, steady_yd, steady_xd, direction, y_size, nb_row_x, nb_row_xd, periods, y_kmin, y_kmax, maxit_, solve_tolf, size_of_direction, slowc, y_decal,
                          markowitz_c, file_name, minimal_solving_periods, stack_solve_algo, solve_algo, global_temporary_terms, print, print_error, GlobalTemporaryTerms, steady_state,
-                         print_it, col_x
+                         print_it, col_x, legacy_interpreter, jit, nb_threads, simplified_newton
 #ifdef CUDA
                          , CUDA_device, cublas_handle, cusparse_handle, descr
 #endif
@@ -90,6 +90,10 @@ extern "C" {
   void dtrsv(BLCHAR uplo, BLCHAR trans, BLCHAR diag, CONST_BLINT n,
              CONST_BLDOU a, CONST_BLINT lda, BLDOU x, CONST_BLINT incx);
 
+#define dtpsv FORTRAN_WRAPPER(dtpsv)
+  void dtpsv(BLCHAR uplo, BLCHAR trans, BLCHAR diag, CONST_BLINT n,
+             CONST_BLDOU ap, BLDOU x, CONST_BLINT incx);
+
 #define dtrmv FORTRAN_WRAPPER(dtrmv)
   void dtrmv(BLCHAR uplo, BLCHAR trans, BLCHAR diag, CONST_BLINT n,
              CONST_BLDOU a, CONST_BLINT lda, BLDOU x, CONST_BLINT incx);
@@ -70,6 +70,10 @@ extern "C" {
   void dgetrf(CONST_LAINT m, CONST_LAINT n, LADOU a,
               CONST_LAINT lda, LAINT ipiv, LAINT info);
 
+#define dgbsv FORTRAN_WRAPPER(dgbsv)
+  void dgbsv(CONST_LAINT n, CONST_LAINT kl, CONST_LAINT ku, CONST_LAINT nrhs, LADOU ab,
+             CONST_LAINT ldab, LAINT ipiv, LADOU b, CONST_LAINT ldb, LAINT info);
+
 #define dgetri FORTRAN_WRAPPER(dgetri)
   void dgetri(CONST_LAINT n, LADOU a, CONST_LAINT lda, CONST_LAINT ipiv, LADOU work,
               CONST_LAINT lwork, LAINT info);
@@ -39,6 +39,8 @@ extern "C" {
 #define UMFPACK_CONTROL 20
 /* used in all UMFPACK_report_* routines: */
 #define UMFPACK_PRL 0			/* print level */
+/* used in umfpack_*_solve: */
+#define UMFPACK_IRSTEP 7		/* max # of iterative refinements */
 /* returned by all routines that use Info: */
 #define UMFPACK_OK (0)
 #define UMFPACK_STATUS 0	/* UMFPACK_OK, or other result */
@@ -23,6 +23,9 @@
 //  Created on:      02-Feb-2010 12:44:41
 ///////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <limits>
+
 #include "KalmanFilter.hh"
 #include "LapackBindings.hh"
 
@@ -36,7 +39,8 @@ KalmanFilter::KalmanFilter(const std::string &basename, size_t n_endo, size_t n_
                            const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg,
                            double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                            double riccati_tol_arg, double lyapunov_tol_arg,
-                           bool noconstant_arg) :
+                           bool noconstant_arg, bool fast_kalman_filter_arg,
+                           bool square_root_kalman_filter_arg) :
   zeta_varobs_back_mixed(compute_zeta_varobs_back_mixed(zeta_back_arg, zeta_mixed_arg, varobs_arg)),
   Z(varobs_arg.size(), zeta_varobs_back_mixed.size()), Zt(Z.getCols(), Z.getRows()), T(zeta_varobs_back_mixed.size()), R(zeta_varobs_back_mixed.size(), n_exo),
   Pstar(zeta_varobs_back_mixed.size(), zeta_varobs_back_mixed.size()), Pinf(zeta_varobs_back_mixed.size(), zeta_varobs_back_mixed.size()),
@@ -46,7 +50,17 @@ KalmanFilter::KalmanFilter(const std::string &basename, size_t n_endo, size_t n_
   a_new(zeta_varobs_back_mixed.size()), vt(varobs_arg.size()), vtFinv(varobs_arg.size()), riccati_tol(riccati_tol_arg),
   initKalmanFilter(basename, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg,
                    zeta_static_arg, zeta_varobs_back_mixed, varobs_arg, qz_criterium_arg, lyapunov_tol_arg, noconstant_arg),
-  FUTP(varobs_arg.size()*(varobs_arg.size()+1)/2)
+  FUTP(varobs_arg.size()*(varobs_arg.size()+1)/2), fast_kalman_filter(fast_kalman_filter_arg),
+  W(zeta_varobs_back_mixed.size(), varobs_arg.size()), TW(zeta_varobs_back_mixed.size(), varobs_arg.size()),
+  WM(zeta_varobs_back_mixed.size(), varobs_arg.size()), M(varobs_arg.size()), ZW(varobs_arg.size()),
+  ZWM(varobs_arg.size()), FinvZWM(varobs_arg.size()), ZWMWt(varobs_arg.size(), zeta_varobs_back_mixed.size()),
+  square_root_kalman_filter(square_root_kalman_filter_arg),
+  eigP(zeta_varobs_back_mixed.size()), eigQ(n_exo), eigH(varobs_arg.size()),
+  S(zeta_varobs_back_mixed.size()), Qc(n_exo), Hc(varobs_arg.size()),
+  preArray(varobs_arg.size()+zeta_varobs_back_mixed.size()+n_exo, varobs_arg.size()+zeta_varobs_back_mixed.size()),
+  qrPreArray(varobs_arg.size()+zeta_varobs_back_mixed.size()+n_exo, varobs_arg.size()+zeta_varobs_back_mixed.size(), 0),
+  Xbar(varobs_arg.size(), zeta_varobs_back_mixed.size()), oldXbar(varobs_arg.size(), zeta_varobs_back_mixed.size()),
+  et(varobs_arg.size())
 {
   Z.setAll(0.0);
   Zt.setAll(0.0);
@@ -76,20 +90,104 @@ KalmanFilter::compute_zeta_varobs_back_mixed(const std::vector<size_t> &zeta_bac
 
 
 /**
- * Multi-variate standard Kalman Filter
+ * Computes Finv=inv(F), leaves the Cholesky decomposition of F in FUTP and
+ * returns the info of the LAPACK solver
+ */
+int
+KalmanFilter::invertF()
+{
+  size_t p = Finv.getRows();
+
+  mat::set_identity(Finv);
+  // Pack F upper trinagle as vector
+  for (size_t i = 1; i <= p; ++i)
+    for (size_t j = i; j <= p; ++j)
+      FUTP(i + (j-1)*j/2 -1) = F(i-1, j-1);
+
+  return lapack::choleskySolver(FUTP, Finv, "U"); // FUTP now contains Chol decomposition of F!
+}
+
+/**
+ * Multi-variate standard Kalman Filter, or the same with the Chandrasekhar
+ * recursions if fast
  */
 double
-KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start)
+KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start, bool fast)
 {
   double loglik = 0.0, ll, logFdet = 0.0, Fdet, dvtFinvVt;
   size_t p = Finv.getRows();
   bool nonstationary = true;
   a_init.setAll(0.0);
   int info;
-  
+
+  if (fast)
+    {
+      // K=TPZ' and F=ZPZ'+H, W is used as temporary for PZ'
+      blas::symm("L", "U", 1.0, Pstar, Zt, 0.0, W);
+      blas::gemm("N", "N", 1.0, T, W, 0.0, K);
+      F = H;
+      blas::gemm("N", "N", 1.0, Z, W, 1.0, F);
+    }
+
   for (size_t t = 0; t < detrendedDataView.getCols(); ++t)
     {
-      if (nonstationary)
+      if (nonstationary && fast)
+        {
+          // M=M+ZWM'*Finv*ZWM with Finv of the previous period
+          if (t > 0)
+            {
+              blas::gemm("N", "N", 1.0, Finv, ZWM, 0.0, FinvZWM);
+              blas::gemm("T", "N", 1.0, ZWM, FinvZWM, 1.0, M);
+            }
+
+          info = invertF();
+          assert(info >= 0);
+          if (info > 0)
+            fast = false; // go on with the Riccati equation from Pstar, which is kept up to date
+          else
+            {
+              // KFinv gain matrix
+              blas::symm("R", "U", 1.0, Finv, K, 0.0, KFinv);
+
+              if (t == 0)
+                {
+                  // Pstar=T*Pstar*T'+RQR' implies P1-Pstar=-K*Finv*K'
+                  W = K;
+                  M = Finv;
+                  mat::negate(M);
+                }
+              else
+                {
+                  // W=T*W-KFinv*ZW
+                  blas::gemm("N", "N", 1.0, T, W, 0.0, TW);
+                  blas::gemm("N", "N", -1.0, KFinv, ZW, 1.0, TW);
+                  W = TW;
+                }
+
+              // deteminant of F:
+              Fdet = 1;
+              for (size_t d = 1; d <= p; ++d)
+                Fdet *= FUTP(d + (d-1)*d/2 -1);
+              Fdet *= Fdet;
+
+              logFdet = log(fabs(Fdet));
+
+              // Pt+1=Pt+WMW', Ft+1=Ft+ZWMW'Z', Kt+1=Kt+TWMW'Z'
+              blas::gemm("N", "N", 1.0, Z, W, 0.0, ZW);
+              blas::gemm("N", "N", 1.0, ZW, M, 0.0, ZWM);
+              blas::gemm("N", "T", 1.0, ZWM, W, 0.0, ZWMWt);
+              blas::gemm("N", "N", 1.0, W, M, 0.0, WM);
+              blas::gemm("N", "T", 1.0, WM, W, 1.0, Pstar);
+              blas::gemm("N", "T", 1.0, ZWMWt, Z, 1.0, F);
+              blas::gemm("N", "T", 1.0, T, ZWMWt, 1.0, K);
+
+              if (t > 0)
+                nonstationary = mat::isDiff(KFinv, oldKFinv, riccati_tol);
+              oldKFinv = KFinv;
+            }
+        }
+
+      if (nonstationary && !fast)
         {
           // K=PZ'
           //blas::gemm("N", "T", 1.0, Pstar, Z, 0.0, K);
@@ -101,13 +199,7 @@ KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, Vect
           // logFdet=log|F|
 
           // Finv=inv(F)
-          mat::set_identity(Finv);
-          // Pack F upper trinagle as vector
-          for (size_t i = 1; i <= p; ++i)
-            for (size_t j = i; j <= p; ++j)
-              FUTP(i + (j-1)*j/2 -1) = F(i-1, j-1);
-
-          info = lapack::choleskySolver(FUTP, Finv, "U"); // F now contains its Chol decomposition!
+          info = invertF(); // F now contains its Chol decomposition!
           assert(info >= 0);
 
           if (info > 0)
@@ -128,15 +220,9 @@ KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, Vect
               blas::gemm("N", "N", 1.0, Z, K, 1.0, F);
 
               // Finv=inv(F)
-              mat::set_identity(Finv);
-              // Pack F upper trinagle as vector
-              for (size_t i = 1; i <= p; ++i)
-                for (size_t j = i; j <= p; ++j)
-                  FUTP(i + (j-1)*j/2 -1) = F(i-1, j-1);
-
-              info = lapack::choleskySolver(FUTP, Finv, "U"); // F now contains
-                                                              // its Chol
-                                                              // decomposition!
+              info = invertF(); // F now contains
+                                // its Chol
+                                // decomposition!
               assert(info == 0);
             }
           // KFinv gain matrix
@@ -171,9 +257,18 @@ KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, Vect
       vt = yt;
       blas::gemv("N", -1.0, Z, a_init, 1.0, vt);
 
-      // at+1= T(at+ KFinv *err)
-      blas::gemv("N", 1.0, KFinv, vt, 1.0, a_init);
-      blas::gemv("N", 1.0, T, a_init, 0.0, a_new);
+      if (fast)
+        {
+          // at+1= T*at+ KFinv *err, the gain includes T
+          blas::gemv("N", 1.0, T, a_init, 0.0, a_new);
+          blas::gemv("N", 1.0, KFinv, vt, 1.0, a_new);
+        }
+      else
+        {
+          // at+1= T(at+ KFinv *err)
+          blas::gemv("N", 1.0, KFinv, vt, 1.0, a_init);
+          blas::gemv("N", 1.0, T, a_init, 0.0, a_new);
+        }
       a_init = a_new;
 
       /*****************
@@ -193,3 +288,101 @@ KalmanFilter::filter(const MatrixView &detrendedDataView,  const Matrix &H, Vect
   return loglik;
 }
 
+/**
+ * Multi-variate square root Kalman Filter, see the description of the class
+ */
+double
+KalmanFilter::filterSquareRoot(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start)
+{
+  double loglik = 0.0, ll, logFdet = 0.0, dvtFinvVt;
+  size_t p = Finv.getRows(), mm = T.getRows(), rr = Qc.getRows();
+  bool nonstationary = true;
+  a_init.setAll(0.0);
+
+  // Square roots of the initial Pstar and of H, Qc has been computed by compute()
+  squareRoot(eigP, Pstar, S);
+  squareRoot(eigH, H, Hc);
+
+  MatrixView preArrayHc(preArray, 0, 0, p, p), preArraySZt(preArray, p, 0, mm, p),
+    preArraySTt(preArray, p, p, mm, mm), preArrayQcRt(preArray, p+mm, p, rr, mm);
+  MatrixConstView R_Xbar(preArray, 0, p, p, mm), R_S(preArray, p, p, mm, mm);
+
+  for (size_t t = 0; t < detrendedDataView.getCols(); ++t)
+    {
+      if (nonstationary)
+        {
+          // Pre-array [ Hc 0; S*Z' S*T'; 0 Qc*R' ]
+          preArray.setAll(0.0);
+          preArrayHc = Hc;
+          blas::gemm("N", "T", 1.0, S, Z, 0.0, preArraySZt);
+          blas::gemm("N", "T", 1.0, S, T, 0.0, preArraySTt);
+          blas::gemm("N", "T", 1.0, Qc, R, 0.0, preArrayQcRt);
+
+          // Post-array [ Fc Xbar; 0 S; 0 0 ] in the upper triangle
+          qrPreArray.compute(preArray);
+
+          // Pack Fc as vector and compute log|F|. F=Fc'Fc is singular to
+          // working precision when its reciprocal condition number
+          // (min|Fc(j,j)|/max|Fc(j,j)|)^2 is below p*eps
+          double maxPivot = 0.0, minPivot = INFINITY;
+          logFdet = 0.0;
+          for (size_t j = 1; j <= p; ++j)
+            {
+              for (size_t i = 1; i <= j; ++i)
+                FUTP(i + (j-1)*j/2 -1) = preArray(i-1, j-1);
+              double pivot = fabs(preArray(j-1, j-1));
+              if (!std::isfinite(pivot))
+                throw KalmanFilterException("KalmanFilter::filterSquareRoot: the variance of the observations is not finite");
+              maxPivot = std::max(maxPivot, pivot);
+              minPivot = std::min(minPivot, pivot);
+              logFdet += log(pivot);
+            }
+          if (!(minPivot > maxPivot*sqrt(p*std::numeric_limits<double>::epsilon())))
+            throw KalmanFilterException("KalmanFilter::filterSquareRoot: the variance of the observations is singular");
+          logFdet *= 2;
+
+          Xbar = R_Xbar;
+          for (size_t i = 0; i < mm; ++i)
+            for (size_t j = i; j < mm; ++j)
+              S(i, j) = R_S(i, j);
+          for (size_t i = 1; i < mm; ++i)
+            for (size_t j = 0; j < i; ++j)
+              S(i, j) = 0.0;
+
+          if (t > 0)
+            nonstationary = mat::isDiff(Xbar, oldXbar, riccati_tol);
+          oldXbar = Xbar;
+        }
+
+      // err= Yt - Za
+      VectorConstView yt = mat::get_col(detrendedDataView, t);
+      vt = yt;
+      blas::gemv("N", -1.0, Z, a_init, 1.0, vt);
+
+      // et=inv(Fc')*err
+      et = vt;
+      blas::tpsv("U", "T", "N", FUTP, et);
+
+      // at+1= T*at+ Xbar'*et, since Xbar'*et=TPZ'*Finv*err
+      blas::gemv("N", 1.0, T, a_init, 0.0, a_new);
+      blas::gemv("T", 1.0, Xbar, et, 1.0, a_new);
+      a_init = a_new;
+
+      /*****************
+         Here we calc likelihood and store results.
+      *****************/
+      dvtFinvVt = blas::dot(et, et);
+
+      ll = -0.5*(p*log(2*M_PI)+logFdet+dvtFinvVt);
+
+      vll(t) = ll;
+      if (t >= start)
+        loglik += ll;
+
+    }
+
+  // Pstar=S'S is the initial variance of the next subsample
+  blas::gemm("T", "N", 1.0, S, S, 0.0, Pstar);
+
+  return loglik;
+}
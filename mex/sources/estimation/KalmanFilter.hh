@@ -27,6 +27,8 @@
 #define KF_213B0417_532B_4027_9EDF_36C004CB4CD1__INCLUDED_
 
 #include "InitializeKalmanFilter.hh"
+#include "VDVEigDecomposition.hh"
+#include "QRDecomposition.hh"
 
 /**
  * Vanilla Kalman filter without constant and with measurement error (use scalar
@@ -34,6 +36,26 @@
  * If multivariate filter is faster, do as in Matlab: start with multivariate
  * filter and switch to univariate filter only in case of singularity
  *
+ * If fast_kalman_filter is set, the variance of the state is not updated by
+ * the Riccati equation but by the Chandrasekhar recursions on the factors W
+ * and M of its increment P(t+1)-P(t)=WMW', where W is mm*nob and M is
+ * nob*nob. This requires the initial Pstar to be the stationary variance
+ * (always the case for the first period) and costs O(mm*mm*nob) instead of
+ * O(mm*mm*mm) per period.
+ *
+ * If square_root_kalman_filter is set, the filter propagates a square root S
+ * of P=S'S instead of P itself, with the array algorithm: the QR decomposition
+ * of the pre-array
+ *    [ Hc    0    ]                         [ Fc   Xbar ]
+ *    [ S*Z'  S*T' ]  is Q*R, with R equal to [ 0    S+   ]
+ *    [ 0     Qc*R']                         [ 0    0    ]
+ * where Hc'Hc=H and Qc'Qc=Q, gives the upper triangular factor Fc of F=Fc'Fc,
+ * the scaled gain Xbar=inv(Fc')*(TPZ')' and the square root S+ of the
+ * variance of the next period. F and P are never formed, so they cannot lose
+ * their positive (semi)definiteness through rounding and the symmetrization
+ * of Pstar is not needed. Once Xbar has converged, the remaining periods only
+ * update the state.
+ *
  * mamber functions: compute() and filter()
  * OUTPUT
  *    LIK:    likelihood
@@ -42,18 +64,33 @@
  *   See "Filtering and Smoothing of State Vector for Diffuse State Space
  *   Models", S.J. Koopman and J. Durbin (2003, in Journal of Time Series
  *   Analysis, vol. 24(1), pp. 85-98).
+ *   See "Using the Chandrasekhar Recursions for Likelihood Evaluation of DSGE
+ *   Models", E. Herbst (2015, in Computational Economics, vol. 45(4),
+ *   pp. 693-705).
  */
 
 class KalmanFilter
 {
 
 public:
+  /**
+   * Thrown when the variance of the observations is (numerically) singular.
+   * Like LUSolver::LUException, it is not a std::exception, so that the
+   * samplers reject the draw instead of stopping.
+   */
+  class KalmanFilterException
+  {
+  public:
+    const std::string message;
+    KalmanFilterException(const std::string &message_arg) : message(message_arg) {};
+  };
+
   virtual ~KalmanFilter();
   KalmanFilter(const std::string &basename, size_t n_endo, size_t n_exo, const std::vector<size_t> &zeta_fwrd_arg,
                const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg,
                double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                double riccati_tol_arg, double lyapunov_tol_arg,
-               bool noconstant_arg);
+               bool noconstant_arg, bool fast_kalman_filter_arg, bool square_root_kalman_filter_arg);
 
   template <class Vec1, class Vec2, class Mat1>
   double compute(const MatrixConstView &dataView, Vec1 &steadyState,
@@ -67,7 +104,14 @@ public:
 	  initKalmanFilter.initialize(steadyState, deepParams, R, Q, RQRt, T,
                                 dataView, detrendedDataView);
 
-  return filter(detrendedDataView, H, vll, start);
+  if (square_root_kalman_filter)
+    {
+      squareRoot(eigQ, Q, Qc);
+      return filterSquareRoot(detrendedDataView, H, vll, start);
+    }
+
+  // The Chandrasekhar recursions need the stationary variance Pstar of the first period
+  return filter(detrendedDataView, H, vll, start, fast_kalman_filter && period == 0);
   }
 
 private:
@@ -88,9 +132,42 @@ private:
   double riccati_tol;
   InitializeKalmanFilter initKalmanFilter; //Initialise KF matrices
   Vector FUTP; // F upper triangle packed as vector FUTP(i + (j-1)*j/2) = F(i,j) for 1<=i<=j;
+  const bool fast_kalman_filter;
+  // Chandrasekhar recursions: factors of P(t+1)-P(t)=WMW' and intermediary matrices
+  Matrix W, TW, WM; // mm*nob
+  Matrix M, ZW, ZWM, FinvZWM; // nob*nob
+  Matrix ZWMWt; // nob*mm
+  const bool square_root_kalman_filter;
+  // Square root filter: factors of P=S'S, Q=Qc'Qc and H=Hc'Hc, pre-array
+  // factorized in place and scaled gain Xbar=inv(Fc')*K'
+  VDVEigDecomposition eigP, eigQ, eigH;
+  Matrix S, Qc, Hc; // mm*mm, rr*rr and nob*nob
+  Matrix preArray; // (nob+mm+rr)*(nob+mm)
+  QRDecomposition qrPreArray;
+  Matrix Xbar, oldXbar; // nob*mm
+  Vector et; // standardized observation error inv(Fc')*vt
 
-  // Method
-  double filter(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start);
+  // Methods
+  int invertF();
+  double filter(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start, bool fast);
+  double filterSquareRoot(const MatrixView &detrendedDataView,  const Matrix &H, VectorView &vll, size_t start);
+  //! Computes a square root A=C'C of a symmetric positive semidefinite A, as C=sqrt(D)*V' with A=VDV'
+  template <class Mat>
+  static void squareRoot(VDVEigDecomposition &eig, const Mat &A, Matrix &C)
+  {
+    eig.calculate(A);
+    if (!eig.hasConverged())
+      throw VDVEigDecomposition::VDVEigException(0, "Eigenvalues did not converge in KalmanFilter::squareRoot");
+    const Matrix &V = eig.getV();
+    const Vector &D = eig.getD();
+    for (size_t i = 0; i < C.getRows(); ++i)
+      {
+        // Eigenvalues of a positive semidefinite matrix can be slightly negative due to rounding
+        double sqrtDi = D(i) > 0.0 ? sqrt(D(i)) : 0.0;
+        for (size_t j = 0; j < C.getCols(); ++j)
+          C(i, j) = sqrtDi*V(j, i);
+      }
+  }
 
 };
 
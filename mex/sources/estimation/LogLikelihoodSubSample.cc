@@ -32,10 +32,12 @@ LogLikelihoodSubSample::~LogLikelihoodSubSample()
 LogLikelihoodSubSample::LogLikelihoodSubSample(const std::string &basename, EstimatedParametersDescription &INestiParDesc, size_t n_endo, size_t n_exo,
                                                const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg,
                                                const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg, const double qz_criterium,
-                                               const std::vector<size_t> &varobs, double riccati_tol, double lyapunov_tol, bool noconstant_arg) :
+                                               const std::vector<size_t> &varobs, double riccati_tol, double lyapunov_tol, bool noconstant_arg,
+                                               bool fast_kalman_filter_arg, bool square_root_kalman_filter_arg) :
   estiParDesc(INestiParDesc),
   kalmanFilter(basename, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
-               varobs, riccati_tol, lyapunov_tol, noconstant_arg), eigQ(n_exo), eigH(varobs.size())
+               varobs, riccati_tol, lyapunov_tol, noconstant_arg, fast_kalman_filter_arg,
+               square_root_kalman_filter_arg), eigQ(n_exo), eigH(varobs.size())
 {
 };
 
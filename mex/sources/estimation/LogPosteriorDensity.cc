@@ -33,10 +33,12 @@ LogPosteriorDensity::LogPosteriorDensity(const std::string &modName, EstimatedPa
                                          const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
                                          const std::vector<size_t> &zeta_static_arg, const double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                                          double riccati_tol_arg, double lyapunov_tol_arg,
-                                         bool noconstant_arg) :
+                                         bool noconstant_arg, bool fast_kalman_filter_arg,
+                                         bool square_root_kalman_filter_arg) :
   logPriorDensity(estParamsDesc),
   logLikelihoodMain(modName, estParamsDesc, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg,
-                    zeta_static_arg, qz_criterium_arg, varobs_arg, riccati_tol_arg, lyapunov_tol_arg, noconstant_arg)
+                    zeta_static_arg, qz_criterium_arg, varobs_arg, riccati_tol_arg, lyapunov_tol_arg, noconstant_arg,
+                    fast_kalman_filter_arg, square_root_kalman_filter_arg)
 {
 
 }
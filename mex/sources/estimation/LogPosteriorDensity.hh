@@ -48,7 +48,8 @@ public:
                       const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
                       const std::vector<size_t> &zeta_static_arg, const double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                       double riccati_tol_arg, double lyapunov_tol_arg,
-                      bool noconstant_arg);
+                      bool noconstant_arg, bool fast_kalman_filter_arg,
+                      bool square_root_kalman_filter_arg);
 
   template <class VEC1, class VEC2>
   double
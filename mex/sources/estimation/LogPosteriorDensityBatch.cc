@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+///////////////////////////////////////////////////////////
+//  LogPosteriorDensityBatch.cpp
+//  Implementation of the Class LogPosteriorDensityBatch
+///////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <stdexcept>
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif
+
+#include "LogPosteriorDensityBatch.hh"
+
+/**
+ * Workspace of one thread
+ */
+class LogPosteriorDensityBatch::Workspace
+{
+private:
+  Vector steadyStateData, deepParamsData, estParams;
+  Matrix QData, H;
+  VectorView steadyState, deepParams;
+  MatrixView Q;
+  LogPosteriorDensity lpd;
+public:
+  // Message of the first error of the system
+  std::string errMsg;
+
+  Workspace(const std::string &modName, EstimatedParametersDescription &estParamsDesc, size_t n_endo, size_t n_exo,
+            const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
+            const std::vector<size_t> &zeta_static_arg, const double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
+            double riccati_tol_arg, double lyapunov_tol_arg, bool noconstant_arg, bool fast_kalman_filter_arg,
+            bool square_root_kalman_filter_arg, const Vector &steadyState_arg, const Vector &deepParams_arg,
+            const Matrix &Q_arg, const Matrix &H_arg) :
+    steadyStateData(steadyState_arg.getSize()), deepParamsData(deepParams_arg.getSize()),
+    estParams(estParamsDesc.estParams.size()),
+    QData(Q_arg.getRows(), Q_arg.getCols()), H(H_arg),
+    steadyState(steadyStateData, 0, steadyStateData.getSize()),
+    deepParams(deepParamsData, 0, deepParamsData.getSize()),
+    Q(QData.getData(), QData.getRows(), QData.getCols(), QData.getLd()),
+    lpd(modName, estParamsDesc, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg,
+        zeta_static_arg, qz_criterium_arg, varobs_arg, riccati_tol_arg, lyapunov_tol_arg, noconstant_arg,
+        fast_kalman_filter_arg, square_root_kalman_filter_arg)
+  {
+  };
+
+  double
+  compute(const VectorConstView &draw, const MatrixConstView &data, size_t presampleStart,
+          EstimatedParametersDescription &estParamsDesc, const Vector &steadyState_arg,
+          const Vector &deepParams_arg, const Matrix &Q_arg, const Matrix &H_arg)
+  {
+    for (size_t i = 0; i < draw.getSize(); ++i)
+      if (draw(i) < estParamsDesc.estParams[i].lower_bound || draw(i) > estParamsDesc.estParams[i].upper_bound)
+        return -INFINITY;
+
+    estParams = draw;
+    steadyStateData = steadyState_arg;
+    deepParamsData = deepParams_arg;
+    QData = Q_arg;
+    H = H_arg;
+    try
+      {
+        return -lpd.compute(steadyState, estParams, deepParams, data, Q, H, presampleStart);
+      }
+    catch (const std::exception &e)
+      {
+        if (errMsg.empty())
+          errMsg = e.what();
+        return NAN;
+      }
+    catch (...)
+      {
+        // The model cannot be solved or filtered with these parameters
+        return -INFINITY;
+      }
+  };
+};
+
+LogPosteriorDensityBatch::~LogPosteriorDensityBatch()
+{
+  for (size_t i = 0; i < workspaces.size(); ++i)
+    delete workspaces[i];
+}
+
+LogPosteriorDensityBatch::LogPosteriorDensityBatch(const std::string &modName, EstimatedParametersDescription &estParamsDesc_arg, size_t n_endo, size_t n_exo,
+                                                   const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
+                                                   const std::vector<size_t> &zeta_static_arg, const double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
+                                                   double riccati_tol_arg, double lyapunov_tol_arg,
+                                                   bool noconstant_arg, bool fast_kalman_filter_arg,
+                                                   bool square_root_kalman_filter_arg,
+                                                   const VectorConstView &steadyState_arg, const VectorConstView &deepParams_arg,
+                                                   const MatrixConstView &Q_arg, const Matrix &H_arg, size_t number_of_threads) :
+  estParamsDesc(estParamsDesc_arg),
+  steadyState(steadyState_arg.getSize()), deepParams(deepParams_arg.getSize()),
+  Q(Q_arg.getRows(), Q_arg.getCols()), H(H_arg)
+{
+  steadyState = steadyState_arg;
+  deepParams = deepParams_arg;
+  Q = Q_arg;
+
+#ifndef USE_OMP
+  number_of_threads = 1;
+#endif
+  if (number_of_threads < 1)
+    number_of_threads = 1;
+  for (size_t i = 0; i < number_of_threads; ++i)
+    workspaces.push_back(new Workspace(modName, estParamsDesc, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg,
+                                       zeta_static_arg, qz_criterium_arg, varobs_arg, riccati_tol_arg, lyapunov_tol_arg,
+                                       noconstant_arg, fast_kalman_filter_arg, square_root_kalman_filter_arg,
+                                       steadyState, deepParams, Q, H));
+}
+
+void
+LogPosteriorDensityBatch::compute(const MatrixConstView &estParamsDraws, const MatrixConstView &data, size_t presampleStart,
+                                  VectorView &logPosteriors)
+{
+  assert(estParamsDraws.getRows() == estParamsDesc.estParams.size());
+  assert(estParamsDraws.getCols() == logPosteriors.getSize());
+
+  // The cost of a draw depends on the steady state solver and on the
+  // convergence of the filter, hence the dynamic schedule
+  int nDraws = (int) estParamsDraws.getCols();
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(workspaces.size()) schedule(dynamic)
+#endif
+  for (int i = 0; i < nDraws; ++i)
+    {
+#ifdef USE_OMP
+      Workspace &workspace = *workspaces[omp_get_thread_num()];
+#else
+      Workspace &workspace = *workspaces[0];
+#endif
+      logPosteriors(i) = workspace.compute(mat::get_col(estParamsDraws, i), data, presampleStart,
+                                           estParamsDesc, steadyState, deepParams, Q, H);
+    }
+
+  for (size_t i = 0; i < workspaces.size(); ++i)
+    if (!workspaces[i]->errMsg.empty())
+      {
+        std::string errMsg = workspaces[i]->errMsg;
+        for (size_t j = 0; j < workspaces.size(); ++j)
+          workspaces[j]->errMsg.clear();
+        throw std::runtime_error(errMsg);
+      }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+///////////////////////////////////////////////////////////
+//  LogPosteriorDensityBatch.hh
+//  Implementation of the Class LogPosteriorDensityBatch
+///////////////////////////////////////////////////////////
+
+#if !defined(LPDB_6E1C2F0A_43D5_4B7E_9A61_2C8E5D0B7F13__INCLUDED_)
+#define LPDB_6E1C2F0A_43D5_4B7E_9A61_2C8E5D0B7F13__INCLUDED_
+
+#include <string>
+#include <vector>
+
+#include "LogPosteriorDensity.hh"
+
+/**
+ * Class that calculates the Log Posterior Density of a batch of parameter
+ * vectors, for population based samplers, line searches of the mode finder and
+ * prior or posterior predictive analysis.
+ *
+ * The draws are evaluated concurrently (if compiled with OpenMP), each thread
+ * using its own workspace allocated once by the constructor: a
+ * LogPosteriorDensity (thus its model solution and Kalman filter buffers) and
+ * copies of the steady state, of the deep parameters and of the variances of
+ * the shocks and of the measurement errors. These copies are reset to the
+ * values given to the constructor before each evaluation, so that the result
+ * of a draw does not depend on the thread nor on the draws evaluated before.
+ */
+class LogPosteriorDensityBatch
+{
+
+public:
+  virtual ~LogPosteriorDensityBatch();
+
+  LogPosteriorDensityBatch(const std::string &modName, EstimatedParametersDescription &estParamsDesc, size_t n_endo, size_t n_exo,
+                           const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
+                           const std::vector<size_t> &zeta_static_arg, const double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
+                           double riccati_tol_arg, double lyapunov_tol_arg,
+                           bool noconstant_arg, bool fast_kalman_filter_arg,
+                           bool square_root_kalman_filter_arg,
+                           const VectorConstView &steadyState_arg, const VectorConstView &deepParams_arg,
+                           const MatrixConstView &Q_arg, const Matrix &H_arg, size_t number_of_threads);
+
+  /**
+   * Computes the log posterior density of each column of estParamsDraws
+   * (-INFINITY if a parameter is out of its bounds or if the model cannot be
+   * solved or filtered). Errors of the system (std::exception) are rethrown as
+   * a std::runtime_error once all the draws have been evaluated.
+   */
+  void compute(const MatrixConstView &estParamsDraws, const MatrixConstView &data, size_t presampleStart,
+               VectorView &logPosteriors);
+
+  size_t
+  getNumberOfThreads() const
+  {
+    return workspaces.size();
+  };
+
+private:
+  class Workspace;
+
+  EstimatedParametersDescription &estParamsDesc;
+  // Values of the steady state, deep parameters and variances before the first draw
+  Vector steadyState, deepParams;
+  Matrix Q, H;
+  std::vector<Workspace *> workspaces;
+
+};
+
+#endif // !defined(LPDB_6E1C2F0A_43D5_4B7E_9A61_2C8E5D0B7F13__INCLUDED_)
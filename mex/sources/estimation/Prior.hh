@@ -87,6 +87,13 @@ public:
     return 0.0;
   };
 
+  virtual double
+  quantile(double p) // inverse of the cumulative distribution function, for drawing from the prior with uniform draws p
+  {
+    std::cout << "Parent quantile undefined at parent level" << std::endl;
+    return 0.0;
+  };
+
   static Prior *constructPrior(pShape shape, double mean, double standard, double lower_bound, double upper_bound, double fhp, double shp);
 };
 
@@ -121,6 +128,12 @@ public:
   {
     return 0.0;
   };
+
+  virtual double
+  quantile(double p)
+  {
+    return lower_bound + (upper_bound-lower_bound)*boost::math::quantile(distribution, p);
+  };
 };
 
 struct GammaPrior : public Prior
@@ -150,6 +163,11 @@ public:
   {
     return 0.0;
   };
+  virtual double
+  quantile(double p)
+  {
+    return lower_bound + boost::math::quantile(distribution, p);
+  };
 };
 
 //  X ~ IG1(s,nu) if X = sqrt(Y) where Y ~ IG2(s,nu) and Y = inv(Z) with Z ~ G(nu/2,2/s) (Gamma distribution)
@@ -184,6 +202,11 @@ public:
   {
     return 0.0;
   };
+  virtual double
+  quantile(double p)
+  {
+    return lower_bound + 1/sqrt(boost::math::quantile(boost::math::complement(distribution, p)));
+  };
 };
 
 // If x~InvGamma(a,b) , then  1/x ~Gamma(a,1/b) distribution
@@ -220,6 +243,11 @@ public:
   {
     return 0.0;
   };
+  virtual double
+  quantile(double p)
+  {
+    return lower_bound + 1/boost::math::quantile(boost::math::complement(distribution, p));
+  };
 };
 
 struct GaussianPrior : public Prior
@@ -258,6 +286,14 @@ public:
   {
     return vrng();
   };
+  virtual double
+  quantile(double p)
+  {
+    // The density is truncated to the bounds
+    double cdfLower = std::isinf(lower_bound) ? 0.0 : boost::math::cdf(distribution, lower_bound);
+    double cdfUpper = std::isinf(upper_bound) ? 1.0 : boost::math::cdf(distribution, upper_bound);
+    return boost::math::quantile(distribution, cdfLower + p*(cdfUpper-cdfLower));
+  };
 };
 
 struct UniformPrior : public Prior
@@ -296,6 +332,11 @@ public:
   {
     return vrng();
   };
+  virtual double
+  quantile(double p)
+  {
+    return boost::math::quantile(distribution, p);
+  };
 
 };
 
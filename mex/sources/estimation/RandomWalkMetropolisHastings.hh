@@ -28,6 +28,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include "LogPosteriorDensity.hh"
 #include "Proposal.hh"
 
@@ -36,11 +37,18 @@ class RandomWalkMetropolisHastings
 
 private:
   Vector parDraw, newParDraw;
+  std::string urandFileName, drawFileName; // trace files, one pair per MH block (chain)
 
 public:
-  RandomWalkMetropolisHastings(size_t size) :
+  RandomWalkMetropolisHastings(size_t size, size_t block) :
     parDraw(size), newParDraw(size)
   {
+    std::stringstream ssFName;
+    ssFName << "urand_blck" << block << ".csv";
+    urandFileName = ssFName.str();
+    ssFName.str("");
+    ssFName << "paramdraws_blck" << block << ".csv";
+    drawFileName = ssFName.str();
   };
   virtual ~RandomWalkMetropolisHastings() {};
 
@@ -52,8 +60,8 @@ public:
   {
     //streambuf *likbuf, *drawbuf *backup;
     std::ofstream urandfilestr, drawfilestr;
-    urandfilestr.open("urand.csv");
-    drawfilestr.open("paramdraws.csv");
+    urandfilestr.open(urandFileName.c_str());
+    drawfilestr.open(drawFileName.c_str());
 
     bool overbound;
     double newLogpost, logpost, urand;
@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+///////////////////////////////////////////////////////////
+//  SequentialMonteCarlo.cpp
+//  Implementation of the Class SequentialMonteCarlo
+///////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "SequentialMonteCarlo.hh"
+
+// Maximum number of rounds of prior draws to get particles with a finite likelihood
+static const size_t maxInitializationRounds = 100;
+// Number of bisections of the tempering increment
+static const size_t maxBisections = 50;
+
+/**
+ * Ratio of the conditional effective sample size of the incremental weights
+ * L(theta)^increment to the number of particles
+ */
+static double
+cessRatio(const Vector &weights, const Vector &logLik, double maxLogLik, double increment)
+{
+  double s1 = 0, s2 = 0;
+  for (size_t j = 0; j < weights.getSize(); ++j)
+    {
+      double w = exp(increment*(logLik(j)-maxLogLik));
+      s1 += weights(j)*w;
+      s2 += weights(j)*w*w;
+    }
+  return s1*s1/s2;
+}
+
+static double
+maxFinite(const Vector &v)
+{
+  double m = -INFINITY;
+  for (size_t j = 0; j < v.getSize(); ++j)
+    if (std::isfinite(v(j)) && v(j) > m)
+      m = v(j);
+  return m;
+}
+
+SequentialMonteCarlo::~SequentialMonteCarlo()
+{
+}
+
+SequentialMonteCarlo::SequentialMonteCarlo(LogPosteriorDensityBatch &lpdBatch_arg, EstimatedParametersDescription &estParamsDesc_arg,
+                                           size_t nParticles_arg, size_t nMutationSteps_arg, double cessTarget_arg,
+                                           ResamplingScheme resamplingScheme_arg, double resamplingThreshold_arg, int seed_arg) :
+  lpdBatch(lpdBatch_arg), estParamsDesc(estParamsDesc_arg), logPriorDensity(estParamsDesc_arg),
+  nParticles(nParticles_arg), nMutationSteps(nMutationSteps_arg), npar(estParamsDesc_arg.estParams.size()),
+  cessTarget(cessTarget_arg), resamplingThreshold(resamplingThreshold_arg), resamplingScheme(resamplingScheme_arg),
+  particles(npar, nParticles), proposals(npar, nParticles), normalDraws(npar, nParticles),
+  logLik(nParticles), logPrior(nParticles), weights(nParticles),
+  newLogPost(nParticles), newLogLik(nParticles), newLogPrior(nParticles), param(npar),
+  mean(npar), centered(npar, nParticles), cholCovariance(npar),
+  cumulatedWeights(nParticles), ancestors(nParticles),
+  scale(2.38/sqrt((double) npar)), acceptanceRate(0),
+  uniform_rng_type(0, 1), // uniform random number generator distribution type
+  uniformVrng(base_rng, uniform_rng_type), // uniform random variate_generator
+  normal_rng_type(0, 1), // normal random number generator distribution type (mean, standard)
+  normalVrng(base_rng, normal_rng_type) // normal random variate_generator
+{
+  assert(nParticles > 0);
+  assert(cessTarget > 0 && cessTarget < 1);
+  seed(seed_arg);
+}
+
+void
+SequentialMonteCarlo::seed(int seed_arg)
+{
+  base_rng.seed(seed_arg);
+}
+
+double
+SequentialMonteCarlo::compute(const MatrixConstView &data, size_t presampleStart, const std::string &particlesFileName)
+{
+  std::ofstream particlesFile;
+  if (!particlesFileName.empty())
+    {
+      particlesFile.open(particlesFileName.c_str());
+      if (!particlesFile.is_open())
+        throw std::runtime_error("SequentialMonteCarlo: cannot open " + particlesFileName);
+      particlesFile.precision(16);
+    }
+
+  scale = 2.38/sqrt((double) npar);
+  acceptanceRate = 0;
+  temperatures.clear();
+
+  double phi = 0, logMarginalDensity = 0;
+  initialize(data, presampleStart);
+  temperatures.push_back(phi);
+  if (particlesFile.is_open())
+    writeParticles(particlesFile, 0, phi);
+
+  while (phi < 1)
+    {
+      double newPhi = nextTemperature(phi);
+      logMarginalDensity += reweight(phi, newPhi);
+      phi = newPhi;
+      temperatures.push_back(phi);
+
+      double sumSquaredWeights = 0;
+      for (size_t j = 0; j < nParticles; ++j)
+        sumSquaredWeights += weights(j)*weights(j);
+      if (1/sumSquaredWeights < resamplingThreshold*nParticles)
+        resample();
+
+      mutate(phi, data, presampleStart);
+      if (particlesFile.is_open())
+        writeParticles(particlesFile, temperatures.size()-1, phi);
+    }
+
+  return logMarginalDensity;
+}
+
+/**
+ * Draws the particles from the prior, by inversion of the cumulative
+ * distribution functions, and redraws those for which the model cannot be
+ * solved or filtered
+ */
+void
+SequentialMonteCarlo::initialize(const MatrixConstView &data, size_t presampleStart)
+{
+  size_t nFilled = 0;
+  for (size_t round = 0; nFilled < nParticles; ++round)
+    {
+      if (round == maxInitializationRounds)
+        throw std::runtime_error("SequentialMonteCarlo: too many prior draws with a zero likelihood");
+
+      size_t nMissing = nParticles - nFilled;
+      for (size_t j = 0; j < nMissing; ++j)
+        for (size_t i = 0; i < npar; ++i)
+          {
+            double u;
+            do
+              u = uniformDraw();
+            while (u == 0);
+            proposals(i, j) = estParamsDesc.estParams[i].prior->quantile(u);
+          }
+      evaluate(data, presampleStart, nMissing);
+
+      for (size_t j = 0; j < nMissing; ++j)
+        if (std::isfinite(newLogLik(j)))
+          {
+            for (size_t i = 0; i < npar; ++i)
+              particles(i, nFilled) = proposals(i, j);
+            logLik(nFilled) = newLogLik(j);
+            logPrior(nFilled) = newLogPrior(j);
+            nFilled++;
+          }
+    }
+  weights.setAll(1.0/nParticles);
+}
+
+void
+SequentialMonteCarlo::evaluate(const MatrixConstView &data, size_t presampleStart, size_t nDraws)
+{
+  const MatrixConstView draws(proposals, 0, 0, npar, nDraws);
+  VectorView logPosteriors(newLogPost, 0, nDraws);
+  lpdBatch.compute(draws, data, presampleStart, logPosteriors);
+
+  for (size_t j = 0; j < nDraws; ++j)
+    {
+      newLogLik(j) = -INFINITY;
+      newLogPrior(j) = -INFINITY;
+      if (std::isfinite(logPosteriors(j)))
+        {
+          param = mat::get_col(draws, j);
+          newLogPrior(j) = logPriorDensity.compute(param);
+          if (std::isfinite(newLogPrior(j)))
+            newLogLik(j) = logPosteriors(j) - newLogPrior(j);
+        }
+    }
+}
+
+/**
+ * Solves CESS(phi_s) = cessTarget by bisection on the increment of the temperature
+ */
+double
+SequentialMonteCarlo::nextTemperature(double phi)
+{
+  double maxLogLik = maxFinite(logLik);
+  if (cessRatio(weights, logLik, maxLogLik, 1-phi) >= cessTarget)
+    return 1;
+
+  double lo = 0, hi = 1-phi;
+  for (size_t k = 0; k < maxBisections; ++k)
+    {
+      double mid = (lo+hi)/2;
+      if (cessRatio(weights, logLik, maxLogLik, mid) >= cessTarget)
+        lo = mid;
+      else
+        hi = mid;
+    }
+  return lo > 0 ? phi+lo : phi+hi;
+}
+
+/**
+ * Multiplies the weights by the incremental weights L(theta)^(newPhi-phi),
+ * normalizes them and returns the log of their weighted mean, which is the
+ * contribution of the stage to the log marginal density
+ */
+double
+SequentialMonteCarlo::reweight(double phi, double newPhi)
+{
+  double increment = newPhi - phi;
+  double maxLogLik = maxFinite(logLik);
+  double sum = 0;
+  for (size_t j = 0; j < nParticles; ++j)
+    {
+      weights(j) *= exp(increment*(logLik(j)-maxLogLik));
+      sum += weights(j);
+    }
+  for (size_t j = 0; j < nParticles; ++j)
+    weights(j) /= sum;
+  return log(sum) + increment*maxLogLik;
+}
+
+void
+SequentialMonteCarlo::resample()
+{
+  double total = 0;
+  for (size_t j = 0; j < nParticles; ++j)
+    {
+      total += weights(j);
+      cumulatedWeights[j] = total;
+    }
+
+  switch (resamplingScheme)
+    {
+    case multinomial:
+      for (size_t j = 0; j < nParticles; ++j)
+        {
+          double u = uniformDraw()*total;
+          ancestors[j] = std::lower_bound(cumulatedWeights.begin(), cumulatedWeights.end(), u) - cumulatedWeights.begin();
+          if (ancestors[j] >= nParticles)
+            ancestors[j] = nParticles - 1;
+        }
+      break;
+    case systematic:
+      {
+        double u0 = uniformDraw();
+        size_t k = 0;
+        for (size_t j = 0; j < nParticles; ++j)
+          {
+            double u = (u0 + j)/nParticles*total;
+            while (k < nParticles - 1 && cumulatedWeights[k] < u)
+              k++;
+            ancestors[j] = k;
+          }
+      }
+      break;
+    }
+
+  proposals = particles;
+  newLogLik = logLik;
+  newLogPrior = logPrior;
+  for (size_t j = 0; j < nParticles; ++j)
+    {
+      for (size_t i = 0; i < npar; ++i)
+        particles(i, j) = proposals(i, ancestors[j]);
+      logLik(j) = newLogLik(ancestors[j]);
+      logPrior(j) = newLogPrior(ancestors[j]);
+    }
+  weights.setAll(1.0/nParticles);
+}
+
+/**
+ * Random walk Metropolis-Hastings steps targeting p(theta) L(theta)^phi
+ */
+void
+SequentialMonteCarlo::mutate(double phi, const MatrixConstView &data, size_t presampleStart)
+{
+  // Weighted covariance of the particles, and its lower Cholesky factor
+  mean.setAll(0.0);
+  for (size_t j = 0; j < nParticles; ++j)
+    for (size_t i = 0; i < npar; ++i)
+      mean(i) += weights(j)*particles(i, j);
+  for (size_t j = 0; j < nParticles; ++j)
+    for (size_t i = 0; i < npar; ++i)
+      centered(i, j) = sqrt(weights(j))*(particles(i, j)-mean(i));
+  blas::gemm("N", "T", 1.0, centered, centered, 0.0, cholCovariance);
+  if (lapack::choleskyDecomp(cholCovariance, "L") != 0)
+    {
+      // Degenerate cloud: random walk along the axes
+      for (size_t i = 0; i < npar; ++i)
+        {
+          double var = 0;
+          for (size_t j = 0; j < nParticles; ++j)
+            var += centered(i, j)*centered(i, j);
+          cholCovariance(i, i) = var > 0 ? sqrt(var) : 1e-4*(fabs(mean(i)) + 1e-4);
+        }
+      for (size_t j = 0; j < npar; ++j)
+        for (size_t i = 0; i < npar; ++i)
+          if (i != j)
+            cholCovariance(i, j) = 0;
+    }
+  else
+    for (size_t j = 1; j < npar; ++j)
+      for (size_t i = 0; i < j; ++i)
+        cholCovariance(i, j) = 0;
+
+  size_t accepted = 0;
+  for (size_t step = 0; step < nMutationSteps; ++step)
+    {
+      for (size_t j = 0; j < nParticles; ++j)
+        for (size_t i = 0; i < npar; ++i)
+          normalDraws(i, j) = normalVrng();
+      proposals = particles;
+      blas::gemm("N", "N", scale, cholCovariance, normalDraws, 1.0, proposals);
+
+      evaluate(data, presampleStart, nParticles);
+
+      for (size_t j = 0; j < nParticles; ++j)
+        {
+          double u = uniformDraw();
+          if (!std::isfinite(newLogLik(j)))
+            continue;
+          double logAlpha = newLogPrior(j) + phi*newLogLik(j) - (logPrior(j) + phi*logLik(j));
+          if (log(u) < logAlpha)
+            {
+              for (size_t i = 0; i < npar; ++i)
+                particles(i, j) = proposals(i, j);
+              logLik(j) = newLogLik(j);
+              logPrior(j) = newLogPrior(j);
+              accepted++;
+            }
+        }
+    }
+
+  // Scale the proposal of the next stage towards an acceptance rate of 25%
+  if (nMutationSteps > 0)
+    {
+      acceptanceRate = (double) accepted/(nMutationSteps*nParticles);
+      double e = exp(16*(acceptanceRate-0.25));
+      scale *= 0.95 + 0.10*e/(1+e);
+    }
+}
+
+void
+SequentialMonteCarlo::writeParticles(std::ofstream &particlesFile, size_t stage, double phi)
+{
+  for (size_t j = 0; j < nParticles; ++j)
+    {
+      particlesFile << stage << "," << phi << "," << weights(j) << "," << logLik(j) << "," << logPrior(j);
+      for (size_t i = 0; i < npar; ++i)
+        particlesFile << "," << particles(i, j);
+      particlesFile << "\n";
+    }
+  particlesFile.flush();
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+///////////////////////////////////////////////////////////
+//  SequentialMonteCarlo.hh
+//  Implementation of the Class SequentialMonteCarlo
+///////////////////////////////////////////////////////////
+
+#if !defined(SMC_3B7D9E21_8C4A_4F06_B5E2_71A0D6C93F58__INCLUDED_)
+#define SMC_3B7D9E21_8C4A_4F06_B5E2_71A0D6C93F58__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "LogPosteriorDensityBatch.hh"
+#include "LogPriorDensity.hh"
+#include "Proposal.hh"
+
+/**
+ * Sequential Monte Carlo sampler of the posterior distribution, moving a cloud
+ * of particles drawn from the prior to the posterior through the tempered
+ * densities p(theta) L(theta)^phi, 0 = phi_0 < phi_1 < ... < phi_S = 1.
+ *
+ * Each stage:
+ *  - chooses phi_s by bisection, so that the conditional effective sample size
+ *    of the incremental weights L(theta)^(phi_s - phi_(s-1)) is cessTarget times
+ *    the number of particles (adaptive tempering schedule);
+ *  - reweights the particles and updates the estimate of the log marginal
+ *    density of the data;
+ *  - resamples them (multinomial or systematic) when their effective sample
+ *    size falls below resamplingThreshold times the number of particles;
+ *  - mutates them with nMutationSteps random walk Metropolis-Hastings steps,
+ *    whose proposal is the Cholesky factor of the weighted covariance of the
+ *    particles, scaled so that the acceptance rate stays around 25%.
+ *
+ * The particles are evaluated through a LogPosteriorDensityBatch, hence
+ * concurrently. All random numbers are drawn by the calling thread, so that
+ * the sampler gives the same results whatever the number of threads.
+ *
+ * The cloud of each stage is appended to a CSV file as soon as the stage is
+ * over, so that the memory footprint does not grow with the number of stages.
+ */
+class SequentialMonteCarlo
+{
+
+public:
+  enum ResamplingScheme
+    {
+      multinomial = 1,
+      systematic = 2
+    };
+
+  virtual ~SequentialMonteCarlo();
+
+  SequentialMonteCarlo(LogPosteriorDensityBatch &lpdBatch_arg, EstimatedParametersDescription &estParamsDesc_arg,
+                       size_t nParticles_arg, size_t nMutationSteps_arg, double cessTarget_arg,
+                       ResamplingScheme resamplingScheme_arg, double resamplingThreshold_arg, int seed_arg);
+
+  /**
+   * Runs the sampler and returns the log marginal density of the data. The
+   * particles of each stage are written to particlesFileName (if not empty)
+   * as rows "stage,phi,weight,loglik,logprior,params...".
+   */
+  double compute(const MatrixConstView &data, size_t presampleStart, const std::string &particlesFileName);
+
+  void seed(int seed_arg);
+
+  // Particles (one per column) and normalized weights of the last stage
+  const Matrix &
+  getParticles() const
+  {
+    return particles;
+  };
+  const Vector &
+  getWeights() const
+  {
+    return weights;
+  };
+  const Vector &
+  getLogLikelihoods() const
+  {
+    return logLik;
+  };
+  // Tempering schedule phi_0, ..., phi_S
+  const std::vector<double> &
+  getTemperatures() const
+  {
+    return temperatures;
+  };
+  size_t
+  getNumberOfStages() const
+  {
+    return temperatures.size() - 1;
+  };
+  double
+  getAcceptanceRate() const
+  {
+    return acceptanceRate;
+  };
+
+private:
+  void initialize(const MatrixConstView &data, size_t presampleStart);
+  double nextTemperature(double phi);
+  double reweight(double phi, double newPhi);
+  void resample();
+  void mutate(double phi, const MatrixConstView &data, size_t presampleStart);
+  void writeParticles(std::ofstream &particlesFile, size_t stage, double phi);
+
+  // Computes newLogLik and newLogPrior of the first nDraws columns of proposals
+  void evaluate(const MatrixConstView &data, size_t presampleStart, size_t nDraws);
+
+  double
+  uniformDraw()
+  {
+    return uniformVrng();
+  };
+
+  LogPosteriorDensityBatch &lpdBatch;
+  EstimatedParametersDescription &estParamsDesc;
+  LogPriorDensity logPriorDensity;
+  const size_t nParticles, nMutationSteps, npar;
+  const double cessTarget, resamplingThreshold;
+  const ResamplingScheme resamplingScheme;
+
+  Matrix particles, proposals, normalDraws;
+  Vector logLik, logPrior, weights;
+  Vector newLogPost, newLogLik, newLogPrior, param;
+  // Weighted mean, covariance and Cholesky factor of the covariance of the particles
+  Vector mean;
+  Matrix centered, cholCovariance;
+  std::vector<double> cumulatedWeights, temperatures;
+  std::vector<size_t> ancestors;
+  double scale, acceptanceRate;
+
+  base_uniform_generator_type base_rng;
+  boost::uniform_real<> uniform_rng_type;
+  boost::variate_generator<base_uniform_generator_type &,  boost::uniform_real<> > uniformVrng;
+  boost::normal_distribution<double> normal_rng_type;
+  boost::variate_generator<base_uniform_generator_type &, boost::normal_distribution<double> > normalVrng;
+
+};
+
+#endif // !defined(SMC_3B7D9E21_8C4A_4F06_B5E2_71A0D6C93F58__INCLUDED_)
@@ -97,6 +97,21 @@ namespace blas
           B.getData(), &ldb, &beta, C.getData(), &ldc);
   }
 
+  //! Solution of a triangular system with a packed matrix
+  //  x := inv(A)*x,   or   x := inv(A')*x,
+  // where x is a vector and A is a n by n triangular matrix stored as
+  // AP(i + (j-1)*j/2) = A(i,j) for 1<=i<=j if uplo="U".
+  template<class Vec1, class Vec2>
+  inline void
+  tpsv(const char *uplo, const char *transa, const char *diag, const Vec1 &AP, Vec2 &X)
+  {
+    blas_int n = X.getSize();
+    assert(AP.getSize() == X.getSize()*(X.getSize()+1)/2);
+    assert(AP.getStride() == 1);
+    blas_int incx = X.getStride();
+    dtpsv(uplo, transa, diag, &n, AP.getData(), X.getData(), &incx);
+  }
+
   /* Level 3 */
 
   //! General matrix multiplication
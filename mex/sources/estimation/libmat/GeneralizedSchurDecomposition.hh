@@ -31,6 +31,10 @@ private:
   double *alphar, *alphai, *beta, *vsl, *work;
   lapack_int *bwork;
   static double criterium_static;
+#ifdef USE_OMP
+  // Each thread solving a model has its own criterium for selctg()
+# pragma omp threadprivate(criterium_static)
+#endif
   static lapack_int selctg(const double *alphar, const double *alphai, const double *beta);
 public:
   class GSDException
@@ -42,7 +46,6 @@ public:
   //! \todo Replace heuristic choice for workspace size by a query to determine the optimal size
   GeneralizedSchurDecomposition(size_t n_arg, double criterium_arg);
   virtual ~GeneralizedSchurDecomposition();
-  //! \todo Add a lock around the modification of criterium_static for making it thread-safe
   template<class Mat1, class Mat2, class Mat3>
   void compute(Mat1 &S, Mat2 &T, Mat3 &Z, size_t &sdim) throw (GSDException);
   template<class Mat1, class Mat2, class Mat3, class Mat4, class Mat5>
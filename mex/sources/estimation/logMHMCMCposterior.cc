@@ -111,18 +111,167 @@ fillEstParamsInfo(const mxArray *estim_params_info, EstimatedParameter::pType ty
     }
 }
 
+/**
+ * Workspace of one Metropolis-Hastings chain (MH block). The chains are run
+ * concurrently, so each of them owns its posterior density evaluator (and thus
+ * its model solution and Kalman filter buffers), its copies of the steady
+ * state, of the deep parameters and of the shocks covariance matrix which are
+ * updated by the evaluation, and a proposal with its own random number stream.
+ */
+class MHChain
+{
+private:
+  Vector steadyStateData, deepParamsData;
+  Matrix QData, H;
+  VectorView steadyState, deepParams;
+  MatrixView Q;
+  LogPosteriorDensity lpd;
+  RandomWalkMetropolisHastings rwmh;
+  Proposal pdd;
+  Vector startParams;
+public:
+  const size_t block;
+  // Draws of the current MH file and the position in the chain, only handled by the main thread
+  mxArray *mxMhLogPostDensPtr, *mxMhParamDrawsPtr;
+  double *mhLogPostDensData, *mhParamDrawsData;
+  size_t currInitSizeArray, irun, j;
+  double sux, jsux;
+  bool openOldFile;
+  // Return value and message of the last run
+  int iret;
+  std::string errMsg;
+
+  MHChain(size_t block_arg, const std::string &basename, EstimatedParametersDescription &epd, size_t n_endo, size_t n_exo,
+          const std::vector<size_t> &zeta_fwrd, const std::vector<size_t> &zeta_back, const std::vector<size_t> &zeta_mixed,
+          const std::vector<size_t> &zeta_static, double qz_criterium, const std::vector<size_t> &varobs,
+          double riccati_tol, double lyapunov_tol, bool noconstant, bool fast_kalman_filter,
+          bool square_root_kalman_filter,
+          const VectorView &steadyState_arg, const VectorView &deepParams_arg, const MatrixView &Q_arg, const Matrix &H_arg,
+          const VectorConstView &vJscale, const MatrixConstView &D);
+  virtual ~MHChain();
+  //! Fills the current MH file with draws starting from lastParameters, does not call the MEX API
+  void compute(const VectorView &lastParameters, const MatrixConstView &data, size_t presampleStart,
+               EstimatedParametersDescription &epd);
+};
+
+MHChain::MHChain(size_t block_arg, const std::string &basename, EstimatedParametersDescription &epd, size_t n_endo, size_t n_exo,
+                 const std::vector<size_t> &zeta_fwrd, const std::vector<size_t> &zeta_back, const std::vector<size_t> &zeta_mixed,
+                 const std::vector<size_t> &zeta_static, double qz_criterium, const std::vector<size_t> &varobs,
+                 double riccati_tol, double lyapunov_tol, bool noconstant, bool fast_kalman_filter,
+                 bool square_root_kalman_filter,
+                 const VectorView &steadyState_arg, const VectorView &deepParams_arg, const MatrixView &Q_arg, const Matrix &H_arg,
+                 const VectorConstView &vJscale, const MatrixConstView &D) :
+  steadyStateData(steadyState_arg.getSize()), deepParamsData(deepParams_arg.getSize()),
+  QData(Q_arg.getRows(), Q_arg.getCols()), H(H_arg),
+  steadyState(steadyStateData, 0, steadyStateData.getSize()),
+  deepParams(deepParamsData, 0, deepParamsData.getSize()),
+  Q(QData.getData(), QData.getRows(), QData.getCols(), QData.getLd()),
+  lpd(basename, epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
+      qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant, fast_kalman_filter,
+      square_root_kalman_filter),
+  rwmh(vJscale.getSize(), block_arg),
+  pdd(vJscale, D),
+  startParams(vJscale.getSize()),
+  block(block_arg),
+  mxMhLogPostDensPtr(0), mxMhParamDrawsPtr(0), mhLogPostDensData(0), mhParamDrawsData(0),
+  currInitSizeArray(0), irun(0), j(0), sux(0.0), jsux(0.0), openOldFile(false), iret(0)
+{
+  steadyStateData = steadyState_arg;
+  deepParamsData = deepParams_arg;
+  QData = Q_arg;
+  /* One random number stream per chain, seeded with the block number: the
+     draws of a chain do not depend on the number of threads nor on the order
+     in which the chains are run, but differ from the ones of the single
+     stream that the chains used to share */
+  pdd.seed((int) block);
+}
+
+MHChain::~MHChain()
+{
+  if (mxMhLogPostDensPtr)
+    mxDestroyArray(mxMhLogPostDensPtr);                                            // delete log post density array
+  if (mxMhParamDrawsPtr)
+    mxDestroyArray(mxMhParamDrawsPtr);                                            // delete accepted MCMC MH draws
+}
+
+void
+MHChain::compute(const VectorView &lastParameters, const MatrixConstView &data, size_t presampleStart,
+                 EstimatedParametersDescription &epd)
+{
+  std::stringstream ssErrMsg;
+  VectorView mhLogPostDens(mhLogPostDensData, currInitSizeArray, (size_t) 1);
+  MatrixView mhParamDraws(mhParamDrawsData, currInitSizeArray, startParams.getSize(), currInitSizeArray);
+
+  iret = 0;
+  startParams = lastParameters;
+  try
+    {
+      jsux = rwmh.compute(mhLogPostDens, mhParamDraws, steadyState, startParams, deepParams, data, Q, H,
+                          presampleStart, irun, currInitSizeArray, lpd, pdd, epd);
+    }
+  catch (const TSException &tse)
+    {
+      iret = -100;
+      ssErrMsg << " TSException Exception in RandomWalkMH dynamic_dll: " << tse.getMessage() << " \n";
+    }
+  catch (const DecisionRules::BlanchardKahnException &bke)
+    {
+      iret = -90;
+      ssErrMsg << " Too many Blanchard-Kahn Exceptions in RandomWalkMH : n_fwrd_vars " << bke.n_fwrd_vars
+               << " n_explosive_eigenvals " << bke.n_explosive_eigenvals << " \n";
+    }
+  catch (const GeneralizedSchurDecomposition::GSDException &gsde)
+    {
+      iret = -80;
+      ssErrMsg << " GeneralizedSchurDecomposition Exception in RandomWalkMH: info " << gsde.info << ", n " << gsde.n << "  \n";
+    }
+  catch (const LUSolver::LUException &lue)
+    {
+      iret = -70;
+      ssErrMsg << " LU Exception in RandomWalkMH : info " << lue.info << " \n";
+    }
+  catch (const VDVEigDecomposition::VDVEigException &vdve)
+    {
+      iret = -60;
+      ssErrMsg << " VDV Eig Exception in RandomWalkMH : " << vdve.message << " ,  info: " << vdve.info << "\n";
+    }
+  catch (const DiscLyapFast::DLPException &dlpe)
+    {
+      iret = -50;
+      ssErrMsg << " Lyapunov solver Exception in RandomWalkMH : " << dlpe.message << " ,  info: " << dlpe.info << "\n";
+    }
+  catch (const KalmanFilter::KalmanFilterException &kfe)
+    {
+      iret = -40;
+      ssErrMsg << " Kalman filter Exception in RandomWalkMH : " << kfe.message << "\n";
+    }
+  catch (const std::runtime_error &re)
+    {
+      iret = -3;
+      ssErrMsg << " Runtime Error Exception in RandomWalkMH: " << re.what() << " \n";
+    }
+  catch (const std::exception &e)
+    {
+      iret = -2;
+      ssErrMsg << " Standard System Exception in RandomWalkMH: " << e.what() << " \n";
+    }
+  catch (...)
+    {
+      iret = -1000;
+      ssErrMsg << " Unknown unhandled Exception in RandomWalkMH! \n";
+    }
+  errMsg = ssErrMsg.str();
+}
+
 int
-sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
-           VectorView &steadyState, VectorConstView &estParams, VectorView &deepParams, const MatrixConstView &data,
-           MatrixView &Q, Matrix &H, size_t presampleStart, const VectorConstView &nruns,
-           size_t fblock, size_t nBlocks, Proposal pdd, EstimatedParametersDescription &epd,
-           const std::string &resultsFileStem, size_t console_mode, size_t load_mh_file)
+sampleMHMC(std::vector<MHChain *> &chains, const MatrixConstView &data, size_t presampleStart, const VectorConstView &nruns,
+           size_t fblock, size_t nBlocks, size_t npar, EstimatedParametersDescription &epd,
+           const std::string &resultsFileStem, size_t console_mode, size_t load_mh_file, int number_of_threads)
 {
   enum {iMin, iMax};
   int iret = 0; // return value
-  std::vector<size_t> OpenOldFile(nBlocks, 0);
-  size_t jloop = 0, irun, j; // counters
-  double dsum, dmax, dmin, sux = 0, jsux = 0;
+  double dsum, dmax, dmin, sux, done, todo;
+  std::vector<MHChain *> running; // chains with draws left, advanced by one MH file at a time
   std::string mhFName;
   std::stringstream ssFName;
 #if defined MATLAB_MEX_FILE
@@ -141,7 +290,6 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
   int matfStatus;
 #endif
   FILE *fidlog;  // log file
-  size_t npar = estParams.getSize();
   Matrix MinMax(npar, 2);
 
   const mxArray *InitSizeArrayPtr = mexGetVariablePtr("caller", "InitSizeArray");
@@ -177,7 +325,6 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
 
   const mxArray *blockStartParamsPtr = mexGetVariable("caller", "ix2");
   MatrixView blockStartParamsMxVw(mxGetPr(blockStartParamsPtr), nBlocks, npar, nBlocks);
-  Vector startParams(npar);
 
   const mxArray *mxFirstLogLikPtr = mexGetVariable("caller", "ilogpo2");
   VectorView FirstLogLiK(mxGetPr(mxFirstLogLikPtr), nBlocks, 1);
@@ -204,10 +351,6 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
   mxArray *mxLastLogLikPtr = mxGetField(record, 0, "LastLogLiK");
   VectorView LastLogLiK(mxGetPr(mxLastLogLikPtr), nBlocks, 1);
 
-  mxArray *mxMhLogPostDensPtr = 0;
-  mxArray *mxMhParamDrawsPtr = 0;
-  size_t currInitSizeArray = 0;
-
 #if defined MATLAB_MEX_FILE
   // Waitbar
   mxArray *waitBarRhs[3], *waitBarLhs[1];
@@ -231,10 +374,10 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
 
   for (size_t b = fblock; b <= nBlocks; ++b)
     {
-      jloop = jloop+1;
+      MHChain &chain = *chains[b-fblock];
 
 #if defined MATLAB_MEX_FILE
-      if ((load_mh_file != 0)  && (fline(b) > 1) && OpenOldFile[b])
+      if ((load_mh_file != 0)  && (fline(b-1) > 1) && chain.openOldFile)
         {
           //  load(['./' MhDirectoryName '/' ModelName '_mh' int2str(NewFile(b)) '_blck' int2str(b) '.mat'])
           ssFName.clear();
@@ -245,51 +388,39 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
           mexPrintf("MHMCMC: Using interim partial draws file %s \n", mhFName.c_str());
           if (drawmat == 0)
             {
-              fline(b) = 1;
+              fline(b-1) = 1;
               mexPrintf("Error in MH: Can not open old draws Mat file for reading:  %s \n  \
                   Starting a new file instead! \n", mhFName.c_str());
             }
           else
             {
-              currInitSizeArray = (size_t) InitSizeArray(b-1);
-              mxMhParamDrawsPtr = matGetVariable(drawmat, "x2");
-              mxMhLogPostDensPtr = matGetVariable(drawmat, "logpo2");
+              chain.currInitSizeArray = (size_t) InitSizeArray(b-1);
+              chain.mxMhParamDrawsPtr = matGetVariable(drawmat, "x2");
+              chain.mxMhLogPostDensPtr = matGetVariable(drawmat, "logpo2");
               matClose(drawmat);
-              OpenOldFile[b] = 1;
+              chain.openOldFile = true;
             }
         } // end if
-      if (console_mode == 0)
-        {
-          ssbarTitle.clear();
-          ssbarTitle.str("");
-          ssbarTitle << "Please wait... Metropolis-Hastings  " << b << "/" << nBlocks << "  ...";
-          barTitle = ssbarTitle.str();
-          waitBarRhs[2] = mxCreateString(barTitle.c_str());
-          //strcpy( *mxGetPr(waitBarRhs[1]), mhFName.c_str());
-          *mxGetPr(waitBarRhs[0]) = (double) 0.0;
-          mexCallMATLAB(0, NULL, 3, waitBarRhs, "waitbar");
-          mxDestroyArray(waitBarRhs[2]);
-        }
 #else //if defined OCTAVE_MEX_FILE
-      if ((load_mh_file != 0)  && (fline(b) > 1) && OpenOldFile[b])
+      if ((load_mh_file != 0)  && (fline(b-1) > 1) && chain.openOldFile)
         {
           //  load(['./' MhDirectoryName '/' ModelName '_mh' int2str(NewFile(b)) '_blck' int2str(b) '.mat'])
-          if ((currInitSizeArray != (size_t) InitSizeArray(b-1)) &&   OpenOldFile[b] != 1)
+          if ((chain.currInitSizeArray != (size_t) InitSizeArray(b-1)) && !chain.openOldFile)
             {
               // new or different size result arrays/matrices
-              currInitSizeArray = (size_t) InitSizeArray(b-1);
-              if (mxMhLogPostDensPtr)
-                mxDestroyArray(mxMhLogPostDensPtr);                                                                                                          // log post density array
-              mxMhLogPostDensPtr = mxCreateDoubleMatrix(currInitSizeArray, 1, mxREAL);
-              if (mxMhLogPostDensPtr == NULL)
+              chain.currInitSizeArray = (size_t) InitSizeArray(b-1);
+              if (chain.mxMhLogPostDensPtr)
+                mxDestroyArray(chain.mxMhLogPostDensPtr);                                                                                                          // log post density array
+              chain.mxMhLogPostDensPtr = mxCreateDoubleMatrix(chain.currInitSizeArray, 1, mxREAL);
+              if (chain.mxMhLogPostDensPtr == NULL)
                 {
                   mexPrintf("Metropolis-Hastings mxMhLogPostDensPtr Initialisation failed!\n");
                   return (-1);
                 }
-              if (mxMhParamDrawsPtr)
-                mxDestroyArray(mxMhParamDrawsPtr);                                                                                                        // accepted MCMC MH draws
-              mxMhParamDrawsPtr =  mxCreateDoubleMatrix(currInitSizeArray, npar,  mxREAL);
-              if (mxMhParamDrawsPtr == NULL)
+              if (chain.mxMhParamDrawsPtr)
+                mxDestroyArray(chain.mxMhParamDrawsPtr);                                                                                                        // accepted MCMC MH draws
+              chain.mxMhParamDrawsPtr =  mxCreateDoubleMatrix(chain.currInitSizeArray, npar,  mxREAL);
+              if (chain.mxMhParamDrawsPtr == NULL)
                 {
                   mexPrintf("Metropolis-Hastings mxMhParamDrawsPtr Initialisation failed!\n");
                   return (-1);
@@ -303,7 +434,7 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
           drawmat = Mat_Open(mhFName.c_str(), MAT_ACC_RDONLY);
           if (drawmat == NULL)
             {
-              fline(b) = 1;
+              fline(b-1) = 1;
               mexPrintf("Error in MH: Can not open old draws Mat file for reading:  %s \n  \
                   Starting a new file instead! \n", mhFName.c_str());
             }
@@ -315,7 +446,7 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
               matvar = Mat_VarReadInfo(drawmat, (char *) "x2");
               if (matvar == NULL)
                 {
-                  fline(b) = 1;
+                  fline(b-1) = 1;
                   mexPrintf("Error in MH: Can not read old draws Mat file for reading:  %s \n  \
                       Starting a new file instead! \n", mhFName.c_str());
                 }
@@ -324,10 +455,10 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
                   // GetVariable(drawmat, "x2");
                   edge[0] = matvar->dims[0];
                   edge[1] = matvar->dims[1];
-                  err = Mat_VarReadData(drawmat, matvar, mxGetPr(mxMhParamDrawsPtr), start, stride, edge);
+                  err = Mat_VarReadData(drawmat, matvar, mxGetPr(chain.mxMhParamDrawsPtr), start, stride, edge);
                   if (err)
                     {
-                      fline(b) = 1;
+                      fline(b-1) = 1;
                       mexPrintf("Error in MH: Can not retreive old draws from Mat file:  %s \n  \
                           Starting a new file instead! \n", mhFName.c_str());
                     }
@@ -337,7 +468,7 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
               matvar = Mat_VarReadInfo(drawmat, (char *) "logpo2");
               if (matvar == NULL)
                 {
-                  fline(b) = 1;
+                  fline(b-1) = 1;
                   mexPrintf("Error in MH: Can not read old logPos Mat file for reading:  %s \n  \
                       Starting a new file instead! \n", mhFName.c_str());
                 }
@@ -346,133 +477,91 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
                   // GetVariable(drawmat, "x2");
                   edge[0] = matvar->dims[0];
                   edge[1] = matvar->dims[1];
-                  err = Mat_VarReadData(drawmat, matvar, mxGetPr(mxMhLogPostDensPtr), start, stride, edge);
+                  err = Mat_VarReadData(drawmat, matvar, mxGetPr(chain.mxMhLogPostDensPtr), start, stride, edge);
                   if (err)
                     {
-                      fline(b) = 1;
+                      fline(b-1) = 1;
                       mexPrintf("Error in MH: Can not retreive old logPos from Mat file:  %s \n  \
                           Starting a new file instead! \n", mhFName.c_str());
                     }
                   Mat_VarFree(matvar);
                 }
               Mat_Close(drawmat);
-              OpenOldFile[b] = 1;
+              chain.openOldFile = true;
             }
         } // end if
 
 #endif
+      chain.sux = 0.0;
+      chain.jsux = 0;
+      chain.irun = (size_t) fline(b-1);
+      chain.j = 0; //1;
+    }
 
-      VectorView LastParametersRow = mat::get_row(LastParameters, b-1);
-
-      sux = 0.0;
-      jsux = 0;
-      irun = (size_t) fline(b-1);
-      j = 0; //1;
-      while (j < nruns(b-1))
+  // The chains are run concurrently, one MH file of all of them at a
+  // time. Since the MEX API is not thread-safe, the draws arrays are
+  // allocated, saved and reported by the main thread in between.
+  while (true)
+    {
+      running.clear();
+      for (size_t b = fblock; b <= nBlocks; ++b)
         {
-          if ((currInitSizeArray != (size_t) InitSizeArray(b-1)) &&   OpenOldFile[b] != 1)
+          MHChain &chain = *chains[b-fblock];
+          if (chain.j >= nruns(b-1))
+            continue;
+          if ((chain.currInitSizeArray != (size_t) InitSizeArray(b-1)) && !chain.openOldFile)
             {
               // new or different size result arrays/matrices
-              currInitSizeArray = (size_t) InitSizeArray(b-1);
-              if (mxMhLogPostDensPtr)
-                mxDestroyArray(mxMhLogPostDensPtr);                                                                                                          // log post density array
-              mxMhLogPostDensPtr = mxCreateDoubleMatrix(currInitSizeArray, 1, mxREAL);
-              if (mxMhLogPostDensPtr == NULL)
+              chain.currInitSizeArray = (size_t) InitSizeArray(b-1);
+              if (chain.mxMhLogPostDensPtr)
+                mxDestroyArray(chain.mxMhLogPostDensPtr);                                                                                                          // log post density array
+              chain.mxMhLogPostDensPtr = mxCreateDoubleMatrix(chain.currInitSizeArray, 1, mxREAL);
+              if (chain.mxMhLogPostDensPtr == NULL)
                 {
                   mexPrintf("Metropolis-Hastings mxMhLogPostDensPtr Initialisation failed!\n");
                   return (-1);
                 }
-              if (mxMhParamDrawsPtr)
-                mxDestroyArray(mxMhParamDrawsPtr);                                                                                                        // accepted MCMC MH draws
-              mxMhParamDrawsPtr =  mxCreateDoubleMatrix(currInitSizeArray, npar,  mxREAL);
-              if (mxMhParamDrawsPtr == NULL)
+              if (chain.mxMhParamDrawsPtr)
+                mxDestroyArray(chain.mxMhParamDrawsPtr);                                                                                                        // accepted MCMC MH draws
+              chain.mxMhParamDrawsPtr =  mxCreateDoubleMatrix(chain.currInitSizeArray, npar,  mxREAL);
+              if (chain.mxMhParamDrawsPtr == NULL)
                 {
                   mexPrintf("Metropolis-Hastings mxMhParamDrawsPtr Initialisation failed!\n");
                   return (-1);
                 }
             }
-          startParams = LastParametersRow;
-          VectorView mhLogPostDens(mxGetPr(mxMhLogPostDensPtr), currInitSizeArray, (size_t) 1);
-          MatrixView mhParamDraws(mxGetPr(mxMhParamDrawsPtr), currInitSizeArray, npar, currInitSizeArray);
-          try
-            {
-              jsux = rwmh.compute(mhLogPostDens, mhParamDraws, steadyState, startParams, deepParams, data, Q, H,
-                                  presampleStart, irun, currInitSizeArray, lpd, pdd, epd);
-              irun = currInitSizeArray;
-              sux += jsux*currInitSizeArray;
-              j += currInitSizeArray; //j=j+1;
-            }
-          catch (const TSException &tse)
-            {
-              iret = -100;
-              mexPrintf(" TSException Exception in RandomWalkMH dynamic_dll: %s \n", (tse.getMessage()).c_str());
-              goto cleanup;
-            }
-          catch (const DecisionRules::BlanchardKahnException &bke)
-            {
-              iret = -90;
-              mexPrintf(" Too many Blanchard-Kahn Exceptions in RandomWalkMH : n_fwrd_vars %d n_explosive_eigenvals %d \n", bke.n_fwrd_vars, bke.n_explosive_eigenvals);
-              goto cleanup;
-            }
-          catch (const GeneralizedSchurDecomposition::GSDException &gsde)
-            {
-              iret = -80;
-              mexPrintf(" GeneralizedSchurDecomposition Exception in RandomWalkMH: info %d, n %d  \n", gsde.info, gsde.n);
-              goto cleanup;
-            }
-          catch (const LUSolver::LUException &lue)
-            {
-              iret = -70;
-              mexPrintf(" LU Exception in RandomWalkMH : info %d \n", lue.info);
-              goto cleanup;
-            }
-          catch (const VDVEigDecomposition::VDVEigException &vdve)
-            {
-              iret = -60;
-              mexPrintf(" VDV Eig Exception in RandomWalkMH : %s ,  info: %d\n", vdve.message.c_str(), vdve.info);
-              goto cleanup;
-            }
-          catch (const DiscLyapFast::DLPException &dlpe)
-            {
-              iret = -50;
-              mexPrintf(" Lyapunov solver Exception in RandomWalkMH : %s ,  info: %d\n", dlpe.message.c_str(), dlpe.info);
-              goto cleanup;
-            }
-          catch (const std::runtime_error &re)
-            {
-              iret = -3;
-              mexPrintf(" Runtime Error Exception in RandomWalkMH: %s \n", re.what());
-              goto cleanup;
-            }
-          catch (const std::exception &e)
-            {
-              iret = -2;
-              mexPrintf(" Standard System Exception in RandomWalkMH: %s \n", e.what());
-              goto cleanup;
-            }
-          catch (...)
-            {
-              iret = -1000;
-              mexPrintf(" Unknown unhandled Exception in RandomWalkMH! %s \n");
-              goto cleanup;
-            }
-
-#if defined MATLAB_MEX_FILE
-          if (console_mode)
-            mexPrintf("   MH: Computing Metropolis-Hastings (chain %d/%d): %3.f \b%% done, acceptance rate: %3.f \b%%\r", b, nBlocks, 100 * j/nruns(b-1), 100 * sux / j);
-          else
-            {
-              // Waitbar
-              ssbarTitle.clear();
-              ssbarTitle.str("");
-              ssbarTitle << "Metropolis-Hastings : " << b << "/" << nBlocks << " Acceptance: " << 100 * sux/j << "%";
-              barTitle = ssbarTitle.str();
-              waitBarRhs[2] = mxCreateString(barTitle.c_str());
-              *mxGetPr(waitBarRhs[0]) = j / nruns(b-1);
-              mexCallMATLAB(0, NULL, 3, waitBarRhs, "waitbar");
-              mxDestroyArray(waitBarRhs[2]);
+          chain.mhLogPostDensData = mxGetPr(chain.mxMhLogPostDensPtr);
+          chain.mhParamDrawsData = mxGetPr(chain.mxMhParamDrawsPtr);
+          running.push_back(&chain);
+        }
+      if (running.empty())
+        break;
 
-            }
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(number_of_threads)
+#endif
+      for (int i = 0; i < (int) running.size(); ++i)
+        running[i]->compute(mat::get_row(LastParameters, running[i]->block-1), data, presampleStart, epd);
+
+      for (size_t i = 0; i < running.size(); ++i)
+        if (running[i]->iret)
+          {
+            if (iret == 0)
+              iret = running[i]->iret;
+            mexPrintf("%s", running[i]->errMsg.c_str());
+          }
+      if (iret)
+        goto cleanup;
+
+      for (size_t i = 0; i < running.size(); ++i)
+        {
+          MHChain &chain = *running[i];
+          size_t b = chain.block;
+          VectorView mhLogPostDens(chain.mhLogPostDensData, chain.currInitSizeArray, (size_t) 1);
+          MatrixView mhParamDraws(chain.mhParamDrawsData, chain.currInitSizeArray, npar, chain.currInitSizeArray);
+          chain.irun = chain.currInitSizeArray;
+          chain.sux += chain.jsux*chain.currInitSizeArray;
+          chain.j += chain.currInitSizeArray; //j=j+1;
 
           // % Now I save the simulations
           // save draw  2 mat file ([MhDirectoryName '/' ModelName '_mh' int2str(NewFile(b)) '_blck' int2str(b) '.mat'],'x2','logpo2');
@@ -480,19 +569,20 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
           ssFName.str("");
           ssFName << resultsFileStem << DIRECTORY_SEPARATOR << "metropolis" << DIRECTORY_SEPARATOR << resultsFileStem << "_mh" << (size_t) NewFileVw(b-1) << "_blck" << b << ".mat";
           mhFName = ssFName.str();
+#if defined MATLAB_MEX_FILE
           drawmat = matOpen(mhFName.c_str(), "w");
           if (drawmat == 0)
             {
               mexPrintf("Error in MH: Can not open draws Mat file for writing:  %s \n", mhFName.c_str());
               exit(1);
             }
-          matfStatus = matPutVariable(drawmat, "x2", mxMhParamDrawsPtr);
+          matfStatus = matPutVariable(drawmat, "x2", chain.mxMhParamDrawsPtr);
           if (matfStatus)
             {
               mexPrintf("Error in MH: Can not use draws Mat file for writing:  %s \n", mhFName.c_str());
               exit(1);
             }
-          matfStatus = matPutVariable(drawmat, "logpo2", mxMhLogPostDensPtr);
+          matfStatus = matPutVariable(drawmat, "logpo2", chain.mxMhLogPostDensPtr);
           if (matfStatus)
             {
               mexPrintf("Error in MH: Can not usee draws Mat file for writing:  %s \n", mhFName.c_str());
@@ -500,24 +590,15 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
             }
           matClose(drawmat);
 #else
-
-          printf("   MH: Computing Metropolis-Hastings (chain %ld/%ld): %3.f \b%% done, acceptance rate: %3.f \b%%\r", b, nBlocks, 100 * j/nruns(b-1), 100 * sux / j);
-          // % Now I save the simulations
-          // save draw  2 mat file ([MhDirectoryName '/' ModelName '_mh' int2str(NewFile(b)) '_blck' int2str(b) '.mat'],'x2','logpo2');
-          ssFName.clear();
-          ssFName.str("");
-          ssFName << resultsFileStem << DIRECTORY_SEPARATOR << "metropolis" << DIRECTORY_SEPARATOR << resultsFileStem << "_mh" << (size_t) NewFileVw(b-1) << "_blck" << b << ".mat";
-          mhFName = ssFName.str();
-
           drawmat = Mat_Create(mhFName.c_str(), NULL);
           if (drawmat == 0)
             {
               mexPrintf("Error in MH: Can not open draws Mat file for writing:  %s \n", mhFName.c_str());
               exit(1);
             }
-          dims[0] = currInitSizeArray;
+          dims[0] = chain.currInitSizeArray;
           dims[1] = npar;
-          matvar = Mat_VarCreate("x2", MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, mxGetPr(mxMhParamDrawsPtr), 0);
+          matvar = Mat_VarCreate("x2", MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, chain.mhParamDrawsData, 0);
           matfStatus = Mat_VarWrite(drawmat, matvar, compression);
           Mat_VarFree(matvar);
           if (matfStatus)
@@ -527,7 +608,7 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
             }
           //matfStatus = matPutVariable(drawmat, "logpo2", mxMhLogPostDensPtr);
           dims[1] = 1;
-          matvar = Mat_VarCreate("logpo2", MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, mxGetPr(mxMhLogPostDensPtr), 0);
+          matvar = Mat_VarCreate("logpo2", MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, chain.mhLogPostDensData, 0);
           matfStatus = Mat_VarWrite(drawmat, matvar, compression);
           Mat_VarFree(matvar);
           if (matfStatus)
@@ -546,8 +627,8 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
           fprintf(fidlog, "\n");
           fprintf(fidlog, "%% Mh%dBlck%lu ( %s %s )\n", (int) NewFileVw(b-1), b, __DATE__, __TIME__);
           fprintf(fidlog, " \n");
-          fprintf(fidlog, "  Number of simulations.: %lu \n", currInitSizeArray); // (length(logpo2)) ');
-          fprintf(fidlog, "  Acceptation rate......: %f \n", jsux);
+          fprintf(fidlog, "  Number of simulations.: %lu \n", chain.currInitSizeArray); // (length(logpo2)) ');
+          fprintf(fidlog, "  Acceptation rate......: %f \n", chain.jsux);
           fprintf(fidlog, "  Posterior mean........:\n");
           for (size_t i = 0; i < npar; ++i)
             {
@@ -568,21 +649,53 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
           fprintf(fidlog, " \n");
           fclose(fidlog);
 
-          jsux = 0;
-          LastParametersRow = mat::get_row(mhParamDraws, currInitSizeArray-1); //x2(end,:);
-          LastLogLiK(b-1) = mhLogPostDens(currInitSizeArray-1); //logpo2(end);
-          InitSizeArray(b-1) = std::min((size_t) nruns(b-1)-j, MAX_nruns);
+          chain.jsux = 0;
+          VectorView LastParametersRow = mat::get_row(LastParameters, b-1);
+          LastParametersRow = mat::get_row(mhParamDraws, chain.currInitSizeArray-1); //x2(end,:);
+          LastLogLiK(b-1) = mhLogPostDens(chain.currInitSizeArray-1); //logpo2(end);
+          InitSizeArray(b-1) = std::min((size_t) nruns(b-1)-chain.j, MAX_nruns);
           // initialization of next file if necessary
           if (InitSizeArray(b-1))
             {
               NewFileVw(b-1)++; // = NewFile(b-1) + 1;
-              irun = 1;
+              chain.irun = 1;
             } // end
-          //irun++;
-        } // end  while % End of the simulations for one mh-block.
-      //record.
-      AcceptationRates(b-1) = sux/j;
-      OpenOldFile[b] = 0;
+          if (chain.j >= nruns(b-1))
+            {
+              // End of the simulations for one mh-block.
+              AcceptationRates(b-1) = chain.sux/chain.j;
+              chain.openOldFile = false;
+            }
+        }
+
+      // Merged progress of all the chains
+      done = 0.0;
+      todo = 0.0;
+      sux = 0.0;
+      for (size_t b = fblock; b <= nBlocks; ++b)
+        {
+          done += chains[b-fblock]->j;
+          todo += nruns(b-1);
+          sux += chains[b-fblock]->sux;
+        }
+#if defined MATLAB_MEX_FILE
+      if (console_mode)
+        mexPrintf("   MH: Computing Metropolis-Hastings (chains %d-%d/%d): %3.f \b%% done, acceptance rate: %3.f \b%%\r", fblock, nBlocks, nBlocks, 100 * done/todo, 100 * sux / done);
+      else
+        {
+          // Waitbar
+          ssbarTitle.clear();
+          ssbarTitle.str("");
+          ssbarTitle << "Metropolis-Hastings : " << fblock << "-" << nBlocks << "/" << nBlocks << " Acceptance: " << 100 * sux/done << "%";
+          barTitle = ssbarTitle.str();
+          waitBarRhs[2] = mxCreateString(barTitle.c_str());
+          *mxGetPr(waitBarRhs[0]) = done / todo;
+          mexCallMATLAB(0, NULL, 3, waitBarRhs, "waitbar");
+          mxDestroyArray(waitBarRhs[2]);
+        }
+#else
+      printf("   MH: Computing Metropolis-Hastings (chains %ld-%ld/%ld): %3.f \b%% done, acceptance rate: %3.f \b%%\r", fblock, nBlocks, nBlocks, 100 * done/todo, 100 * sux / done);
+#endif
     } // end % End of the loop over the mh-blocks.
 
   if (mexPutVariable("caller", "record_AcceptationRates", AcceptationRatesPtr))
@@ -602,11 +715,6 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
   mexPrintf("MH Cleanup !! \n");
 
  cleanup:
-  if (mxMhLogPostDensPtr)
-    mxDestroyArray(mxMhLogPostDensPtr);                                            // delete log post density array
-  if (mxMhParamDrawsPtr)
-    mxDestroyArray(mxMhParamDrawsPtr);                                            // delete accepted MCMC MH draws
-
 #ifdef MATLAB_MEX_FILE
   // Waitbar
   if (console_mode == 0)
@@ -623,7 +731,7 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
 
   // return error code or last line run in the last MH block sub-array
   if (iret == 0)
-    iret = (int) irun;
+    iret = (int) chains.back()->irun;
   return iret;
 
 }
@@ -685,6 +793,12 @@ logMCMCposterior(VectorConstView &estParams, const MatrixConstView &data,
   size_t console_mode = (size_t) *mxGetPr(mxGetField(options_, 0, "console_mode"));
   size_t load_mh_file = (size_t) *mxGetPr(mxGetField(options_, 0, "load_mh_file"));
 
+  // Number of MH chains run concurrently
+  int number_of_threads = 1;
+  const mxArray *threads_mx = mxGetField(options_, 0, "threads");
+  if (threads_mx != NULL && mxGetField(threads_mx, 0, "logMHMCMCposterior") != NULL)
+    number_of_threads = (int) *mxGetPr(mxGetField(threads_mx, 0, "logMHMCMCposterior"));
+
   std::vector<size_t> varobs;
   const mxArray *varobs_mx = mxGetField(options_, 0, "varobs_id");
   if (mxGetM(varobs_mx) != 1)
@@ -714,25 +828,27 @@ logMCMCposterior(VectorConstView &estParams, const MatrixConstView &data,
 
 
   bool noconstant = (bool) *mxGetPr(mxGetField(options_, 0, "noconstant"));
+  bool fast_kalman_filter = (bool) *mxGetPr(mxGetField(options_, 0, "fast_kalman_filter"));
+  bool square_root_kalman_filter = (bool) *mxGetPr(mxGetField(options_, 0, "square_root_kalman_filter"));
 
-  // Allocate LogPosteriorDensity object
-  LogPosteriorDensity lpd(basename, epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
-                          qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant);
-
-  // Construct MHMCMC Sampler
-  RandomWalkMetropolisHastings rwmh(estParams.getSize());
-  // Construct GaussianPrior drawDistribution m=0, sd=1
-  GaussianPrior drawGaussDist01(0.0, 1.0, -INFINITY, INFINITY, 0.0, 1.0);
   // get Jscale = diag(bayestopt_.jscale);
-  const Matrix Jscale(n_estParams);
   const VectorConstView vJscale(mxGetPr(mxGetField(bayestopt_, 0, "jscale")), n_estParams, 1);
-  Proposal pdd(vJscale, D);
+
+  // Allocate the workspaces of the MH chains: LogPosteriorDensity object, MHMCMC Sampler and proposal
+  std::vector<MHChain *> chains;
+  for (size_t b = fblock; b <= nBlocks; ++b)
+    chains.push_back(new MHChain(b, basename, epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
+                                 qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant, fast_kalman_filter,
+                                 square_root_kalman_filter, steadyState, deepParams, Q, H, vJscale, D));
 
   //sample MHMCMC draws and get get last line run in the last MH block sub-array
-  int lastMHblockArrayLine = sampleMHMC(lpd, rwmh, steadyState, estParams, deepParams, data, Q, H, presample,
-                                        nMHruns, fblock, nBlocks, pdd, epd, resultsFileStem, console_mode, load_mh_file);
+  int lastMHblockArrayLine = sampleMHMC(chains, data, presample, nMHruns, fblock, nBlocks, n_estParams, epd,
+                                        resultsFileStem, console_mode, load_mh_file, number_of_threads);
 
   // Cleanups
+  for (std::vector<MHChain *>::iterator it = chains.begin();
+       it != chains.end(); it++)
+    delete *it;
   for (std::vector<EstimatedParameter>::iterator it = estParamsInfo.begin();
        it != estParamsInfo.end(); it++)
     delete it->prior;
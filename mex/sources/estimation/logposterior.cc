@@ -181,10 +181,13 @@ logposterior(VEC1 &estParams, const MatrixConstView &data,
   EstimatedParametersDescription epd(estSubsamples, estParamsInfo);
 
   bool noconstant = (bool) *mxGetPr(mxGetField(options_, 0, "noconstant"));
+  bool fast_kalman_filter = (bool) *mxGetPr(mxGetField(options_, 0, "fast_kalman_filter"));
+  bool square_root_kalman_filter = (bool) *mxGetPr(mxGetField(options_, 0, "square_root_kalman_filter"));
 
   // Allocate LogPosteriorDensity object
   LogPosteriorDensity lpd(basename, epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
-                          qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant);
+                          qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant, fast_kalman_filter,
+                          square_root_kalman_filter);
 
   // Construct arguments of compute() method
 
@@ -282,4 +285,8 @@ mexFunction(int nlhs, mxArray *plhs[],
     {
       DYN_MEX_FUNC_ERR_MSG_TXT(e.message.c_str());
     }
+  catch (KalmanFilter::KalmanFilterException e)
+    {
+      DYN_MEX_FUNC_ERR_MSG_TXT(e.message.c_str());
+    }
 }
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <sys/time.h>
+
+#include "fs2000k2e.hh"
+
+const size_t Fs2000k2e::npar;
+const size_t Fs2000k2e::n_endo;
+const size_t Fs2000k2e::n_exo;
+const size_t Fs2000k2e::nobs;
+
+double
+wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+// Hyper-parameters of a beta prior with given mean and standard deviation on [0,1]
+static Prior *
+betaPrior(double mean, double std)
+{
+  double a = (1-mean)*mean*mean/(std*std) - mean;
+  double b = a*(1/mean - 1);
+  return Prior::constructPrior(Prior::Beta, mean, std, 0.0, 1.0, a, b);
+}
+
+static Prior *
+gaussianPrior(double mean, double std)
+{
+  return Prior::constructPrior(Prior::Gaussian, mean, std, -INFINITY, INFINITY, mean, std);
+}
+
+// Hyper-parameters of an inverse gamma (type 1) prior with given mean and infinite variance (nu=2)
+static Prior *
+invGamma1Prior(double mean)
+{
+  return Prior::constructPrior(Prior::Inv_gamma_1, mean, INFINITY, 0.0, INFINITY, 2*mean*mean/M_PI, 2.0);
+}
+
+Fs2000k2e::Fs2000k2e(const std::string &modName_arg, size_t nper) :
+  modName(modName_arg), qz_criterium(1.000001), riccati_tol(1e-6), lyapunov_tol(1e-15),
+  steadyState(n_endo), deepParams(npar), Q(n_exo), H(nobs), data(nobs, nper), priorMeans(9)
+{
+  double dYSparams [] = {
+    1.000199998312523,
+    0.993250551764778,
+    1.006996670195112,
+    1,
+    2.718562165733039,
+    1.007250753636589,
+    18.982191739915155,
+    0.860847884886309,
+    0.316729149714572,
+    0.861047883198832,
+    1.00853622757204,
+    0.991734328394345,
+    1.355876776121869,
+    1.00853622757204,
+    0.992853374047708
+  };
+
+  double dparams[] = {
+    0.3560,
+    0.9930,
+    0.0085,
+    1.0002,
+    0.1290,
+    0.6500,
+    0.0100
+  };
+
+  for (size_t i = 0; i < n_endo; ++i)
+    steadyState(i) = dYSparams[i];
+  for (size_t i = 0; i < npar; ++i)
+    deepParams(i) = dparams[i];
+
+  Q.setAll(0.0);
+  Q(0, 0) = 0.001256631601;
+  Q(1, 1) = 0.000078535044;
+  H.setAll(0.0);
+
+  // Set zeta vectors [0:(n-1)] from Matlab indices [1:n] so that:
+  // order_var = [ stat_var(:); pred_var(:); both_var(:); fwrd_var(:)];
+  size_t statc[] = { 4, 5, 6, 8, 9, 10, 11, 12, 14};
+  size_t back[] = {1, 7, 13};
+  size_t both[] = {2};
+  size_t fwd[] = { 3, 15};
+  for (int i = 0; i < 9; ++i)
+    zeta_static.push_back(statc[i]-1);
+  for (int i = 0; i < 3; ++i)
+    zeta_back.push_back(back[i]-1);
+  for (int i = 0; i < 1; ++i)
+    zeta_mixed.push_back(both[i]-1);
+  for (int i = 0; i < 2; ++i)
+    zeta_fwrd.push_back(fwd[i]-1);
+
+  size_t varobs_matlab[] = {12, 11};
+  for (size_t i = 0; i < nobs; ++i)
+    varobs.push_back(varobs_matlab[i]-1);
+
+  for (size_t t = 0; t < nper; ++t)
+    {
+      data(0, t) = steadyState(varobs[0]) + 0.005*sin(0.3*t);
+      data(1, t) = steadyState(varobs[1]) + 0.01*cos(0.7*t);
+    }
+
+  std::vector<EstimatedParameter> estParamsInfo;
+  std::vector<size_t> subSampleIDs;
+  subSampleIDs.push_back(0);
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::shock_SD, 0, 0, subSampleIDs, 0.0, INFINITY, invGamma1Prior(0.035449)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::shock_SD, 1, 0, subSampleIDs, 0.0, INFINITY, invGamma1Prior(0.008862)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 0, 0, subSampleIDs, 0.0, 1.0, betaPrior(0.356, 0.02)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 1, 0, subSampleIDs, 0.0, 1.0, betaPrior(0.993, 0.002)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 2, 0, subSampleIDs, -INFINITY, INFINITY, gaussianPrior(0.0085, 0.003)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 3, 0, subSampleIDs, -INFINITY, INFINITY, gaussianPrior(1.0002, 0.007)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 4, 0, subSampleIDs, 0.0, 1.0, betaPrior(0.129, 0.223)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 5, 0, subSampleIDs, 0.0, 1.0, betaPrior(0.65, 0.05)));
+  estParamsInfo.push_back(EstimatedParameter(EstimatedParameter::deepPar, 6, 0, subSampleIDs, 0.0, 1.0, betaPrior(0.01, 0.005)));
+  std::vector<EstimationSubsample> estSubsamples;
+  estSubsamples.push_back(EstimationSubsample(0, nper-1));
+  epd = new EstimatedParametersDescription(estSubsamples, estParamsInfo);
+
+  double means[] = { 0.035449, 0.008862, 0.356, 0.993, 0.0085, 1.0002, 0.129, 0.65, 0.01 };
+  for (size_t i = 0; i < priorMeans.getSize(); ++i)
+    priorMeans(i) = means[i];
+}
+
+Fs2000k2e::~Fs2000k2e()
+{
+  for (std::vector<EstimatedParameter>::iterator it = epd->estParams.begin();
+       it != epd->estParams.end(); it++)
+    delete it->prior;
+  delete epd;
+}
+
+LogPosteriorDensityBatch *
+Fs2000k2e::newBatch(size_t nThreads)
+{
+  return new LogPosteriorDensityBatch(modName, *epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
+                                      qz_criterium, varobs, riccati_tol, lyapunov_tol, false, false, false,
+                                      VectorConstView(steadyState, 0, n_endo), VectorConstView(deepParams, 0, npar),
+                                      MatrixConstView(Q, 0, 0, n_exo, n_exo), H, nThreads);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Model, artificial data and estimated parameters of fs2000k2e.mod, shared by
+// the tests of the estimation DLL that evaluate the posterior density
+
+#ifndef _FS2000K2E_HH
+#define _FS2000K2E_HH
+
+#include <string>
+#include <vector>
+
+#include "LogPosteriorDensityBatch.hh"
+
+// Wall clock time in seconds
+double wallTime();
+
+class Fs2000k2e
+{
+public:
+  static const size_t npar = 7, n_endo = 15, n_exo = 2, nobs = 2;
+
+  const std::string modName;
+  std::vector<size_t> zeta_fwrd, zeta_back, zeta_mixed, zeta_static, varobs;
+  double qz_criterium, riccati_tol, lyapunov_tol;
+  Vector steadyState, deepParams;
+  Matrix Q, H;
+  // Artificial data around the steady state of gp_obs and gy_obs
+  Matrix data;
+  // Estimated parameters in the order of estim_params_: stderr e_a, stderr e_m, alp, bet, gam, mst, rho, psi, del
+  EstimatedParametersDescription *epd;
+  Vector priorMeans;
+
+  // modName is the basename of the dynamic and static DLLs generated from fs2000k2e.mod
+  Fs2000k2e(const std::string &modName_arg, size_t nper);
+  ~Fs2000k2e();
+
+  size_t
+  getNumberOfEstimatedParameters() const
+  {
+    return epd->estParams.size();
+  };
+
+  // Batch evaluating the posterior density with the values of this fixture
+  LogPosteriorDensityBatch *newBatch(size_t nThreads);
+};
+
+#endif
@@ -17,6 +17,9 @@
  * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ctime>
+#include <cmath>
+
 #include "KalmanFilter.hh"
 
 int
@@ -109,7 +112,7 @@ main(int argc, char **argv)
 
   double lyapunov_tol = 1e-16;
   double riccati_tol = 1e-16;
-  int info = 0;
+  bool noconstant = false;
   Matrix yView(nobs, 192); // dummy
   yView.setAll(0.2);
   const MatrixConstView dataView(yView, 0,  0, nobs, yView.getCols()); // dummy
@@ -118,16 +121,98 @@ main(int argc, char **argv)
   Vector vll(yView.getCols());
   VectorView vwll(vll, 0, vll.getSize());
 
-  double penalty = 1e8;
-
   KalmanFilter kalman(modName, n_endo, n_exo,
                       zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
-                      varobs_arg, riccati_tol, lyapunov_tol, info);
+                      varobs_arg, riccati_tol, lyapunov_tol, noconstant, false, false);
+  KalmanFilter fastKalman(modName, n_endo, n_exo,
+                          zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
+                          varobs_arg, riccati_tol, lyapunov_tol, noconstant, true, false);
+  KalmanFilter sqrtKalman(modName, n_endo, n_exo,
+                          zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
+                          varobs_arg, riccati_tol, lyapunov_tol, noconstant, false, true);
 
   size_t start = 0, period = 0;
   double ll = kalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
-                             vwll, dataDetrendView, start, period, penalty, info);
+                             vwll, dataDetrendView, start, period);
+  double fastll = fastKalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
+                                     vwll, dataDetrendView, start, period);
+  double sqrtll = sqrtKalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
+                                     vwll, dataDetrendView, start, period);
 
   std::cout << "ll: " << std::endl << ll << std::endl;
-}
+  std::cout << "ll with the Chandrasekhar recursions: " << std::endl << fastll << std::endl;
+  std::cout << "difference: " << std::endl << ll-fastll << std::endl;
+  std::cout << "ll of the square root filter: " << std::endl << sqrtll << std::endl;
+  std::cout << "difference: " << std::endl << ll-sqrtll << std::endl;
+
+  // The filters must agree to rounding
+  const double tol = 1e-10;
+  if (!(fabs(ll-fastll) <= tol*fabs(ll)))
+    {
+      std::cerr << "the Chandrasekhar recursions give a different log likelihood" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  if (!(fabs(ll-sqrtll) <= tol*fabs(ll)))
+    {
+      std::cerr << "the square root filter gives a different log likelihood" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+  // Without the variance of e_m, m has no variance and Pstar is singular;
+  // the measurement errors keep F invertible for the standard filter
+  Matrix Qsing(n_exo), Hsing(nobs);
+  Qsing.setAll(0.0);
+  Qsing(0, 0) = vcov[0];
+  Hsing.setAll(0.0);
+  Hsing(0, 0) = Hsing(1, 1) = 1e-4;
+  double llsing = kalman.compute(dataView, steadyStateVW,  Qsing, Hsing, deepParams,
+                                 vwll, dataDetrendView, start, period);
+  double sqrtllsing = sqrtKalman.compute(dataView, steadyStateVW,  Qsing, Hsing, deepParams,
+                                         vwll, dataDetrendView, start, period);
+  std::cout << "ll with a singular Pstar: " << std::endl << llsing << std::endl;
+  std::cout << "difference with the square root filter: " << std::endl << llsing-sqrtllsing << std::endl;
+  if (!(fabs(llsing-sqrtllsing) <= tol*fabs(llsing)))
+    {
+      std::cerr << "the square root filter gives a different log likelihood with a singular Pstar" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+  // Without any shock nor measurement error, Pstar and F are zero: the square
+  // root filter must reject the draw
+  Qsing.setAll(0.0);
+  Hsing.setAll(0.0);
+  try
+    {
+      sqrtKalman.compute(dataView, steadyStateVW,  Qsing, Hsing, deepParams,
+                         vwll, dataDetrendView, start, period);
+      std::cerr << "the square root filter accepts a singular variance of the observations" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  catch (const KalmanFilter::KalmanFilterException &e)
+    {
+      std::cout << "singular F rejected: " << e.message << std::endl;
+    }
 
+  // Time the evaluation of the likelihood with both filters
+  const int nruns = 1000;
+  clock_t t0 = clock();
+  for (int i = 0; i < nruns; ++i)
+    kalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
+                   vwll, dataDetrendView, start, period);
+  clock_t t1 = clock();
+  for (int i = 0; i < nruns; ++i)
+    fastKalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
+                       vwll, dataDetrendView, start, period);
+  clock_t t2 = clock();
+  for (int i = 0; i < nruns; ++i)
+    sqrtKalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
+                       vwll, dataDetrendView, start, period);
+  clock_t t3 = clock();
+
+  std::cout << "CPU time of " << nruns << " runs of the standard filter: "
+            << (double) (t1-t0)/CLOCKS_PER_SEC << "s" << std::endl;
+  std::cout << "CPU time of " << nruns << " runs with the Chandrasekhar recursions: "
+            << (double) (t2-t1)/CLOCKS_PER_SEC << "s" << std::endl;
+  std::cout << "CPU time of " << nruns << " runs of the square root filter: "
+            << (double) (t3-t2)/CLOCKS_PER_SEC << "s" << std::endl;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Evaluates a batch of parameter draws of fs2000k2e.mod with one thread and
+// with several threads, and checks both against one evaluation at a time
+
+#include <cmath>
+#include <cstdlib>
+
+#include "fs2000k2e.hh"
+
+int
+main(int argc, char **argv)
+{
+  if (argc < 2)
+    {
+      std::cerr << argv[0] << ": please provide as argument the basename of the dynamic and static DLLs generated from fs2000k2e.mod (typically fs2000k2e), and optionally the number of threads and of draws" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+  size_t nThreads = argc > 2 ? atoi(argv[2]) : 4;
+  size_t nDraws = argc > 3 ? atoi(argv[3]) : 400;
+  size_t nper = 192;
+  Fs2000k2e fs(argv[1], nper);
+  const size_t npar = Fs2000k2e::npar, n_endo = Fs2000k2e::n_endo, n_exo = Fs2000k2e::n_exo, nobs = Fs2000k2e::nobs;
+  size_t nEstParams = fs.getNumberOfEstimatedParameters();
+  const MatrixConstView dataView(fs.data, 0, 0, nobs, nper);
+
+  // Draws scattered around the prior means
+  Matrix draws(nEstParams, nDraws);
+  srand(1);
+  for (size_t j = 0; j < nDraws; ++j)
+    for (size_t i = 0; i < nEstParams; ++i)
+      draws(i, j) = fs.priorMeans(i)*(1 + 0.1*((double) rand()/RAND_MAX - 0.5));
+  const MatrixConstView drawsView(draws, 0, 0, nEstParams, nDraws);
+
+  // One evaluation at a time
+  LogPosteriorDensity lpd(fs.modName, *fs.epd, n_endo, n_exo, fs.zeta_fwrd, fs.zeta_back, fs.zeta_mixed, fs.zeta_static,
+                          fs.qz_criterium, fs.varobs, fs.riccati_tol, fs.lyapunov_tol, false, false, false);
+  Vector refLogPost(nDraws), estParams(nEstParams), steadyStateWS(n_endo), deepParamsWS(npar);
+  Matrix QWS(n_exo), HWS(nobs);
+  VectorView steadyStateVW(steadyStateWS, 0, n_endo), deepParamsVW(deepParamsWS, 0, npar);
+  MatrixView QVW(QWS.getData(), n_exo, n_exo, n_exo);
+  double t0 = wallTime();
+  for (size_t j = 0; j < nDraws; ++j)
+    {
+      estParams = mat::get_col(drawsView, j);
+      steadyStateWS = fs.steadyState;
+      deepParamsWS = fs.deepParams;
+      QWS = fs.Q;
+      HWS = fs.H;
+      try
+        {
+          refLogPost(j) = -lpd.compute(steadyStateVW, estParams, deepParamsVW, dataView, QVW, HWS, 0);
+        }
+      catch (...)
+        {
+          refLogPost(j) = -INFINITY;
+        }
+    }
+  double t1 = wallTime();
+
+  // Batches
+  LogPosteriorDensityBatch *serial = fs.newBatch(1);
+  LogPosteriorDensityBatch *parallel = fs.newBatch(nThreads);
+  Vector serialLogPost(nDraws), parallelLogPost(nDraws);
+  VectorView serialVW(serialLogPost, 0, nDraws), parallelVW(parallelLogPost, 0, nDraws);
+  double t2 = wallTime();
+  serial->compute(drawsView, dataView, 0, serialVW);
+  double t3 = wallTime();
+  parallel->compute(drawsView, dataView, 0, parallelVW);
+  double t4 = wallTime();
+
+  size_t nDiff = 0, nInf = 0;
+  for (size_t j = 0; j < nDraws; ++j)
+    {
+      if (std::isinf(refLogPost(j)))
+        nInf++;
+      if (!(serialLogPost(j) == refLogPost(j) && parallelLogPost(j) == refLogPost(j)))
+        nDiff++;
+    }
+
+  std::cout << "log posterior of the first draw: " << refLogPost(0) << std::endl;
+  std::cout << nInf << " of " << nDraws << " draws have a zero posterior density" << std::endl;
+  std::cout << "wall time of " << nDraws << " evaluations one at a time: " << t1-t0 << "s" << std::endl;
+  std::cout << "wall time of the batch with 1 thread: " << t3-t2 << "s" << std::endl;
+  std::cout << "wall time of the batch with " << parallel->getNumberOfThreads() << " threads: " << t4-t3 << "s" << std::endl;
+
+  delete serial;
+  delete parallel;
+
+  if (nDiff > 0)
+    {
+      std::cerr << nDiff << " draws have a different log posterior in the batches" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+}
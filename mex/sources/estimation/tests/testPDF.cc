@@ -17,10 +17,26 @@
  * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-// test for Prior pdfs and basic random number generators
+// test for Prior pdfs, quantiles and basic random number generators
+
+#include <cstdlib>
+#include <cmath>
 
 #include "Prior.hh"
 
+using namespace boost::math;
+
+// Checks that the cumulative distribution function of a prior, computed
+// independently of Prior::quantile(), is p at the quantile x of p
+static bool
+checkQuantile(const char *name, double p, double x, double cdf)
+{
+  if (fabs(cdf - p) < 1e-10)
+    return true;
+  std::cerr << name << ": the cdf at the quantile " << x << " of " << p << " is " << cdf << std::endl;
+  return false;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -73,4 +89,40 @@ main(int argc, char **argv)
       updf = gp2.pdf(ur);
       std::cout << "Gaussian pdf of : "  << ur << " = " << updf << std::endl;
     }
+
+  InvGamma1_Prior ig1p(0.1, INFINITY, 0.0, INFINITY, 0.02, 2.0);
+  InvGamma2_Prior ig2p(0.1, INFINITY, 0.0, INFINITY, 0.1, 4.0);
+  Prior *priors[] = { &bp, bpp, gpp, &ig1p, &ig2p, &gp, &up };
+  const char *names[] = { "Beta (5,1)", "Beta (1,5)", "Gamma (1,5)", "InvGamma1 (0.02,2)", "InvGamma2 (0.1,4)",
+                          "Gaussian (20,100) truncated to [1,10]", "Uniform (20,100)" };
+  std::cout << std::endl << "Quantiles at 0.1, 0.5, 0.9: "  << std::endl;
+  for (int i = 0; i < 7; i++)
+    std::cout << names[i] << ": " << priors[i]->quantile(0.1) << " " << priors[i]->quantile(0.5)
+              << " " << priors[i]->quantile(0.9) << std::endl;
+
+  // The inverse gamma priors are the laws of 1/sqrt(Z) and 1/Z, with Z ~ G(shp/2, 2/fhp)
+  gamma_distribution<double> ig1z(2.0/2, 2/0.02), ig2z(4.0/2, 2/0.1);
+  normal_distribution<double> gpd(20, 100);
+  const double ps[] = { 1e-3, 0.1, 0.5, 0.9, 1-1e-3 };
+  bool ok = true;
+  for (int i = 0; i < 5; i++)
+    {
+      double p = ps[i], x;
+      x = bp.quantile(p);
+      ok = checkQuantile(names[0], p, x, cdf(beta_distribution<double>(5, 1), x)) && ok;
+      x = bpp->quantile(p);
+      ok = checkQuantile(names[1], p, x, cdf(beta_distribution<double>(1, 5), x)) && ok;
+      x = gpp->quantile(p);
+      ok = checkQuantile(names[2], p, x, cdf(gamma_distribution<double>(1, 5), x)) && ok;
+      x = ig1p.quantile(p);
+      ok = checkQuantile(names[3], p, x, cdf(complement(ig1z, 1/(x*x)))) && ok;
+      x = ig2p.quantile(p);
+      ok = checkQuantile(names[4], p, x, cdf(complement(ig2z, 1/x))) && ok;
+      x = gp.quantile(p);
+      ok = checkQuantile(names[5], p, x, (cdf(gpd, x) - cdf(gpd, 1))/(cdf(gpd, 10) - cdf(gpd, 1))) && ok;
+      x = up.quantile(p);
+      ok = checkQuantile(names[6], p, x, cdf(uniform_distribution<double>(20, 100), x)) && ok;
+    }
+  if (!ok)
+    exit(EXIT_FAILURE);
 };
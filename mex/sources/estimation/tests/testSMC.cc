@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Runs the sequential Monte Carlo sampler on fs2000k2e.mod with one thread and
+// with several threads, and checks that both give the same particles, that the
+// tempering schedule increases strictly from 0 to 1 and that the log marginal
+// density is finite
+
+#include <cstdlib>
+#include <cmath>
+
+#include "fs2000k2e.hh"
+#include "SequentialMonteCarlo.hh"
+
+int
+main(int argc, char **argv)
+{
+  if (argc < 2)
+    {
+      std::cerr << argv[0] << ": please provide as argument the basename of the dynamic and static DLLs generated from fs2000k2e.mod (typically fs2000k2e), and optionally the number of threads and of particles" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+  size_t nThreads = argc > 2 ? atoi(argv[2]) : 4;
+  size_t nParticles = argc > 3 ? atoi(argv[3]) : 400;
+  size_t nper = 192;
+  Fs2000k2e fs(argv[1], nper);
+  size_t nEstParams = fs.getNumberOfEstimatedParameters();
+  const MatrixConstView dataView(fs.data, 0, 0, Fs2000k2e::nobs, nper);
+
+  size_t nMutationSteps = 3;
+  double cessTarget = 0.95, resamplingThreshold = 0.5;
+
+  LogPosteriorDensityBatch *serial = fs.newBatch(1);
+  LogPosteriorDensityBatch *parallel = fs.newBatch(nThreads);
+  SequentialMonteCarlo serialSMC(*serial, *fs.epd, nParticles, nMutationSteps, cessTarget,
+                                 SequentialMonteCarlo::systematic, resamplingThreshold, 1);
+  SequentialMonteCarlo parallelSMC(*parallel, *fs.epd, nParticles, nMutationSteps, cessTarget,
+                                   SequentialMonteCarlo::systematic, resamplingThreshold, 1);
+
+  // No particle file: the clouds are compared in memory
+  double t0 = wallTime();
+  double serialLogMD = serialSMC.compute(dataView, 0, "");
+  double t1 = wallTime();
+  double parallelLogMD = parallelSMC.compute(dataView, 0, "");
+  double t2 = wallTime();
+
+  const Matrix &serialParticles = serialSMC.getParticles();
+  const Matrix &parallelParticles = parallelSMC.getParticles();
+  const Vector &weights = parallelSMC.getWeights();
+  const std::vector<double> &temperatures = parallelSMC.getTemperatures();
+  size_t nDiff = 0;
+  for (size_t j = 0; j < nParticles; ++j)
+    for (size_t i = 0; i < nEstParams; ++i)
+      if (serialParticles(i, j) != parallelParticles(i, j))
+        nDiff++;
+
+  std::cout << "log marginal density: " << parallelLogMD << std::endl;
+  std::cout << parallelSMC.getNumberOfStages() << " stages, acceptance rate of the last mutation: "
+            << parallelSMC.getAcceptanceRate() << std::endl;
+  std::cout << "posterior means:";
+  for (size_t i = 0; i < nEstParams; ++i)
+    {
+      double m = 0;
+      for (size_t j = 0; j < nParticles; ++j)
+        m += weights(j)*parallelParticles(i, j);
+      std::cout << " " << m;
+    }
+  std::cout << std::endl;
+  std::cout << "wall time with 1 thread: " << t1-t0 << "s" << std::endl;
+  std::cout << "wall time with " << parallel->getNumberOfThreads() << " threads: " << t2-t1 << "s" << std::endl;
+
+  delete serial;
+  delete parallel;
+
+  if (nDiff > 0 || serialLogMD != parallelLogMD)
+    {
+      std::cerr << "the samplers with 1 and " << nThreads << " threads differ" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  if (temperatures.size() < 2 || temperatures.front() != 0 || temperatures.back() != 1)
+    {
+      std::cerr << "the tempering schedule does not go from 0 to 1" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  for (size_t s = 1; s < temperatures.size(); ++s)
+    if (!(temperatures[s] > temperatures[s-1]))
+      {
+        std::cerr << "the temperatures of stages " << s-1 << " and " << s << " do not increase: "
+                  << temperatures[s-1] << " " << temperatures[s] << std::endl;
+        exit(EXIT_FAILURE);
+      }
+  if (!std::isfinite(parallelLogMD))
+    {
+      std::cerr << "the log marginal density is not finite" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+}
@@ -250,6 +250,7 @@ KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const ve
     }
 
   // md container
+  mdTi->compress();
   md.remove(Symmetry(ord));
   md.insert(mdTi);
   // No need to delete mdTi, it will be deleted by TensorContainer destructor
@@ -72,12 +72,22 @@ void copy_derivatives(mxArray *destin,const Symmetry &sym,const FGSContainer *de
   mxSetField(destin,0,fieldname.c_str(),tmp);
 }
 
+// The workers of the thread pool run the code of this MEX file, so they
+// are stopped before it is unloaded
+static void
+shutdown_threads()
+{
+  THREAD_GROUP::shutdown();
+}
+
 extern "C" {
 
   void
   mexFunction(int nlhs, mxArray *plhs[],
               int nrhs, const mxArray *prhs[])
   {
+    mexAtExit(shutdown_threads);
+
     if (nrhs < 3 || nlhs < 2)
       DYN_MEX_FUNC_ERR_MSG_TXT("Must have at least 3 input parameters and takes at least 2 output parameters.");
 
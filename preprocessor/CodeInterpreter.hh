@@ -36,6 +36,14 @@
 # else
 #  include "mex_interface.hh"
 # endif
+# include <map>
+# include <string>
+# include <sys/stat.h>
+# ifndef _WIN32
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+# endif
 #endif
 
 #include <stdint.h>
@@ -44,6 +52,44 @@
 
 using namespace std;
 
+//! Identifies the .cod files ("DCOD")
+const uint32_t CODE_FILE_MAGIC = 0x444F4344;
+//! Version of the layout of the .cod files, to be increased whenever the instructions change
+const uint32_t CODE_FILE_VERSION = 1;
+
+/*! Header of the .cod files. It is followed by the offsets (uint64_t) of the
+  FBEGINBLOCK instruction of each block, the code starting at header_size */
+struct code_file_header_type
+{
+  uint32_t magic, version, nb_blocks, header_size;
+};
+
+//! Writes the header of a .cod file, with offsets to be filled by write_code_file_block_offset
+inline void
+write_code_file_header(ofstream &code_file, unsigned int nb_blocks)
+{
+  code_file_header_type header;
+  header.magic = CODE_FILE_MAGIC;
+  header.version = CODE_FILE_VERSION;
+  header.nb_blocks = nb_blocks;
+  header.header_size = sizeof(header) + nb_blocks*sizeof(uint64_t);
+  code_file.write(reinterpret_cast<char *>(&header), sizeof(header));
+  uint64_t offset = 0;
+  for (unsigned int i = 0; i < nb_blocks; i++)
+    code_file.write(reinterpret_cast<char *>(&offset), sizeof(offset));
+}
+
+//! Stores the current position of the .cod file as the offset of the given block
+inline void
+write_code_file_block_offset(ofstream &code_file, unsigned int block)
+{
+  streampos pos = code_file.tellp();
+  uint64_t offset = pos;
+  code_file.seekp(sizeof(code_file_header_type) + block*sizeof(uint64_t));
+  code_file.write(reinterpret_cast<char *>(&offset), sizeof(offset));
+  code_file.seekp(pos);
+}
+
 /**
  * \enum Tags
  * \brief The differents flags of the bytecode
@@ -1647,12 +1693,178 @@ public:
 
 #ifdef BYTE_CODE
 typedef vector<pair<Tags, void * > > tags_liste_t;
+
+/*! A file generated by the preprocessor (.cod or .bin), mapped read-only in
+  memory. The files are kept for the next calls to the MEX in the process,
+  as long as they are not modified on disk (same device, inode, size, and
+  modification and status change times to the nanosecond where available). */
+class LoadedFile
+{
+public:
+  //! Content of the file, must not be modified
+  uint8_t *data;
+  size_t size;
+  //! True when the instructions of a .cod file have been decoded in tags_liste
+  bool decoded;
+  tags_liste_t tags_liste;
+  unsigned int nb_blocks;
+  vector<size_t> begin_block;
+
+  //! Returns the file, loading it if needed, or NULL if it cannot be read
+  static LoadedFile *
+  get(const string &file_name)
+  {
+    struct stat file_stat;
+    if (stat(file_name.c_str(), &file_stat))
+      return NULL;
+    map<string, LoadedFile *> &files = cache().files;
+    map<string, LoadedFile *>::iterator it = files.find(file_name);
+    if (it != files.end())
+      {
+        if (it->second->stamp == file_stamp_type(file_stat))
+          return it->second;
+        delete it->second;
+        files.erase(it);
+      }
+    LoadedFile *file = new LoadedFile;
+    if (!file->load(file_name, file_stat.st_size))
+      {
+        delete file;
+        return NULL;
+      }
+    file->stamp = file_stamp_type(file_stat);
+    files[file_name] = file;
+    return file;
+  };
+
+  //! Deletes the objects allocated while decoding the instructions
+  void
+  clear_tags()
+  {
+    for (tags_liste_t::iterator it = tags_liste.begin(); it != tags_liste.end(); it++)
+      if (it->first == FBEGINBLOCK)
+        delete static_cast<FBEGINBLOCK_ *>(it->second);
+      else if (it->first == FCALL)
+        delete static_cast<FCALL_ *>(it->second);
+    tags_liste.clear();
+    begin_block.clear();
+    nb_blocks = 0;
+    decoded = false;
+  };
+
+  ~LoadedFile()
+  {
+    clear_tags();
+    if (!size)
+      return;
+# ifndef _WIN32
+    munmap(data, size);
+# else
+    delete[] data;
+# endif
+  };
+private:
+  /*! Identity of the file on disk. The preprocessor rewrites the files in
+    place, often within the same second and with the same size when only a
+    parameter value changes, so the times are compared with their sub-second
+    part and the inode catches the files replaced by another one. */
+  struct file_stamp_type
+  {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime, ctime;
+    long mtime_nsec, ctime_nsec;
+
+    file_stamp_type() : dev(0), ino(0), size(0), mtime(0), ctime(0), mtime_nsec(0), ctime_nsec(0)
+    {
+    };
+    file_stamp_type(const struct stat &file_stat) : dev(file_stat.st_dev), ino(file_stat.st_ino), size(file_stat.st_size),
+                                                    mtime(file_stat.st_mtime), ctime(file_stat.st_ctime)
+    {
+# if defined(__APPLE__)
+      mtime_nsec = file_stat.st_mtimespec.tv_nsec;
+      ctime_nsec = file_stat.st_ctimespec.tv_nsec;
+# elif defined(_WIN32)
+      mtime_nsec = 0;
+      ctime_nsec = 0;
+# else
+      mtime_nsec = file_stat.st_mtim.tv_nsec;
+      ctime_nsec = file_stat.st_ctim.tv_nsec;
+# endif
+    };
+    bool
+    operator==(const file_stamp_type &other) const
+    {
+      return dev == other.dev && ino == other.ino && size == other.size
+        && mtime == other.mtime && mtime_nsec == other.mtime_nsec
+        && ctime == other.ctime && ctime_nsec == other.ctime_nsec;
+    };
+  };
+  file_stamp_type stamp;
+
+  LoadedFile() : data(NULL), size(0), decoded(false), nb_blocks(0)
+  {
+  };
+
+  bool
+  load(const string &file_name, size_t file_size)
+  {
+    if (!file_size)
+      return false;
+# ifndef _WIN32
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    void *p = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    data = static_cast<uint8_t *>(p);
+# else
+    ifstream file(file_name.c_str(), ios::in | ios::binary);
+    if (!file.is_open())
+      return false;
+    data = new uint8_t[file_size];
+    file.read(reinterpret_cast<char *>(data), file_size);
+    if (!file)
+      {
+        delete[] data;
+        data = NULL;
+        return false;
+      }
+# endif
+    size = file_size;
+    return true;
+  };
+
+  //! Owns the files of the process, they are released when the MEX is unloaded
+  class Cache
+  {
+  public:
+    ~Cache()
+    {
+      for (map<string, LoadedFile *>::iterator it = files.begin(); it != files.end(); it++)
+        delete it->second;
+    };
+    map<string, LoadedFile *> files;
+  };
+
+  static Cache &
+  cache()
+  {
+    static Cache files_cache;
+    return files_cache;
+  };
+};
+
 class CodeLoad
 {
 private:
   uint8_t *code;
   unsigned int nb_blocks;
   vector<size_t> begin_block;
+  string error;
 public:
 
   inline unsigned int
@@ -1671,27 +1883,61 @@ public:
   {
     return code;
   };
+  //! Reason why get_op_code returned an empty list, empty if the file cannot be opened
+  inline string
+  get_error()
+  {
+    return error;
+  };
+  /*! Returns the instructions of the .cod file. The file is decoded once and
+    shared by all the calls to the MEX in the process, the returned pointers
+    remain valid until the file changes on disk. */
   inline tags_liste_t
   get_op_code(string file_name)
   {
-    tags_liste_t tags_liste;
-    ifstream CompiledCode;
-    streamoff Code_Size;
-    CompiledCode.open((file_name + ".cod").c_str(), std::ios::in | std::ios::binary| std::ios::ate);
-    if (!CompiledCode.is_open())
+    error.clear();
+    nb_blocks = 0;
+    begin_block.clear();
+    LoadedFile *file = LoadedFile::get(file_name + ".cod");
+    if (!file)
+      return tags_liste_t();
+    if (!file->decoded && !decode(file, file_name))
+      return tags_liste_t();
+    nb_blocks = file->nb_blocks;
+    begin_block = file->begin_block;
+    code = file->data + file->size;
+    return file->tags_liste;
+  };
+private:
+  bool
+  decode(LoadedFile *file, const string &file_name)
+  {
+    code_file_header_type header;
+    if (file->size < sizeof(header))
       {
-        return tags_liste;
+        error = file_name + ".cod is not a bytecode file\n";
+        return false;
       }
-    Code_Size = CompiledCode.tellg();
-    CompiledCode.seekg(std::ios::beg);
-    code = (uint8_t *) mxMalloc(Code_Size);
-    CompiledCode.seekg(0);
-    CompiledCode.read(reinterpret_cast<char *>(code), Code_Size);
-    CompiledCode.close();
-    nb_blocks = 0;
+    memcpy(&header, file->data, sizeof(header));
+    if (header.magic != CODE_FILE_MAGIC || header.version != CODE_FILE_VERSION)
+      {
+        error = file_name + ".cod has been generated by another version of the preprocessor, run it again on the mod file\n";
+        return false;
+      }
+    if (header.header_size > file->size)
+      {
+        error = file_name + ".cod is truncated\n";
+        return false;
+      }
+    vector<uint64_t> block_offsets(header.nb_blocks);
+    if (header.nb_blocks)
+      memcpy(&block_offsets[0], file->data + sizeof(header), header.nb_blocks*sizeof(uint64_t));
+    tags_liste_t &tags_liste = file->tags_liste;
+    uint8_t *end = file->data + file->size;
+    code = file->data + header.header_size;
     bool done = false;
     int instruction = 0;
-    while (!done)
+    while (!done && code < end)
       {
         switch (*code)
           {
@@ -1918,6 +2164,12 @@ public:
             mexPrintf("FBEGINBLOCK\n");
 # endif
             {
+              if (nb_blocks >= header.nb_blocks || block_offsets[nb_blocks] != (uint64_t) (code - file->data))
+                {
+                  error = file_name + ".cod is corrupted, the blocks do not match its header\n";
+                  done = true;
+                  break;
+                }
               FBEGINBLOCK_ *fbegin_block = new FBEGINBLOCK_;
 
               code = fbegin_block->load(code);
@@ -2014,12 +2266,25 @@ public:
             code += sizeof(FSTPTEFDD_);
             break;
           default:
+            error = file_name + ".cod contains an unknown instruction\n";
             mexPrintf("Unknown Tag value=%d code=%x\n", *code, code);
             done = true;
           }
         instruction++;
       }
-    return tags_liste;
+    if (error.empty() && (!done || nb_blocks != header.nb_blocks))
+      error = file_name + ".cod is truncated\n";
+    if (!error.empty())
+      {
+        file->clear_tags();
+        nb_blocks = 0;
+        begin_block.clear();
+        return false;
+      }
+    file->nb_blocks = nb_blocks;
+    file->begin_block = begin_block;
+    file->decoded = true;
+    return true;
   };
 };
 #endif
@@ -23,13 +23,17 @@
 
 #include "DataTree.hh"
 
+const size_t DataTree::node_chunk_size;
+
 DataTree::DataTree(SymbolTable &symbol_table_arg,
                    NumericalConstants &num_constants_arg,
                    ExternalFunctionsTable &external_functions_table_arg) :
   symbol_table(symbol_table_arg),
   num_constants(num_constants_arg),
   external_functions_table(external_functions_table_arg),
-  node_counter(0)
+  node_counter(0),
+  node_chunk_next(NULL),
+  node_chunk_free(0)
 {
   Zero = AddNonNegativeConstant("0");
   One = AddNonNegativeConstant("1");
@@ -47,7 +51,27 @@ DataTree::DataTree(SymbolTable &symbol_table_arg,
 DataTree::~DataTree()
 {
   for (node_list_t::iterator it = node_list.begin(); it != node_list.end(); it++)
-    delete *it;
+    (*it)->~ExprNode();
+  for (vector<char *>::iterator it = node_chunks.begin(); it != node_chunks.end(); it++)
+    delete[] *it;
+}
+
+void *
+DataTree::allocateNode(size_t size)
+{
+  // Keep the nodes aligned on 16 bytes
+  size = (size + 15) & ~((size_t) 15);
+  if (size > node_chunk_free)
+    {
+      size_t chunk_size = size > node_chunk_size ? size : node_chunk_size;
+      node_chunks.push_back(new char[chunk_size]);
+      node_chunk_next = node_chunks.back();
+      node_chunk_free = chunk_size;
+    }
+  void *p = node_chunk_next;
+  node_chunk_next += size;
+  node_chunk_free -= size;
+  return p;
 }
 
 expr_t
@@ -59,7 +83,7 @@ DataTree::AddNonNegativeConstant(const string &value)
   if (it != num_const_node_map.end())
     return it->second;
   else
-    return new NumConstNode(*this, id);
+    return new (*this) NumConstNode(*this, id);
 }
 
 VariableNode *
@@ -69,7 +93,7 @@ DataTree::AddVariableInternal(int symb_id, int lag)
   if (it != variable_node_map.end())
     return it->second;
   else
-    return new VariableNode(*this, symb_id, lag);
+    return new (*this) VariableNode(*this, symb_id, lag);
 }
 
 bool
@@ -518,7 +542,7 @@ DataTree::AddExternalFunction(int symb_id, const vector<expr_t> &arguments)
   if (it != external_function_node_map.end())
     return it->second;
 
-  return new ExternalFunctionNode(*this, symb_id, arguments);
+  return new (*this) ExternalFunctionNode(*this, symb_id, arguments);
 }
 
 expr_t
@@ -532,7 +556,7 @@ DataTree::AddFirstDerivExternalFunction(int top_level_symb_id, const vector<expr
   if (it != first_deriv_external_function_node_map.end())
     return it->second;
 
-  return new FirstDerivExternalFunctionNode(*this, top_level_symb_id, arguments, input_index);
+  return new (*this) FirstDerivExternalFunctionNode(*this, top_level_symb_id, arguments, input_index);
 }
 
 expr_t
@@ -547,7 +571,7 @@ DataTree::AddSecondDerivExternalFunction(int top_level_symb_id, const vector<exp
   if (it != second_deriv_external_function_node_map.end())
     return it->second;
 
-  return new SecondDerivExternalFunctionNode(*this, top_level_symb_id, arguments, input_index1, input_index2);
+  return new (*this) SecondDerivExternalFunctionNode(*this, top_level_symb_id, arguments, input_index1, input_index2);
 }
 
 bool
@@ -676,6 +700,247 @@ DataTree::minLagForSymbol(int symb_id) const
   return r;
 }
 
+void
+DataTree::mergeNodes(const DataTree &other, vector<expr_t> &images, int end)
+{
+  for (int i = images.size(); i < end; i++)
+    images.push_back(other.node_list[i]->mergeInto(*this, images));
+}
+
+void
+DataTree::mergeDerivatives(const DataTree &other, const vector<expr_t> &images) const
+{
+  for (int i = 0; i < (int) images.size(); i++)
+    other.node_list[i]->mergeDerivatives(images);
+}
+
+string
+DataTree::getExternalFunctionCacheOptions(int symb_id) const
+{
+  ostringstream options;
+  int first_deriv_symb_id = external_functions_table.getFirstDerivSymbID(symb_id);
+  int second_deriv_symb_id = external_functions_table.getSecondDerivSymbID(symb_id);
+  if (first_deriv_symb_id >= 0)
+    options << symbol_table.getName(first_deriv_symb_id);
+  else
+    options << first_deriv_symb_id;
+  options << " ";
+  if (second_deriv_symb_id >= 0)
+    options << symbol_table.getName(second_deriv_symb_id);
+  else
+    options << second_deriv_symb_id;
+  return options.str();
+}
+
+//! Reads the fields of a line of the derivatives cache (see DataTree::parseCacheNode())
+class CacheRecordParser
+{
+private:
+  const char *p;
+public:
+  CacheRecordParser(const string &record) : p(record.c_str())
+  {
+  }
+  bool
+  readInt(int &value)
+  {
+    char *end;
+    long l = strtol(p, &end, 10);
+    if (end == p)
+      return false;
+    value = (int) l;
+    p = end;
+    return true;
+  }
+  bool
+  readWord(string &word)
+  {
+    while (*p == ' ')
+      p++;
+    const char *begin = p;
+    while (*p != '\0' && *p != ' ')
+      p++;
+    word.assign(begin, p);
+    return p != begin;
+  }
+  //! Reads the ID of a symbol of the given type, designated by its name
+  bool
+  readSymbol(const SymbolTable &symbol_table, SymbolType type, int &symb_id)
+  {
+    string name;
+    if (!readWord(name) || !symbol_table.exists(name)
+        || symbol_table.getType(name) != type)
+      return false;
+    symb_id = symbol_table.getID(name);
+    return true;
+  }
+  //! Reads the number of one of the nnodes nodes already read
+  bool
+  readArgument(int nnodes, vector<int> &args)
+  {
+    int n;
+    if (!readInt(n) || n < 0 || n >= nnodes)
+      return false;
+    args.push_back(n);
+    return true;
+  }
+  //! Reads the arguments of an external function, preceded by their number
+  bool
+  readArguments(int nnodes, vector<int> &args)
+  {
+    int nargs;
+    if (!readInt(nargs) || nargs < 0)
+      return false;
+    for (int i = 0; i < nargs; i++)
+      if (!readArgument(nnodes, args))
+        return false;
+    return true;
+  }
+  //! Whether the whole line has been read
+  bool
+  atEnd()
+  {
+    while (*p == ' ')
+      p++;
+    return *p == '\0';
+  }
+};
+
+bool
+DataTree::parseCacheNode(const string &record, int nnodes, cache_node_t &node) const
+{
+  CacheRecordParser input(record);
+  string kind, options;
+  node.args.clear();
+  node.param1_symb_id = node.param2_symb_id = 0;
+  if (!input.readWord(kind) || kind.size() != 1)
+    return false;
+  node.kind = kind[0];
+  switch (node.kind)
+    {
+    case 'N':
+      {
+        if (!input.readWord(node.value))
+          return false;
+        // The constant must be a number, possibly NaN or Inf, which is not negative
+        char *end;
+        double val = strtod(node.value.c_str(), &end);
+        if (*end != '\0' || val < 0)
+          return false;
+      }
+      break;
+    case 'V':
+      if (!input.readWord(node.value) || !input.readInt(node.lag) || !input.readInt(node.type)
+          || !symbol_table.exists(node.value) || symbol_table.getType(node.value) != (SymbolType) node.type)
+        return false;
+      node.symb_id = symbol_table.getID(node.value);
+      break;
+    case 'U':
+      if (!input.readInt(node.op) || node.op < oUminus || node.op > oErf
+          || !input.readArgument(nnodes, node.args) || !input.readInt(node.info_set))
+        return false;
+      if ((node.op == oSteadyStateParamDeriv || node.op == oSteadyStateParam2ndDeriv)
+          && !input.readSymbol(symbol_table, eParameter, node.param1_symb_id))
+        return false;
+      if (node.op == oSteadyStateParam2ndDeriv
+          && !input.readSymbol(symbol_table, eParameter, node.param2_symb_id))
+        return false;
+      break;
+    case 'B':
+      if (!input.readInt(node.op) || node.op < oPlus || node.op > oDifferent
+          || !input.readArgument(nnodes, node.args) || !input.readArgument(nnodes, node.args)
+          || !input.readInt(node.n1) || node.n1 < 0)
+        return false;
+      break;
+    case 'T':
+      if (!input.readInt(node.op) || node.op < oNormcdf || node.op > oNormpdf
+          || !input.readArgument(nnodes, node.args) || !input.readArgument(nnodes, node.args)
+          || !input.readArgument(nnodes, node.args))
+        return false;
+      break;
+    case 'E':
+      if (!input.readSymbol(symbol_table, eExternalFunction, node.symb_id)
+          || !external_functions_table.exists(node.symb_id)
+          || !input.readWord(node.value) || !input.readWord(options)
+          || node.value + " " + options != getExternalFunctionCacheOptions(node.symb_id)
+          || !input.readArguments(nnodes, node.args))
+        return false;
+      break;
+    case 'F':
+      if (!input.readSymbol(symbol_table, eExternalFunction, node.symb_id)
+          || !input.readInt(node.n1) || !input.readArguments(nnodes, node.args)
+          || node.n1 < 1 || node.n1 > (int) node.args.size())
+        return false;
+      break;
+    case 'G':
+      if (!input.readSymbol(symbol_table, eExternalFunction, node.symb_id)
+          || !input.readInt(node.n1) || !input.readInt(node.n2) || !input.readArguments(nnodes, node.args)
+          || node.n1 < 1 || node.n1 > (int) node.args.size()
+          || node.n2 < 1 || node.n2 > (int) node.args.size())
+        return false;
+      break;
+    default:
+      return false;
+    }
+  return input.atEnd();
+}
+
+expr_t
+DataTree::addCacheNode(const cache_node_t &node, const vector<expr_t> &nodes)
+{
+  /* The nodes are not reduced to constants as in AddUnaryOp(),
+     AddBinaryOp() and AddTrinaryOp(), since they were not when they were
+     created, and the attempt costs an exception for every node */
+  vector<expr_t> args;
+  for (vector<int>::const_iterator it = node.args.begin(); it != node.args.end(); it++)
+    args.push_back(nodes[*it]);
+  switch (node.kind)
+    {
+    case 'N':
+      return AddNonNegativeConstant(node.value);
+    case 'V':
+      return AddVariable(node.symb_id, node.lag);
+    case 'U':
+      {
+        unary_op_node_map_t::iterator it
+          = unary_op_node_map.find(make_pair(make_pair(args[0], (UnaryOpcode) node.op),
+                                             make_pair(node.info_set, make_pair(node.param1_symb_id, node.param2_symb_id))));
+        if (it != unary_op_node_map.end())
+          return it->second;
+      }
+      return new (*this) UnaryOpNode(*this, (UnaryOpcode) node.op, args[0], node.info_set,
+                                     node.param1_symb_id, node.param2_symb_id);
+    case 'B':
+      // Same order of the arguments of commutative operators as in AddPlus() and AddTimes()
+      if ((node.op == oPlus || node.op == oTimes) && args[0]->idx > args[1]->idx)
+        swap(args[0], args[1]);
+      {
+        binary_op_node_map_t::iterator it
+          = binary_op_node_map.find(make_pair(make_pair(make_pair(args[0], args[1]), node.n1), (BinaryOpcode) node.op));
+        if (it != binary_op_node_map.end())
+          return it->second;
+      }
+      return new (*this) BinaryOpNode(*this, args[0], (BinaryOpcode) node.op, args[1], node.n1);
+    case 'T':
+      {
+        trinary_op_node_map_t::iterator it
+          = trinary_op_node_map.find(make_pair(make_pair(make_pair(args[0], args[1]), args[2]), (TrinaryOpcode) node.op));
+        if (it != trinary_op_node_map.end())
+          return it->second;
+      }
+      return new (*this) TrinaryOpNode(*this, args[0], (TrinaryOpcode) node.op, args[1], args[2]);
+    case 'E':
+      return AddExternalFunction(node.symb_id, args);
+    case 'F':
+      return AddFirstDerivExternalFunction(node.symb_id, args, node.n1);
+    case 'G':
+      return AddSecondDerivExternalFunction(node.symb_id, args, node.n1, node.n2);
+    default:
+      assert(false);
+      return NULL;
+    }
+}
+
 void
 DataTree::writePowerDerivCHeader(ostream &output) const
 {
@@ -33,6 +33,7 @@ using namespace std;
 #include "NumericalConstants.hh"
 #include "ExternalFunctionsTable.hh"
 #include "ExprNode.hh"
+#include "NodeHashMap.hh"
 
 #define CONSTANTS_PRECISION 16
 
@@ -62,12 +63,12 @@ protected:
   typedef map<pair<int, int>, VariableNode *> variable_node_map_t;
   variable_node_map_t variable_node_map;
   //! Pair( Pair(arg1, UnaryOpCode), Pair( Expectation Info Set, Pair(param1_symb_id, param2_symb_id)) ))
-  typedef map<pair<pair<expr_t, UnaryOpcode>, pair<int, pair<int, int> > >, UnaryOpNode *> unary_op_node_map_t;
+  typedef NodeHashMap<pair<pair<expr_t, UnaryOpcode>, pair<int, pair<int, int> > >, UnaryOpNode *> unary_op_node_map_t;
   unary_op_node_map_t unary_op_node_map;
   //! Pair( Pair( Pair(arg1, arg2), order of Power Derivative), opCode)
-  typedef map<pair<pair<pair<expr_t, expr_t>, int>, BinaryOpcode>, BinaryOpNode *> binary_op_node_map_t;
+  typedef NodeHashMap<pair<pair<pair<expr_t, expr_t>, int>, BinaryOpcode>, BinaryOpNode *> binary_op_node_map_t;
   binary_op_node_map_t binary_op_node_map;
-  typedef map<pair<pair<pair<expr_t, expr_t>, expr_t>, TrinaryOpcode>, TrinaryOpNode *> trinary_op_node_map_t;
+  typedef NodeHashMap<pair<pair<pair<expr_t, expr_t>, expr_t>, TrinaryOpcode>, TrinaryOpNode *> trinary_op_node_map_t;
   trinary_op_node_map_t trinary_op_node_map;
 
   // (arguments, symb_id) -> ExternalFunctionNode
@@ -91,11 +92,20 @@ protected:
   //! Internal implementation of ParamUsedWithLeadLag()
   bool ParamUsedWithLeadLagInternal() const;
 private:
-  typedef list<expr_t> node_list_t;
+  typedef vector<expr_t> node_list_t;
   //! The list of nodes
   node_list_t node_list;
   //! A counter for filling ExprNode's idx field
   int node_counter;
+  //! Size of the memory chunks in which the nodes are allocated
+  static const size_t node_chunk_size = 1 << 16;
+  //! Memory holding the nodes, released with the DataTree
+  vector<char *> node_chunks;
+  //! Free space at the end of the last chunk
+  char *node_chunk_next;
+  size_t node_chunk_free;
+  //! Allocates memory for a node (see ExprNode::operator new)
+  void *allocateNode(size_t size);
 
   inline expr_t AddPossiblyNegativeConstant(double val);
   inline expr_t AddUnaryOp(UnaryOpcode op_code, expr_t arg, int arg_exp_info_set = 0, int param1_symb_id = 0, int param2_symb_id = 0);
@@ -235,6 +245,38 @@ public:
   //! Returns the minimum lag (as a negative number) of the given symbol in the whole data tree (and not only in the equations !!)
   /*! Returns 0 if the symbol is not used */
   int minLagForSymbol(int symb_id) const;
+  //! Returns the number of nodes in the data tree
+  int
+  getNodeNumber() const
+  {
+    return node_counter;
+  };
+  //! Adds to the data tree the images of the nodes of another data tree
+  /*! The nodes are processed in the order of their creation, from the one of
+    idx images.size() up to the one of idx end (excluded). Their images are
+    appended to images */
+  void mergeNodes(const DataTree &other, vector<expr_t> &images, int end);
+  //! Copies the derivatives cached in the nodes of another data tree to their images (see mergeNodes())
+  void mergeDerivatives(const DataTree &other, const vector<expr_t> &images) const;
+  //! Returns the options of an external function, as written in the derivatives cache (see ExprNode::writeCache())
+  string getExternalFunctionCacheOptions(int symb_id) const;
+  //! Fields of a line of a derivatives cache file (see ExprNode::writeCache())
+  struct cache_node_t
+  {
+    char kind;
+    string value;
+    int op, symb_id, lag, type, n1, n2, info_set, param1_symb_id, param2_symb_id;
+    //! Numbers of the nodes used as arguments
+    vector<int> args;
+  };
+  //! Reads a line of a derivatives cache file, without adding anything to the data tree
+  /*! The line may only use the nnodes nodes already read, designated by their
+    number. Returns false if the line is invalid, or refers to symbols which no
+    longer exist or have changed */
+  bool parseCacheNode(const string &record, int nnodes, cache_node_t &node) const;
+  //! Adds to the data tree a node accepted by parseCacheNode()
+  /*! nodes contains the nodes already added, designated by their number */
+  expr_t addCacheNode(const cache_node_t &node, const vector<expr_t> &nodes);
   //! Write the C Header for getPowerDeriv when use_dll is used
   void writePowerDerivCHeader(ostream &output) const;
   //! Write getPowerDeriv in C
@@ -326,7 +368,7 @@ DataTree::AddUnaryOp(UnaryOpcode op_code, expr_t arg, int arg_exp_info_set, int
         {
         }
     }
-  return new UnaryOpNode(*this, op_code, arg, arg_exp_info_set, param1_symb_id, param2_symb_id);
+  return new (*this) UnaryOpNode(*this, op_code, arg, arg_exp_info_set, param1_symb_id, param2_symb_id);
 }
 
 inline expr_t
@@ -347,7 +389,7 @@ DataTree::AddBinaryOp(expr_t arg1, BinaryOpcode op_code, expr_t arg2, int powerD
   catch (ExprNode::EvalException &e)
     {
     }
-  return new BinaryOpNode(*this, arg1, op_code, arg2, powerDerivOrder);
+  return new (*this) BinaryOpNode(*this, arg1, op_code, arg2, powerDerivOrder);
 }
 
 inline expr_t
@@ -369,7 +411,7 @@ DataTree::AddTrinaryOp(expr_t arg1, TrinaryOpcode op_code, expr_t arg2, expr_t a
   catch (ExprNode::EvalException &e)
     {
     }
-  return new TrinaryOpNode(*this, arg1, op_code, arg2, arg3);
+  return new (*this) TrinaryOpNode(*this, arg1, op_code, arg2, arg3);
 }
 
 #endif
@@ -803,6 +803,7 @@ DynamicModel::writeModelEquationsCode(string &file_name, const string &bin_basen
       cout << "Error : Can't open file \"" << main_name << "\" for writing\n";
       exit(EXIT_FAILURE);
     }
+  write_code_file_header(code_file, 1);
 
   int count_u;
   int u_count_int = 0;
@@ -904,6 +905,7 @@ DynamicModel::writeModelEquationsCode(string &file_name, const string &bin_basen
                            exo,
                            other_endo
                            );
+  write_code_file_block_offset(code_file, 0);
   fbeginblock.write(code_file, instruction_number);
 
   compileTemporaryTerms(code_file, instruction_number, temporary_terms, map_idx, true, false);
@@ -1079,6 +1081,7 @@ DynamicModel::writeModelEquationsCode_Block(string &file_name, const string &bin
       cout << "Error : Can't open file \"" << main_name << "\" for writing\n";
       exit(EXIT_FAILURE);
     }
+  write_code_file_header(code_file, getNbBlocks());
   //Temporary variables declaration
 
   FDIMT_ fdimt(temporary_terms.size());
@@ -1186,6 +1189,7 @@ DynamicModel::writeModelEquationsCode_Block(string &file_name, const string &bin
                                exo,
                                other_endo
                                );
+      write_code_file_block_offset(code_file, block);
       fbeginblock.write(code_file, instruction_number);
       
       // The equations
@@ -41,7 +41,7 @@ void main2(stringstream &in, string &basename, bool debug, bool clear_all, bool
            bool nograph, bool nointeractive, bool parallel, ConfigFile &config_file,
            WarningConsolidation &warnings_arg, bool nostrict, bool check_model_changes,
            bool minimal_workspace, bool compute_xrefs, FileOutputType output_mode,
-           LanguageOutputType lang, int params_derivs_order
+           LanguageOutputType lang, int params_derivs_order, int nthreads
 #if defined(_WIN32) || defined(__CYGWIN32__) || defined(__MINGW32__)
            , bool cygwin, bool msvc, bool mingw
 #endif
@@ -57,7 +57,7 @@ usage()
   cerr << "Dynare usage: dynare mod_file [debug] [noclearall] [onlyclearglobals] [savemacro[=macro_file]] [onlymacro] [nolinemacro] [notmpterms] [nolog] [warn_uninit]"
        << " [console] [nograph] [nointeractive] [parallel[=cluster_name]] [conffile=parallel_config_path_and_filename] [parallel_slave_open_mode] [parallel_test]"
        << " [-D<variable>[=<value>]] [-I/path] [nostrict] [fast] [minimal_workspace] [compute_xrefs] [output=dynamic|first|second|third] [language=C|C++|julia]"
-       << " [params_derivs_order=0|1|2]"
+       << " [params_derivs_order=0|1|2] [nthreads=N]"
 #if defined(_WIN32) || defined(__CYGWIN32__) || defined(__MINGW32__)
        << " [cygwin] [msvc] [mingw]"
 #endif
@@ -92,6 +92,7 @@ main(int argc, char **argv)
   bool no_log = false;
   bool no_warn = false;
   int params_derivs_order = 2;
+  int nthreads = 1;
   bool warn_uninit = false;
   bool console = false;
   bool nograph = false;
@@ -132,6 +133,22 @@ main(int argc, char **argv)
             }
           params_derivs_order = atoi(argv[arg] + 20);
         }
+      else if (strlen(argv[arg]) >= 8 && !strncmp(argv[arg], "nthreads", 8))
+        {
+          if (strlen(argv[arg]) <= 9 || argv[arg][8] != '=' || atoi(argv[arg] + 9) < 1)
+            {
+              cerr << "Incorrect syntax for nthreads option" << endl;
+              usage();
+            }
+          nthreads = atoi(argv[arg] + 9);
+#ifndef HAVE_PTHREAD
+          if (nthreads > 1)
+            {
+              cerr << "WARNING: the preprocessor was compiled without thread support, ignoring the nthreads option" << endl;
+              nthreads = 1;
+            }
+#endif
+        }
       else if (!strcmp(argv[arg], "onlyclearglobals"))
         {
           clear_all = false;
@@ -333,7 +350,7 @@ main(int argc, char **argv)
   main2(macro_output, basename, debug, clear_all, clear_global,
         no_tmp_terms, no_log, no_warn, warn_uninit, console, nograph, nointeractive,
         parallel, config_file, warnings, nostrict, check_model_changes, minimal_workspace,
-        compute_xrefs, output_mode, language, params_derivs_order
+        compute_xrefs, output_mode, language, params_derivs_order, nthreads
 #if defined(_WIN32) || defined(__CYGWIN32__) || defined(__MINGW32__)
         , cygwin, msvc, mingw
 #endif
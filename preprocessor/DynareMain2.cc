@@ -30,7 +30,7 @@ main2(stringstream &in, string &basename, bool debug, bool clear_all, bool clear
       bool nograph, bool nointeractive, bool parallel, ConfigFile &config_file,
       WarningConsolidation &warnings, bool nostrict, bool check_model_changes,
       bool minimal_workspace, bool compute_xrefs, FileOutputType output_mode,
-      LanguageOutputType language, int params_derivs_order
+      LanguageOutputType language, int params_derivs_order, int nthreads
 #if defined(_WIN32) || defined(__CYGWIN32__) || defined(__MINGW32__)
       , bool cygwin, bool msvc, bool mingw
 #endif
@@ -50,8 +50,10 @@ main2(stringstream &in, string &basename, bool debug, bool clear_all, bool clear
   // Evaluate parameters initialization, initval, endval and pounds
   mod_file->evalAllExpressions(warn_uninit);
 
-  // Do computations
-  mod_file->computingPass(no_tmp_terms, output_mode, compute_xrefs, params_derivs_order);
+  /* Do computations, reusing the derivatives of the equations which did not
+     change since the previous run if the model changes are checked */
+  mod_file->computingPass(no_tmp_terms, output_mode, compute_xrefs, params_derivs_order, nthreads,
+                          check_model_changes ? basename : "");
 
   // Write outputs
   if (output_mode != none)
@@ -43,6 +43,22 @@ ExprNode::~ExprNode()
 {
 }
 
+void *
+ExprNode::operator new(size_t size, DataTree &datatree)
+{
+  return datatree.allocateNode(size);
+}
+
+void
+ExprNode::operator delete(void *p, DataTree &datatree)
+{
+}
+
+void
+ExprNode::operator delete(void *p)
+{
+}
+
 expr_t
 ExprNode::getDerivative(int deriv_id)
 {
@@ -55,7 +71,7 @@ ExprNode::getDerivative(int deriv_id)
     return datatree.Zero;
 
   // If derivative is stored in cache, use the cached value, otherwise compute it (and cache it)
-  map<int, expr_t>::const_iterator it2 = derivatives.find(deriv_id);
+  derivatives_t::const_iterator it2 = derivatives.find(deriv_id);
   if (it2 != derivatives.end())
     return it2->second;
   else
@@ -66,6 +82,29 @@ ExprNode::getDerivative(int deriv_id)
     }
 }
 
+void
+ExprNode::mergeDerivatives(const vector<expr_t> &images) const
+{
+  expr_t image = images[idx];
+  for (derivatives_t::const_iterator it = derivatives.begin();
+       it != derivatives.end(); it++)
+    if (image->derivatives.find(it->first) == image->derivatives.end())
+      image->derivatives[it->first] = images[it->second->idx];
+}
+
+int
+ExprNode::writeCache(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  map<const ExprNode *, int>::const_iterator it = node_ids.find(this);
+  if (it != node_ids.end())
+    return it->second;
+
+  writeCacheRecord(output, node_ids);
+  int n = node_ids.size();
+  node_ids[this] = n;
+  return n;
+}
+
 int
 ExprNode::precedence(ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms) const
 {
@@ -379,6 +418,18 @@ NumConstNode::cloneDynamic(DataTree &dynamic_datatree) const
   return dynamic_datatree.AddNonNegativeConstant(datatree.num_constants.get(id));
 }
 
+expr_t
+NumConstNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  return cloneDynamic(alt_datatree);
+}
+
+void
+NumConstNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  output << "N " << datatree.num_constants.get(id) << endl;
+}
+
 int
 NumConstNode::maxEndoLead() const
 {
@@ -1021,7 +1072,7 @@ VariableNode::getChainRuleDerivative(int deriv_id, const map<int, expr_t> &recur
           map<int, expr_t>::const_iterator it = recursive_variables.find(datatree.getDerivID(symb_id, lag));
           if (it != recursive_variables.end())
             {
-              map<int, expr_t>::const_iterator it2 = derivatives.find(deriv_id);
+              derivatives_t::const_iterator it2 = derivatives.find(deriv_id);
               if (it2 != derivatives.end())
                 return it2->second;
               else
@@ -1097,6 +1148,18 @@ VariableNode::cloneDynamic(DataTree &dynamic_datatree) const
   return dynamic_datatree.AddVariable(symb_id, lag);
 }
 
+expr_t
+VariableNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  return cloneDynamic(alt_datatree);
+}
+
+void
+VariableNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  output << "V " << datatree.symbol_table.getName(symb_id) << " " << lag << " " << type << endl;
+}
+
 int
 VariableNode::maxEndoLead() const
 {
@@ -1458,7 +1521,7 @@ VariableNode::removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const
     return const_cast<VariableNode *>(this);
 
   map<int, expr_t>::const_iterator it = trend_symbols_map.find(symb_id);
-  expr_t noTrendLeadLagNode = new VariableNode(datatree, it->first, 0);
+  expr_t noTrendLeadLagNode = new (datatree) VariableNode(datatree, it->first, 0);
   bool log_trend = get_type() == eLogTrend;
   expr_t trend = it->second;
   
@@ -2379,6 +2442,24 @@ UnaryOpNode::cloneDynamic(DataTree &dynamic_datatree) const
   return buildSimilarUnaryOpNode(substarg, dynamic_datatree);
 }
 
+expr_t
+UnaryOpNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  return alt_datatree.AddUnaryOp(op_code, images[arg->idx], expectation_information_set, param1_symb_id, param2_symb_id);
+}
+
+void
+UnaryOpNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  int n = arg->writeCache(output, node_ids);
+  output << "U " << op_code << " " << n << " " << expectation_information_set;
+  if (op_code == oSteadyStateParamDeriv || op_code == oSteadyStateParam2ndDeriv)
+    output << " " << datatree.symbol_table.getName(param1_symb_id);
+  if (op_code == oSteadyStateParam2ndDeriv)
+    output << " " << datatree.symbol_table.getName(param2_symb_id);
+  output << endl;
+}
+
 int
 UnaryOpNode::maxEndoLead() const
 {
@@ -3649,6 +3730,20 @@ BinaryOpNode::cloneDynamic(DataTree &dynamic_datatree) const
   return buildSimilarBinaryOpNode(substarg1, substarg2, dynamic_datatree);
 }
 
+expr_t
+BinaryOpNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  return buildSimilarBinaryOpNode(images[arg1->idx], images[arg2->idx], alt_datatree);
+}
+
+void
+BinaryOpNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  int n1 = arg1->writeCache(output, node_ids);
+  int n2 = arg2->writeCache(output, node_ids);
+  output << "B " << op_code << " " << n1 << " " << n2 << " " << powerDerivOrder << endl;
+}
+
 int
 BinaryOpNode::maxEndoLead() const
 {
@@ -4376,6 +4471,21 @@ TrinaryOpNode::cloneDynamic(DataTree &dynamic_datatree) const
   return buildSimilarTrinaryOpNode(substarg1, substarg2, substarg3, dynamic_datatree);
 }
 
+expr_t
+TrinaryOpNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  return alt_datatree.AddTrinaryOp(images[arg1->idx], op_code, images[arg2->idx], images[arg3->idx]);
+}
+
+void
+TrinaryOpNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  int n1 = arg1->writeCache(output, node_ids);
+  int n2 = arg2->writeCache(output, node_ids);
+  int n3 = arg3->writeCache(output, node_ids);
+  output << "T " << op_code << " " << n1 << " " << n2 << " " << n3 << endl;
+}
+
 int
 TrinaryOpNode::maxEndoLead() const
 {
@@ -4839,6 +4949,25 @@ AbstractExternalFunctionNode::detrend(int symb_id, bool log_trend, expr_t trend)
   return buildSimilarExternalFunctionNode(arguments_subst, datatree);
 }
 
+expr_t
+AbstractExternalFunctionNode::mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const
+{
+  vector<expr_t> alt_args;
+  for (vector<expr_t>::const_iterator it = arguments.begin(); it != arguments.end(); it++)
+    alt_args.push_back(images[(*it)->idx]);
+  return buildSimilarExternalFunctionNode(alt_args, alt_datatree);
+}
+
+string
+AbstractExternalFunctionNode::writeCacheArguments(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  ostringstream ids;
+  ids << arguments.size();
+  for (vector<expr_t>::const_iterator it = arguments.begin(); it != arguments.end(); it++)
+    ids << " " << (*it)->writeCache(output, node_ids);
+  return ids.str();
+}
+
 expr_t
 AbstractExternalFunctionNode::removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const
 {
@@ -5192,6 +5321,14 @@ ExternalFunctionNode::cloneDynamic(DataTree &dynamic_datatree) const
   return dynamic_datatree.AddExternalFunction(symb_id, dynamic_arguments);
 }
 
+void
+ExternalFunctionNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  string args = writeCacheArguments(output, node_ids);
+  output << "E " << datatree.symbol_table.getName(symb_id) << " "
+         << datatree.getExternalFunctionCacheOptions(symb_id) << " " << args << endl;
+}
+
 expr_t
 ExternalFunctionNode::buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const
 {
@@ -5487,6 +5624,13 @@ FirstDerivExternalFunctionNode::cloneDynamic(DataTree &dynamic_datatree) const
                                                         inputIndex);
 }
 
+void
+FirstDerivExternalFunctionNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  string args = writeCacheArguments(output, node_ids);
+  output << "F " << datatree.symbol_table.getName(symb_id) << " " << inputIndex << " " << args << endl;
+}
+
 expr_t
 FirstDerivExternalFunctionNode::buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const
 {
@@ -5731,6 +5875,13 @@ SecondDerivExternalFunctionNode::cloneDynamic(DataTree &dynamic_datatree) const
                                                          inputIndex1, inputIndex2);
 }
 
+void
+SecondDerivExternalFunctionNode::writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const
+{
+  string args = writeCacheArguments(output, node_ids);
+  output << "G " << datatree.symbol_table.getName(symb_id) << " " << inputIndex1 << " " << inputIndex2 << " " << args << endl;
+}
+
 expr_t
 SecondDerivExternalFunctionNode::buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const
 {
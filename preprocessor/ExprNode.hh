@@ -30,6 +30,7 @@ using namespace std;
 #include "SymbolTable.hh"
 #include "CodeInterpreter.hh"
 #include "ExternalFunctionsTable.hh"
+#include "NodeHashMap.hh"
 
 class DataTree;
 class VariableNode;
@@ -153,8 +154,9 @@ protected:
   //! Set of derivation IDs with respect to which the derivative is potentially non-null
   set<int> non_null_derivatives;
 
+  typedef NodeHashMap<int, expr_t> derivatives_t;
   //! Used for caching of first order derivatives (when non-null)
-  map<int, expr_t> derivatives;
+  derivatives_t derivatives;
 
   //! Cost of computing current node
   /*! Nodes included in temporary_terms are considered having a null cost */
@@ -175,6 +177,13 @@ public:
   ExprNode(DataTree &datatree_arg);
   virtual ~ExprNode();
 
+  //! Nodes are allocated in memory owned by their DataTree
+  static void *operator new(size_t size, DataTree &datatree);
+  //! Only called if a constructor throws, the memory is released with the DataTree
+  static void operator delete(void *p, DataTree &datatree);
+  //! Nodes are destroyed by their DataTree, never deleted individually
+  static void operator delete(void *p);
+
   //! Initializes data member non_null_derivatives
   virtual void prepareForDerivation() = 0;
 
@@ -441,6 +450,28 @@ public:
   //! Add ExprNodes to the provided datatree
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const = 0;
 
+  //! Adds to the provided datatree a node similar to this one, whose arguments are the images of the arguments of this node
+  /*! images maps the idx of the nodes of the DataTree of this node to their
+    image in alt_datatree (see DataTree::mergeNodes()). Contrary to
+    cloneDynamic(), the arguments are not traversed again. The arguments of
+    commutative operators are sorted again, since the order of the nodes may
+    differ between the two datatrees */
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const = 0;
+
+  //! Copies the cached derivatives of this node to its image (see mergeInto())
+  void mergeDerivatives(const vector<expr_t> &images) const;
+
+  //! Writes this node to a derivatives cache file (see ModelTree::saveDerivativesCache()), after its arguments
+  /*! Each node is written on its own line, and is designated by the number
+    of nodes written before it. Symbols are designated by their name, so that
+    the cache does not depend on the symbol IDs. node_ids contains the
+    numbers of the nodes already written, which are not written again.
+    Returns the number of this node */
+  int writeCache(ostream &output, map<const ExprNode *, int> &node_ids) const;
+
+  //! Writes the arguments of this node to a derivatives cache file, then the line describing the node itself (see writeCache())
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const = 0;
+
   //! Move a trend variable with lag/lead to time t by dividing/multiplying by its growth factor
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const = 0;
 
@@ -507,6 +538,8 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   virtual bool isInStaticForm() const;
   virtual expr_t substituteStaticAuxiliaryVariable() const;
@@ -573,6 +606,8 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   virtual bool isInStaticForm() const;
   //! Substitute auxiliary variables by their expression in static model
@@ -659,6 +694,8 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   virtual bool isInStaticForm() const;
   //! Substitute auxiliary variables by their expression in static model
@@ -758,6 +795,8 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   //! Function to write out the oPowerNode in expr_t terms as opposed to writing out the function itself
   expr_t unpackPowerDeriv() const;
@@ -839,6 +878,8 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   virtual bool isInStaticForm() const;
   //! Substitute auxiliary variables by their expression in static model
@@ -921,6 +962,9 @@ public:
   virtual expr_t replaceTrendVar() const;
   virtual expr_t detrend(int symb_id, bool log_trend, expr_t trend) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const = 0;
+  virtual expr_t mergeInto(DataTree &alt_datatree, const vector<expr_t> &images) const;
+  //! Writes the arguments of this node to a derivatives cache file, and returns their number followed by their node numbers
+  string writeCacheArguments(ostream &output, map<const ExprNode *, int> &node_ids) const;
   virtual expr_t removeTrendLeadLag(map<int, expr_t> trend_symbols_map) const;
   virtual bool isInStaticForm() const;
   //! Substitute auxiliary variables by their expression in static model
@@ -956,6 +1000,7 @@ public:
   virtual void computeXrefs(EquationInfo &ei) const;
   virtual expr_t buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
 };
 
 class FirstDerivExternalFunctionNode : public AbstractExternalFunctionNode
@@ -993,6 +1038,7 @@ public:
   virtual void computeXrefs(EquationInfo &ei) const;
   virtual expr_t buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
 };
 
 class SecondDerivExternalFunctionNode : public AbstractExternalFunctionNode
@@ -1032,6 +1078,7 @@ public:
   virtual void computeXrefs(EquationInfo &ei) const;
   virtual expr_t buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const;
   virtual expr_t cloneDynamic(DataTree &dynamic_datatree) const;
+  virtual void writeCacheRecord(ostream &output, map<const ExprNode *, int> &node_ids) const;
 };
 
 #endif
@@ -22,8 +22,16 @@
 #include <fstream>
 #include <typeinfo>
 #include <cassert>
-#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+
+// For mkdir()
+#ifdef _WIN32
+# include <direct.h>
+#else
 # include <unistd.h>
+# include <sys/stat.h>
+# include <sys/types.h>
 #endif
 
 #include "ModFile.hh"
@@ -480,8 +488,19 @@ ModFile::transformPass(bool nostrict)
 }
 
 void
-ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order)
+ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order, int nthreads,
+                       const string &derivatives_cache_dir)
 {
+  static_model.set_nb_threads(nthreads);
+  dynamic_model.set_nb_threads(nthreads);
+  orig_ramsey_dynamic_model.set_nb_threads(nthreads);
+
+  if (!derivatives_cache_dir.empty())
+    {
+      static_model.loadDerivativesCache(derivatives_cache_dir + "/static_derivatives");
+      dynamic_model.loadDerivativesCache(derivatives_cache_dir + "/dynamic_derivatives");
+    }
+
   // Mod file may have no equation (for example in a standalone BVAR estimation)
   if (dynamic_model.equation_number() > 0)
     {
@@ -567,6 +586,22 @@ ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xr
             }
           exit(EXIT_FAILURE);
         }
+
+      if (!derivatives_cache_dir.empty())
+        {
+#ifdef _WIN32
+          int r = mkdir(derivatives_cache_dir.c_str());
+#else
+          int r = mkdir(derivatives_cache_dir.c_str(), 0777);
+#endif
+          if (r < 0 && errno != EEXIST)
+            {
+              perror("ERROR");
+              exit(EXIT_FAILURE);
+            }
+          static_model.saveDerivativesCache(derivatives_cache_dir + "/static_derivatives");
+          dynamic_model.saveDerivativesCache(derivatives_cache_dir + "/dynamic_derivatives");
+        }
     }
 
   for (vector<Statement *>::iterator it = statements.begin();
@@ -135,7 +135,10 @@ public:
   /*! \param no_tmp_terms if true, no temporary terms will be computed in the static and dynamic files */
   /*! \param compute_xrefs if true, equation cross references will be computed */
   /*! \param params_derivs_order compute this order of derivs wrt parameters */
-  void computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order);
+  /*! \param nthreads number of threads used for computing the derivatives of the models */
+  /*! \param derivatives_cache_dir directory where the derivatives are cached between runs, or empty string for not using the cache */
+  void computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order, int nthreads,
+                     const string &derivatives_cache_dir);
   //! Writes Matlab/Octave output files
   /*!
     \param basename The base name used for writing output files. Should be the name of the mod file without its extension
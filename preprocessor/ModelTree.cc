@@ -22,6 +22,12 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include "ModelTree.hh"
 #include "MinimumFeedbackSet.hh"
@@ -429,19 +435,19 @@ ModelTree::computePrologueAndEpilogue(const jacob_map_t &static_jacobian_arg, ve
       eq2endo[*it] = i;
       equation_reordered[i] = i;
       variable_reordered[*it] = i;
-    }
-  if (cutoff == 0)
-    {
+    }
+  if (cutoff == 0)
+    {
       set<pair<int, int> > endo;
       for (int i = 0; i < n; i++)
-        {
+        {
           endo.clear();
-          equations[i]->collectEndogenous(endo);
-          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
-            IM[i * n + endo2eq[it->first]] = true;
-        }
-    }
-  else
+          equations[i]->collectEndogenous(endo);
+          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
+            IM[i * n + endo2eq[it->first]] = true;
+        }
+    }
+  else
     for (jacob_map_t::const_iterator it = static_jacobian_arg.begin(); it != static_jacobian_arg.end(); it++)
       IM[it->first.first * n + endo2eq[it->first.second]] = true;
   bool something_has_been_done = true;
@@ -643,22 +649,22 @@ ModelTree::computeBlockDecompositionAndFeedbackVariablesForEachBlock(const jacob
     {
       reverse_equation_reordered[equation_reordered[i]] = i;
       reverse_variable_reordered[variable_reordered[i]] = i;
-    }
-  jacob_map_t tmp_normalized_contemporaneous_jacobian;
-  if (cutoff == 0)
-    {
+    }
+  jacob_map_t tmp_normalized_contemporaneous_jacobian;
+  if (cutoff == 0)
+    {
       set<pair<int, int> > endo;
       for (int i = 0; i < nb_var; i++)
-        {
+        {
           endo.clear();
-          equations[i]->collectEndogenous(endo);
-          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
-            tmp_normalized_contemporaneous_jacobian[make_pair(i, it->first)] = 1;
-
-        }
-    }
-  else
-    tmp_normalized_contemporaneous_jacobian = static_jacobian;
+          equations[i]->collectEndogenous(endo);
+          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
+            tmp_normalized_contemporaneous_jacobian[make_pair(i, it->first)] = 1;
+
+        }
+    }
+  else
+    tmp_normalized_contemporaneous_jacobian = static_jacobian;
   for (jacob_map_t::const_iterator it = tmp_normalized_contemporaneous_jacobian.begin(); it != tmp_normalized_contemporaneous_jacobian.end(); it++)
     if (reverse_equation_reordered[it->first.first] >= (int) prologue && reverse_equation_reordered[it->first.first] < (int) (nb_var - epilogue)
         && reverse_variable_reordered[it->first.second] >= (int) prologue && reverse_variable_reordered[it->first.second] < (int) (nb_var - epilogue)
@@ -1103,6 +1109,9 @@ ModelTree::ModelTree(SymbolTable &symbol_table_arg,
                      NumericalConstants &num_constants_arg,
                      ExternalFunctionsTable &external_functions_table_arg) :
   DataTree(symbol_table_arg, num_constants_arg, external_functions_table_arg),
+  nb_threads(1),
+  use_derivatives_cache(false),
+  derivatives_order(0),
   cutoff(1e-15),
   mfs(0)
 
@@ -1132,11 +1141,22 @@ ModelTree::writeDerivative(ostream &output, int eq, int symb_id, int lag,
 void
 ModelTree::computeJacobian(const set<int> &vars)
 {
+  vector<bool> restored;
+  restoreCachedDerivatives(vars, 1, restored);
+
+  if (nb_threads > 1)
+    {
+      computeDerivativesParallel(vars, 1, restored);
+      return;
+    }
+
   for (set<int>::const_iterator it = vars.begin();
        it != vars.end(); it++)
     {
       for (int eq = 0; eq < (int) equations.size(); eq++)
         {
+          if (restored[eq])
+            continue;
           expr_t d1 = equations[eq]->getDerivative(*it);
           if (d1 == Zero)
             continue;
@@ -1149,10 +1169,21 @@ ModelTree::computeJacobian(const set<int> &vars)
 void
 ModelTree::computeHessian(const set<int> &vars)
 {
+  vector<bool> restored;
+  restoreCachedDerivatives(vars, 2, restored);
+
+  if (nb_threads > 1)
+    {
+      computeDerivativesParallel(vars, 2, restored);
+      return;
+    }
+
   for (first_derivatives_t::const_iterator it = first_derivatives.begin();
        it != first_derivatives.end(); it++)
     {
       int eq = it->first.first;
+      if (restored[eq])
+        continue;
       int var1 = it->first.second;
       expr_t d1 = it->second;
 
@@ -1179,10 +1210,21 @@ ModelTree::computeHessian(const set<int> &vars)
 void
 ModelTree::computeThirdDerivatives(const set<int> &vars)
 {
+  vector<bool> restored;
+  restoreCachedDerivatives(vars, 3, restored);
+
+  if (nb_threads > 1)
+    {
+      computeDerivativesParallel(vars, 3, restored);
+      return;
+    }
+
   for (second_derivatives_t::const_iterator it = second_derivatives.begin();
        it != second_derivatives.end(); it++)
     {
       int eq = it->first.first;
+      if (restored[eq])
+        continue;
 
       int var1 = it->first.second.first;
       int var2 = it->first.second.second;
@@ -1212,6 +1254,562 @@ ModelTree::computeThirdDerivatives(const set<int> &vars)
     }
 }
 
+//! Data tree in which the derivatives of one equation are computed by ModelTree::computeDerivativesParallel()
+/*! Variables and derivation IDs are those of the model tree */
+class DerivationTree : public DataTree
+{
+private:
+  const DataTree &model;
+public:
+  DerivationTree(const DataTree &model_arg, SymbolTable &symbol_table_arg,
+                 NumericalConstants &num_constants_arg, ExternalFunctionsTable &external_functions_table_arg) :
+    DataTree(symbol_table_arg, num_constants_arg, external_functions_table_arg),
+    model(model_arg)
+  {
+  }
+  virtual VariableNode *
+  AddVariable(int symb_id, int lag = 0)
+  {
+    return AddVariableInternal(symb_id, lag);
+  }
+  virtual int
+  getDerivID(int symb_id, int lag) const throw (UnknownDerivIDException)
+  {
+    return model.getDerivID(symb_id, lag);
+  }
+  virtual SymbolType
+  getTypeByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+  {
+    return model.getTypeByDerivID(deriv_id);
+  }
+  virtual int
+  getLagByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+  {
+    return model.getLagByDerivID(deriv_id);
+  }
+  virtual int
+  getSymbIDByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+  {
+    return model.getSymbIDByDerivID(deriv_id);
+  }
+  virtual int
+  getDynJacobianCol(int deriv_id) const throw (UnknownDerivIDException)
+  {
+    return model.getDynJacobianCol(deriv_id);
+  }
+  virtual bool
+  isDynamic() const
+  {
+    return model.isDynamic();
+  }
+};
+
+//! Derivatives of one equation, computed in their own data tree
+class DerivationTask
+{
+public:
+  //! A derivative, in the order of computation
+  struct derivative_t
+  {
+    //! Index in paths of the lower order derivative which is derived
+    int path;
+    //! Derivation ID
+    int var;
+    expr_t d;
+    //! Number of nodes of the data tree once the derivative is computed
+    int end;
+  };
+  NumericalConstants num_constants;
+  DerivationTree tree;
+  //! The equation and the model local variables it uses, in the model tree
+  expr_t equation;
+  map<int, expr_t> local_variables;
+  //! The derivation IDs leading to the lower order derivatives which must be derived (empty for the Jacobian)
+  vector<vector<int> > paths;
+  vector<derivative_t> derivatives;
+
+  DerivationTask(const DataTree &model, SymbolTable &symbol_table, ExternalFunctionsTable &external_functions_table) :
+    tree(model, symbol_table, num_constants, external_functions_table)
+  {
+  }
+  //! Derives the lower order derivatives w.r. to the variables of vars
+  /*! Only the derivatives with vars ordered as in ModelTree::computeHessian() and ModelTree::computeThirdDerivatives() are computed */
+  void
+  compute(const set<int> &vars)
+  {
+    for (map<int, expr_t>::const_iterator it = local_variables.begin();
+         it != local_variables.end(); it++)
+      tree.AddLocalVariable(it->first, it->second->cloneDynamic(tree));
+    expr_t eq = equation->cloneDynamic(tree);
+
+    vector<expr_t> lower;
+    for (vector<vector<int> >::const_iterator it = paths.begin(); it != paths.end(); it++)
+      {
+        expr_t d = eq;
+        for (vector<int>::const_iterator it2 = it->begin(); it2 != it->end(); it2++)
+          d = d->getDerivative(*it2);
+        lower.push_back(d);
+      }
+
+    for (int i = 0; i < (int) paths.size(); i++)
+      for (set<int>::const_iterator it = vars.begin(); it != vars.end(); it++)
+        {
+          if (!paths[i].empty() && *it > paths[i].back())
+            continue;
+          derivative_t derivative;
+          derivative.path = i;
+          derivative.var = *it;
+          derivative.d = lower[i]->getDerivative(*it);
+          derivative.end = tree.getNodeNumber();
+          derivatives.push_back(derivative);
+        }
+  }
+};
+
+//! Tasks shared by the threads of ModelTree::computeDerivativesParallel()
+struct DerivationQueue
+{
+  vector<DerivationTask *> *tasks;
+  const set<int> *vars;
+  size_t next;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t mutex;
+#endif
+};
+
+//! Computes the tasks of the queue until there is none left
+static void *
+derivation_thread(void *arg)
+{
+  DerivationQueue *queue = static_cast<DerivationQueue *>(arg);
+  while (true)
+    {
+#ifdef HAVE_PTHREAD
+      pthread_mutex_lock(&queue->mutex);
+#endif
+      size_t i = queue->next++;
+#ifdef HAVE_PTHREAD
+      pthread_mutex_unlock(&queue->mutex);
+#endif
+      if (i >= queue->tasks->size())
+        return NULL;
+      if ((*queue->tasks)[i])
+        (*queue->tasks)[i]->compute(*queue->vars);
+    }
+}
+
+void
+ModelTree::computeDerivativesParallel(const set<int> &vars, int order, const vector<bool> &restored)
+{
+  int neq = equations.size();
+  vector<DerivationTask *> tasks(neq, (DerivationTask *) NULL);
+  for (int eq = 0; eq < neq; eq++)
+    {
+      if (restored[eq])
+        continue;
+      tasks[eq] = new DerivationTask(*this, symbol_table, external_functions_table);
+      tasks[eq]->equation = equations[eq];
+      set<int> local_vars;
+      equations[eq]->collectVariables(eModelLocalVariable, local_vars);
+      for (set<int>::const_iterator it = local_vars.begin(); it != local_vars.end(); it++)
+        tasks[eq]->local_variables[*it] = local_variables_table[*it];
+      if (order == 1)
+        tasks[eq]->paths.push_back(vector<int>());
+    }
+  if (order == 2)
+    for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+         it != first_derivatives.end(); it++)
+      {
+        if (tasks[it->first.first])
+          tasks[it->first.first]->paths.push_back(vector<int>(1, it->first.second));
+      }
+  else if (order == 3)
+    for (second_derivatives_t::const_iterator it = second_derivatives.begin();
+         it != second_derivatives.end(); it++)
+      {
+        if (!tasks[it->first.first])
+          continue;
+        vector<int> path;
+        path.push_back(it->first.second.first);
+        path.push_back(it->first.second.second);
+        tasks[it->first.first]->paths.push_back(path);
+      }
+
+  // The calling thread also computes tasks
+  DerivationQueue queue;
+  queue.tasks = &tasks;
+  queue.vars = &vars;
+  queue.next = 0;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&queue.mutex, NULL);
+  vector<pthread_t> threads;
+  for (int i = 1; i < nb_threads; i++)
+    {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, derivation_thread, &queue) == 0)
+        threads.push_back(thread);
+    }
+#endif
+  derivation_thread(&queue);
+#ifdef HAVE_PTHREAD
+  for (vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); it++)
+    pthread_join(*it, NULL);
+  pthread_mutex_destroy(&queue.mutex);
+#endif
+
+  /* Merge the derivatives in the order of the sequential algorithm (by
+     variable then equation for the Jacobian, by equation then variable for
+     higher orders), so that the node numbering stays close to it */
+  vector<pair<int, int> > merge_order;
+  if (order == 1)
+    {
+      for (int i = 0; i < (int) vars.size(); i++)
+        for (int eq = 0; eq < neq; eq++)
+          if (tasks[eq])
+            merge_order.push_back(make_pair(eq, i));
+    }
+  else
+    for (int eq = 0; eq < neq; eq++)
+      if (tasks[eq])
+        for (int i = 0; i < (int) tasks[eq]->derivatives.size(); i++)
+          merge_order.push_back(make_pair(eq, i));
+
+  vector<vector<expr_t> > images(neq);
+  for (vector<pair<int, int> >::const_iterator it = merge_order.begin();
+       it != merge_order.end(); it++)
+    {
+      int eq = it->first;
+      const DerivationTask::derivative_t &derivative = tasks[eq]->derivatives[it->second];
+      mergeNodes(tasks[eq]->tree, images[eq], derivative.end);
+      expr_t d = images[eq][derivative.d->idx];
+      if (d == Zero)
+        continue;
+
+      const vector<int> &path = tasks[eq]->paths[derivative.path];
+      int var = derivative.var;
+      switch (order)
+        {
+        case 1:
+          first_derivatives[make_pair(eq, var)] = d;
+          ++NNZDerivatives[0];
+          break;
+        case 2:
+          second_derivatives[make_pair(eq, make_pair(path[0], var))] = d;
+          if (var == path[0])
+            ++NNZDerivatives[1];
+          else
+            NNZDerivatives[1] += 2;
+          break;
+        case 3:
+          third_derivatives[make_pair(eq, make_pair(path[0], make_pair(path[1], var)))] = d;
+          if (var == path[1] && path[1] == path[0])
+            ++NNZDerivatives[2];
+          else if (var == path[1] || path[1] == path[0])
+            NNZDerivatives[2] += 3;
+          else
+            NNZDerivatives[2] += 6;
+          break;
+        }
+    }
+
+  // Keep the derivatives computed by the threads in the cache of the model tree
+  for (int eq = 0; eq < neq; eq++)
+    {
+      if (!tasks[eq])
+        continue;
+      mergeNodes(tasks[eq]->tree, images[eq], tasks[eq]->tree.getNodeNumber());
+      mergeDerivatives(tasks[eq]->tree, images[eq]);
+      delete tasks[eq];
+    }
+}
+
+string
+ModelTree::getEquationCacheKey(int eq, const set<int> &vars) const
+{
+  ostringstream key;
+  map<const ExprNode *, int> node_ids;
+
+  set<int> local_vars;
+  equations[eq]->collectVariables(eModelLocalVariable, local_vars);
+  for (set<int>::const_iterator it = local_vars.begin(); it != local_vars.end(); it++)
+    {
+      int n = local_variables_table.find(*it)->second->writeCache(key, node_ids);
+      key << "L " << symbol_table.getName(*it) << " " << n << endl;
+    }
+  key << "Q " << equations[eq]->writeCache(key, node_ids) << endl;
+
+  // The order of the derivation IDs determines which cross derivatives are stored
+  equations[eq]->prepareForDerivation();
+  for (set<int>::const_iterator it = vars.begin(); it != vars.end(); it++)
+    if (equations[eq]->non_null_derivatives.find(*it) != equations[eq]->non_null_derivatives.end())
+      key << "D " << symbol_table.getName(getSymbIDByDerivID(*it)) << " " << getLagByDerivID(*it) << endl;
+
+  return key.str();
+}
+
+void
+ModelTree::restoreCachedDerivatives(const set<int> &vars, int order, vector<bool> &restored)
+{
+  int neq = equations.size();
+  derivatives_order = order;
+  restored.assign(neq, false);
+  if (!use_derivatives_cache)
+    return;
+
+  if (order == 1)
+    {
+      equation_cache_keys.clear();
+      for (int eq = 0; eq < neq; eq++)
+        equation_cache_keys.push_back(getEquationCacheKey(eq, vars));
+      restored_derivatives.assign(neq, make_pair(0, vector<expr_t>()));
+    }
+
+  int nrestored = 0;
+  for (int eq = 0; eq < neq; eq++)
+    {
+      map<string, cached_derivatives_t>::const_iterator it = derivatives_cache.find(equation_cache_keys[eq]);
+      // The derivatives of lower orders must have been restored, along with the nodes they use
+      if (it == derivatives_cache.end() || (int) it->second.nodes.size() < order
+          || restored_derivatives[eq].first != order - 1)
+        continue;
+
+      /* The whole cache of the equation is checked before any node is added
+         to the tree, so that an invalid cache leaves no node behind */
+      vector<expr_t> &nodes = restored_derivatives[eq].second;
+      bool valid = true;
+      const vector<string> &records = it->second.nodes[order-1];
+      vector<cache_node_t> parsed(records.size());
+      for (size_t i = 0; valid && i < records.size(); i++)
+        valid = parseCacheNode(records[i], nodes.size() + i, parsed[i]);
+      int nnodes = nodes.size() + records.size();
+
+      vector<pair<vector<int>, int> > derivatives;
+      const vector<pair<int, vector<pair<string, int> > > > &cached = it->second.derivatives[order-1];
+      for (vector<pair<int, vector<pair<string, int> > > >::const_iterator it2 = cached.begin();
+           valid && it2 != cached.end(); it2++)
+        {
+          if (it2->first < 0 || it2->first >= nnodes || (int) it2->second.size() != order)
+            {
+              valid = false;
+              break;
+            }
+          vector<int> ids;
+          for (vector<pair<string, int> >::const_iterator it3 = it2->second.begin();
+               valid && it3 != it2->second.end(); it3++)
+            {
+              if (!symbol_table.exists(it3->first))
+                valid = false;
+              else
+                try
+                  {
+                    int deriv_id = getDerivID(symbol_table.getID(it3->first), it3->second);
+                    if (vars.find(deriv_id) == vars.end())
+                      valid = false;
+                    ids.push_back(deriv_id);
+                  }
+                catch (UnknownDerivIDException &e)
+                  {
+                    valid = false;
+                  }
+            }
+          // Derivatives are stored with var1 >= var2 >= var3
+          sort(ids.rbegin(), ids.rend());
+          derivatives.push_back(make_pair(ids, it2->first));
+        }
+      if (!valid)
+        continue;
+
+      for (vector<cache_node_t>::const_iterator it2 = parsed.begin(); it2 != parsed.end(); it2++)
+        nodes.push_back(addCacheNode(*it2, nodes));
+
+      for (vector<pair<vector<int>, int> >::const_iterator it2 = derivatives.begin();
+           it2 != derivatives.end(); it2++)
+        {
+          const vector<int> &ids = it2->first;
+          expr_t d = nodes[it2->second];
+          switch (order)
+            {
+            case 1:
+              first_derivatives[make_pair(eq, ids[0])] = d;
+              ++NNZDerivatives[0];
+              break;
+            case 2:
+              second_derivatives[make_pair(eq, make_pair(ids[0], ids[1]))] = d;
+              if (ids[1] == ids[0])
+                ++NNZDerivatives[1];
+              else
+                NNZDerivatives[1] += 2;
+              break;
+            case 3:
+              third_derivatives[make_pair(eq, make_pair(ids[0], make_pair(ids[1], ids[2])))] = d;
+              if (ids[2] == ids[1] && ids[1] == ids[0])
+                ++NNZDerivatives[2];
+              else if (ids[2] == ids[1] || ids[1] == ids[0])
+                NNZDerivatives[2] += 3;
+              else
+                NNZDerivatives[2] += 6;
+              break;
+            }
+        }
+      restored_derivatives[eq].first = order;
+      restored[eq] = true;
+      nrestored++;
+    }
+
+  if (nrestored > 0)
+    cout << "   (" << nrestored << " of " << neq << " equations unchanged since the previous run)" << endl;
+}
+
+//! Reads a line of the form "<word> <count>" in the derivatives cache
+static bool
+readCacheCount(istream &input, const string &word, int &count)
+{
+  string line, w;
+  if (!getline(input, line))
+    return false;
+  istringstream iss(line);
+  iss >> w >> count;
+  return !iss.fail() && w == word && count >= 0;
+}
+
+void
+ModelTree::loadDerivativesCache(const string &filename)
+{
+  use_derivatives_cache = true;
+  derivatives_cache.clear();
+
+  ifstream input(filename.c_str(), ios::in | ios::binary);
+  if (!input.is_open())
+    return;
+
+  // The format of the nodes may change between versions
+  string line;
+  if (!getline(input, line) || line != string("dynare_derivatives_cache ") + PACKAGE_VERSION)
+    return;
+
+  int nlines;
+  bool valid = true;
+  while (valid && readCacheCount(input, "equation", nlines))
+    {
+      string key;
+      for (int i = 0; valid && i < nlines; i++)
+        {
+          valid = !getline(input, line).fail();
+          key += line + "\n";
+        }
+
+      cached_derivatives_t cache;
+      int order;
+      valid = valid && readCacheCount(input, "order", order);
+      for (int o = 0; valid && o < order; o++)
+        {
+          int n;
+          cache.nodes.push_back(vector<string>());
+          valid = readCacheCount(input, "nodes", n);
+          for (int i = 0; valid && i < n; i++)
+            {
+              valid = !getline(input, line).fail();
+              cache.nodes.back().push_back(line);
+            }
+
+          cache.derivatives.push_back(vector<pair<int, vector<pair<string, int> > > >());
+          valid = valid && readCacheCount(input, "derivatives", n);
+          for (int i = 0; valid && i < n; i++)
+            {
+              valid = !getline(input, line).fail();
+              istringstream iss(line);
+              pair<int, vector<pair<string, int> > > derivative;
+              iss >> derivative.first;
+              for (int j = 0; j <= o; j++)
+                {
+                  pair<string, int> var;
+                  iss >> var.first >> var.second;
+                  derivative.second.push_back(var);
+                }
+              valid = valid && !iss.fail();
+              cache.derivatives.back().push_back(derivative);
+            }
+        }
+      if (valid)
+        derivatives_cache[key] = cache;
+    }
+
+  if (!valid || !input.eof())
+    {
+      cerr << "WARNING: ignoring the invalid derivatives cache " << filename << endl;
+      derivatives_cache.clear();
+    }
+}
+
+void
+ModelTree::saveDerivativesCache(const string &filename) const
+{
+  // Nothing to save if the derivatives were not computed
+  if (!use_derivatives_cache || derivatives_order == 0)
+    return;
+
+  ofstream output(filename.c_str(), ios::out | ios::binary);
+  if (!output.is_open())
+    {
+      cerr << "ERROR: Can't open file " << filename << " for writing" << endl;
+      exit(EXIT_FAILURE);
+    }
+
+  // Group the derivatives by equation and order
+  int neq = equations.size();
+  vector<vector<vector<pair<vector<int>, expr_t> > > > derivatives(neq, vector<vector<pair<vector<int>, expr_t> > >(derivatives_order));
+  for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+       it != first_derivatives.end(); it++)
+    derivatives[it->first.first][0].push_back(make_pair(vector<int>(1, it->first.second), it->second));
+  for (second_derivatives_t::const_iterator it = second_derivatives.begin();
+       it != second_derivatives.end(); it++)
+    {
+      vector<int> ids;
+      ids.push_back(it->first.second.first);
+      ids.push_back(it->first.second.second);
+      derivatives[it->first.first][1].push_back(make_pair(ids, it->second));
+    }
+  for (third_derivatives_t::const_iterator it = third_derivatives.begin();
+       it != third_derivatives.end(); it++)
+    {
+      vector<int> ids;
+      ids.push_back(it->first.second.first);
+      ids.push_back(it->first.second.second.first);
+      ids.push_back(it->first.second.second.second);
+      derivatives[it->first.first][2].push_back(make_pair(ids, it->second));
+    }
+
+  output << "dynare_derivatives_cache " << PACKAGE_VERSION << endl;
+  for (int eq = 0; eq < neq; eq++)
+    {
+      const string &key = equation_cache_keys[eq];
+      output << "equation " << count(key.begin(), key.end(), '\n') << endl
+             << key
+             << "order " << derivatives_order << endl;
+
+      // The nodes are written in the order in which they are needed, so that the lower orders can be restored alone
+      map<const ExprNode *, int> node_ids;
+      for (int order = 0; order < derivatives_order; order++)
+        {
+          ostringstream nodes, entries;
+          int first_node = node_ids.size();
+          for (vector<pair<vector<int>, expr_t> >::const_iterator it = derivatives[eq][order].begin();
+               it != derivatives[eq][order].end(); it++)
+            {
+              entries << it->second->writeCache(nodes, node_ids);
+              for (vector<int>::const_iterator it2 = it->first.begin(); it2 != it->first.end(); it2++)
+                entries << " " << symbol_table.getName(getSymbIDByDerivID(*it2)) << " " << getLagByDerivID(*it2);
+              entries << endl;
+            }
+          output << "nodes " << node_ids.size() - first_node << endl
+                 << nodes.str()
+                 << "derivatives " << derivatives[eq][order].size() << endl
+                 << entries.str();
+        }
+    }
+  output.close();
+}
+
 void
 ModelTree::computeTemporaryTerms(bool is_matlab)
 {
@@ -1751,6 +2349,12 @@ ModelTree::set_cutoff_to_zero()
   cutoff = 0;
 }
 
+void
+ModelTree::set_nb_threads(int nb_threads_arg)
+{
+  nb_threads = nb_threads_arg;
+}
+
 void
 ModelTree::jacobianHelper(ostream &output, int eq_nb, int col_nb, ExprNodeOutputType output_type) const
 {
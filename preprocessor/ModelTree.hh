@@ -67,6 +67,28 @@ protected:
   //! Number of non-zero derivatives
   int NNZDerivatives[3];
 
+  //! Number of threads used for computing the derivatives
+  int nb_threads;
+
+  //! Derivatives of an equation, as stored in the derivatives cache (see saveDerivativesCache())
+  struct cached_derivatives_t
+  {
+    //! For each order, the nodes used by the derivatives of that order and not by those of lower orders (see ExprNode::writeCache())
+    vector<vector<string> > nodes;
+    //! For each order, the non-null derivatives: node number, and variables designated by their name and lag
+    vector<vector<pair<int, vector<pair<string, int> > > > > derivatives;
+  };
+  //! Whether the derivatives cache is used (see loadDerivativesCache())
+  bool use_derivatives_cache;
+  //! Derivatives read from the cache, indexed by the key of their equation (see getEquationCacheKey())
+  map<string, cached_derivatives_t> derivatives_cache;
+  //! Key of each equation in the derivatives cache
+  vector<string> equation_cache_keys;
+  //! For each equation, the highest order of the derivatives restored from the cache, and the nodes restored so far
+  vector<pair<int, vector<expr_t> > > restored_derivatives;
+  //! Highest order of the derivatives computed
+  int derivatives_order;
+
   typedef map<pair<int, int>, expr_t> first_derivatives_t;
   //! First order derivatives
   /*! First index is equation number, second is variable w.r. to which is computed the derivative.
@@ -176,6 +198,27 @@ protected:
   //! Computes 3rd derivatives
   /*! \param vars the derivation IDs w.r. to which derive the 2nd derivatives */
   void computeThirdDerivatives(const set<int> &vars);
+  //! Computes 1st, 2nd or 3rd derivatives in nb_threads threads, on behalf of the three methods above
+  /*! The derivatives of each equation are computed in a separate DataTree,
+    whose nodes are then merged into the model tree in a fixed order. The
+    output hence does not depend on the number of threads. It is equivalent to
+    the output of the sequential algorithm, but the arguments of commutative
+    operators and the temporary terms may come in a different order.
+    \param vars the derivation IDs w.r. to which compute the derivatives
+    \param order the order of the derivatives to compute (the lower order derivatives must already be computed)
+    \param restored the equations whose derivatives were restored from the cache, and must not be computed */
+  void computeDerivativesParallel(const set<int> &vars, int order, const vector<bool> &restored);
+  //! Returns the key of an equation in the derivatives cache
+  /*! It contains the equation, the definitions of the model local variables
+    it uses, and the variables w.r. to which it is derived in the order of
+    their derivation IDs. Symbols are designated by their name */
+  string getEquationCacheKey(int eq, const set<int> &vars) const;
+  //! Restores from the derivatives cache the derivatives of the given order of the equations which did not change
+  /*! Called before computing the derivatives of each order.
+    \param vars the derivation IDs w.r. to which compute the derivatives
+    \param order the order of the derivatives to restore
+    \param restored set to true for the equations whose derivatives were restored */
+  void restoreCachedDerivatives(const set<int> &vars, int order, vector<bool> &restored);
   //! Computes derivatives of the Jacobian and Hessian w.r. to parameters
   void computeParamsDerivatives(int paramsDerivsOrder);
   //! Write derivative of an equation w.r. to a variable
@@ -340,6 +383,13 @@ public:
   //! Is a given variable non-stationary?
   bool isNonstationary(int symb_id) const;
   void set_cutoff_to_zero();
+  //! Sets the number of threads used for computing the derivatives
+  void set_nb_threads(int nb_threads_arg);
+  //! Enables the derivatives cache, and reads the derivatives saved in the given file by a previous run, if any
+  /*! The derivatives of the equations which did not change since that run are not computed again */
+  void loadDerivativesCache(const string &filename);
+  //! Saves the derivatives of the equations, for the next run (see loadDerivativesCache())
+  void saveDerivativesCache(const string &filename) const;
   //! Helper for writing the Jacobian elements in MATLAB and C
   /*! Writes either (i+1,j+1) or [i+j*no_eq] */
   void jacobianHelper(ostream &output, int eq_nb, int col_nb, ExprNodeOutputType output_type) const;
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NODE_HASH_MAP_HH
+#define _NODE_HASH_MAP_HH
+
+using namespace std;
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! Mixes the bits of an integer, so that close values are spread over the table
+inline size_t
+hash_key(size_t v)
+{
+  v ^= v >> 16;
+  v *= 0x45d9f3b;
+  v ^= v >> 16;
+  v *= 0x45d9f3b;
+  v ^= v >> 16;
+  return v;
+}
+
+inline size_t
+hash_key(int v)
+{
+  return hash_key((size_t) v);
+}
+
+//! Nodes are shared (hash-consed), hence their address identifies their structure
+template<class T>
+inline size_t
+hash_key(T *p)
+{
+  return hash_key(reinterpret_cast<size_t>(p));
+}
+
+inline size_t
+hash_combine(size_t seed, size_t h)
+{
+  return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+template<class A, class B>
+inline size_t
+hash_key(const pair<A, B> &p)
+{
+  return hash_combine(hash_key(p.first), hash_key(p.second));
+}
+
+template<class A>
+inline size_t
+hash_key(const vector<A> &v)
+{
+  size_t h = v.size();
+  for (typename vector<A>::const_iterator it = v.begin(); it != v.end(); it++)
+    h = hash_combine(h, hash_key(*it));
+  return h;
+}
+
+//! Hash table with open addressing (linear probing), used to share the nodes of a DataTree
+/*! It provides the subset of the std::map interface used on the node tables
+  (find(), operator[], and iteration in an unspecified order). Entries are
+  never removed. Inserting a new key may move the other entries and
+  invalidates the iterators. */
+template<class Key, class T>
+class NodeHashMap
+{
+public:
+  typedef pair<Key, T> value_type;
+
+  class iterator;
+  class const_iterator
+  {
+    friend class NodeHashMap;
+  public:
+    const_iterator() : map(NULL), slot(0)
+    {
+    }
+    const_iterator(const iterator &it) : map(it.map), slot(it.slot)
+    {
+    }
+    const value_type &
+    operator*() const
+    {
+      return map->slots[slot].value;
+    }
+    const value_type *
+    operator->() const
+    {
+      return &map->slots[slot].value;
+    }
+    const_iterator &
+    operator++()
+    {
+      slot = map->next_used(slot+1);
+      return *this;
+    }
+    const_iterator
+    operator++(int)
+    {
+      const_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool
+    operator==(const const_iterator &other) const
+    {
+      return slot == other.slot;
+    }
+    bool
+    operator!=(const const_iterator &other) const
+    {
+      return slot != other.slot;
+    }
+  private:
+    const NodeHashMap *map;
+    size_t slot;
+    const_iterator(const NodeHashMap *map_arg, size_t slot_arg) : map(map_arg), slot(slot_arg)
+    {
+    }
+  };
+
+  class iterator
+  {
+    friend class NodeHashMap;
+    friend class const_iterator;
+  public:
+    iterator() : map(NULL), slot(0)
+    {
+    }
+    value_type &
+    operator*() const
+    {
+      return map->slots[slot].value;
+    }
+    value_type *
+    operator->() const
+    {
+      return &map->slots[slot].value;
+    }
+    iterator &
+    operator++()
+    {
+      slot = map->next_used(slot+1);
+      return *this;
+    }
+    iterator
+    operator++(int)
+    {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool
+    operator==(const iterator &other) const
+    {
+      return slot == other.slot;
+    }
+    bool
+    operator!=(const iterator &other) const
+    {
+      return slot != other.slot;
+    }
+  private:
+    NodeHashMap *map;
+    size_t slot;
+    iterator(NodeHashMap *map_arg, size_t slot_arg) : map(map_arg), slot(slot_arg)
+    {
+    }
+  };
+
+  NodeHashMap() : nb_entries(0)
+  {
+  }
+
+  size_t
+  size() const
+  {
+    return nb_entries;
+  }
+
+  bool
+  empty() const
+  {
+    return nb_entries == 0;
+  }
+
+  iterator
+  begin()
+  {
+    return iterator(this, next_used(0));
+  }
+  iterator
+  end()
+  {
+    return iterator(this, slots.size());
+  }
+  const_iterator
+  begin() const
+  {
+    return const_iterator(this, next_used(0));
+  }
+  const_iterator
+  end() const
+  {
+    return const_iterator(this, slots.size());
+  }
+
+  iterator
+  find(const Key &key)
+  {
+    return iterator(this, find_slot(key));
+  }
+  const_iterator
+  find(const Key &key) const
+  {
+    return const_iterator(this, find_slot(key));
+  }
+
+  //! Returns the value associated to key, inserting a default value if the key is not present
+  /*! Only the insertion of a new key may rehash the table: the lookup of an
+    existing key keeps the iterators and references valid */
+  T &
+  operator[](const Key &key)
+  {
+    size_t h = hashed(key);
+    size_t slot = probe(key, h);
+    if (slot < slots.size() && slots[slot].hash)
+      return slots[slot].value.second;
+    // Keep the load factor under 1/2, so that probe sequences remain short
+    if (2*(nb_entries+1) > slots.size())
+      {
+        rehash(slots.empty() ? min_capacity : 2*slots.size());
+        slot = probe(key, h);
+      }
+    slots[slot].hash = h;
+    slots[slot].value.first = key;
+    nb_entries++;
+    return slots[slot].value.second;
+  }
+
+private:
+  //! Initial number of slots (must be a power of two)
+  static const size_t min_capacity = 4;
+  struct slot_type
+  {
+    //! Hash of the key, 0 for an empty slot
+    size_t hash;
+    value_type value;
+    slot_type() : hash(0), value(Key(), T())
+    {
+    }
+  };
+  vector<slot_type> slots;
+  size_t nb_entries;
+
+  //! Hash of a key, never equal to 0 (which marks the empty slots)
+  static size_t
+  hashed(const Key &key)
+  {
+    size_t h = hash_key(key);
+    return h ? h : 1;
+  }
+
+  /*! Returns the slot containing key (of hash h), or the empty slot where it
+    would be inserted if it is absent, or slots.size() if the table is empty */
+  size_t
+  probe(const Key &key, size_t h) const
+  {
+    if (slots.empty())
+      return 0;
+    size_t mask = slots.size()-1;
+    size_t slot = h & mask;
+    while (slots[slot].hash)
+      {
+        if (slots[slot].hash == h && slots[slot].value.first == key)
+          return slot;
+        slot = (slot+1) & mask;
+      }
+    return slot;
+  }
+
+  //! Returns the slot containing key, or slots.size() if it is absent
+  size_t
+  find_slot(const Key &key) const
+  {
+    if (!nb_entries)
+      return slots.size();
+    size_t slot = probe(key, hashed(key));
+    return slots[slot].hash ? slot : slots.size();
+  }
+
+  //! Returns the first used slot starting at slot, or slots.size() if none
+  size_t
+  next_used(size_t slot) const
+  {
+    while (slot < slots.size() && !slots[slot].hash)
+      slot++;
+    return slot;
+  }
+
+  void
+  rehash(size_t capacity)
+  {
+    vector<slot_type> old_slots(capacity);
+    old_slots.swap(slots);
+    size_t mask = capacity-1;
+    for (size_t i = 0; i < old_slots.size(); i++)
+      if (old_slots[i].hash)
+        {
+          size_t slot = old_slots[i].hash & mask;
+          while (slots[slot].hash)
+            slot = (slot+1) & mask;
+          slots[slot] = old_slots[i];
+        }
+  }
+};
+
+template<class Key, class T>
+const size_t NodeHashMap<Key, T>::min_capacity;
+
+#endif
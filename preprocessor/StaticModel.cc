@@ -415,6 +415,7 @@ StaticModel::writeModelEquationsCode(const string file_name, const string bin_ba
       cout << "Error : Can't open file \"" << main_name << "\" for writing\n";
       exit(EXIT_FAILURE);
     }
+  write_code_file_header(code_file, 1);
   int count_u;
   int u_count_int = 0;
 
@@ -437,6 +438,7 @@ StaticModel::writeModelEquationsCode(const string file_name, const string bin_ba
                            u_count_int,
                            symbol_table.endo_nbr()
                            );
+  write_code_file_block_offset(code_file, 0);
   fbeginblock.write(code_file, instruction_number);
 
   // Add a mapping form node ID to temporary terms order
@@ -599,6 +601,7 @@ StaticModel::writeModelEquationsCode_Block(const string file_name, const string
       cout << "Error : Can't open file \"" << main_name << "\" for writing\n";
       exit(EXIT_FAILURE);
     }
+  write_code_file_header(code_file, getNbBlocks());
   //Temporary variables declaration
 
   FDIMST_ fdimst(temporary_terms.size());
@@ -640,6 +643,7 @@ StaticModel::writeModelEquationsCode_Block(const string file_name, const string
                                /*symbol_table.endo_nbr()*/ block_size
                                );
 
+      write_code_file_block_offset(code_file, block);
       fbeginblock.write(code_file, instruction_number);
 
       // Get the current code_file position and jump if eval = true
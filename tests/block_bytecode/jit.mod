@@ -0,0 +1,42 @@
+// Tests the "jit" and "legacy_interpreter" arguments of bytecode: the native
+// code of the blocks and the legacy interpreter must give the simulated
+// paths, the residuals and the jacobians of the flat interpreter.
+
+@#include "rbc_common.mod"
+
+options_.dynatol.f=1e-10;
+
+perfect_foresight_setup(periods=200);
+y0 = oo_.endo_simul;
+ys = repmat(oo_.steady_state, 1, options_.periods+2);
+
+[info, y_flat] = bytecode('dynamic', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+[info_jit, y_jit] = bytecode('dynamic', 'jit', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+[info_legacy, y_legacy] = bytecode('dynamic', 'legacy_interpreter', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+if info || info_jit || info_legacy
+   error('jit: the simulation failed');
+end
+if max(max(abs(y_jit - y_flat))) > 1e-10
+   disp(max(max(abs(y_jit - y_flat))));
+   error('jit: the native code and the flat interpreter give different paths');
+end
+if max(max(abs(y_legacy - y_flat))) > 1e-10
+   disp(max(max(abs(y_legacy - y_flat))));
+   error('jit: the legacy and the flat interpreters give different paths');
+end
+
+// The residuals and the jacobians of the blocks, away from the steady state
+[chck, r_flat, g_flat] = bytecode('dynamic', 'evaluate', y0, oo_.exo_simul, M_.params, oo_.steady_state, 1);
+[chck_jit, r_jit, g_jit] = bytecode('dynamic', 'evaluate', 'jit', y0, oo_.exo_simul, M_.params, oo_.steady_state, 1);
+[chck_legacy, r_legacy, g_legacy] = bytecode('dynamic', 'evaluate', 'legacy_interpreter', y0, oo_.exo_simul, M_.params, oo_.steady_state, 1);
+if chck || chck_jit || chck_legacy
+   error('jit: the evaluation of the model failed');
+end
+if max(max(abs(r_jit - r_flat))) > 1e-10 || max(max(abs(r_legacy - r_flat))) > 1e-10
+   error('jit: the residuals differ');
+end
+for b = 1:length(g_flat)
+   if max(max(abs(full(g_jit(b).g1 - g_flat(b).g1)))) > 1e-10 || max(max(abs(full(g_legacy(b).g1 - g_flat(b).g1)))) > 1e-10
+      error(sprintf('jit: the jacobians of block %d differ', b));
+   end
+end
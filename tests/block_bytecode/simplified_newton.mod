@@ -0,0 +1,25 @@
+// Tests the simplified_newton option of bytecode: the paths must be the
+// ones of the full Newton method, on a two boundaries block and on a one
+// boundary block.
+
+@#include "rbc_common.mod"
+
+options_.dynatol.f=1e-10;
+
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=0, no_homotopy);
+endo_simul_newton = oo_.endo_simul;
+
+@#for algo in [0, 4]
+@# for sn in [1, 3]
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=@{algo}, simplified_newton=@{sn}, no_homotopy);
+if ~oo_.deterministic_simulation.status
+   error('simplified_newton=@{sn} failed with stack_solve_algo=@{algo}');
+end
+if max(max(abs(oo_.endo_simul - endo_simul_newton))) > 1e-8
+   disp(max(max(abs(oo_.endo_simul - endo_simul_newton))));
+   error('simplified_newton=@{sn} with stack_solve_algo=@{algo} does not give the path of the Newton method');
+end
+@# endfor
+@#endfor
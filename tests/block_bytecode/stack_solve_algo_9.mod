@@ -0,0 +1,21 @@
+// Tests stack_solve_algo=9 (band LU of the stacked jacobian of two boundaries
+// blocks, one boundary blocks use the sparse LU of stack_solve_algo=8): the
+// paths must be the ones of stack_solve_algo=0.
+
+@#include "rbc_common.mod"
+
+options_.dynatol.f=1e-10;
+
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=0, no_homotopy);
+endo_simul_umfpack = oo_.endo_simul;
+
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=9, no_homotopy);
+if ~oo_.deterministic_simulation.status
+   error('stack_solve_algo=9 failed');
+end
+if max(max(abs(oo_.endo_simul - endo_simul_umfpack))) > 1e-8
+   disp(max(max(abs(oo_.endo_simul - endo_simul_umfpack))));
+   error('stack_solve_algo=9 does not give the path of stack_solve_algo=0');
+end
@@ -0,0 +1,52 @@
+// Tests options_.threads.bytecode: with 4 threads, the residuals and the
+// jacobians of the periods of the two boundaries block are evaluated in
+// parallel (when bytecode is compiled with OpenMP), and the simulated paths
+// must be identical to the ones computed with 1 thread, with the flat
+// interpreter and with the native code.
+
+@#include "rbc_common.mod"
+
+options_.dynatol.f=1e-10;
+
+@#for algo in [0, 9]
+set_dynare_threads('bytecode', 1);
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=@{algo}, no_homotopy);
+endo_simul_1 = oo_.endo_simul;
+
+set_dynare_threads('bytecode', 4);
+perfect_foresight_setup(periods=200);
+perfect_foresight_solver(stack_solve_algo=@{algo}, no_homotopy);
+if ~oo_.deterministic_simulation.status
+   error('threads: the simulation failed with 4 threads and stack_solve_algo=@{algo}');
+end
+if ~isequal(oo_.endo_simul, endo_simul_1)
+   disp(max(max(abs(oo_.endo_simul - endo_simul_1))));
+   error('threads: 1 and 4 threads give different paths with stack_solve_algo=@{algo}');
+end
+@#endfor
+
+perfect_foresight_setup(periods=200);
+y0 = oo_.endo_simul;
+ys = repmat(oo_.steady_state, 1, options_.periods+2);
+@#for arg in ["flat", "jit"]
+set_dynare_threads('bytecode', 1);
+@# if arg == "flat"
+[info_1, y_1] = bytecode('dynamic', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+set_dynare_threads('bytecode', 4);
+[info_4, y_4] = bytecode('dynamic', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+@# else
+[info_1, y_1] = bytecode('dynamic', 'jit', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+set_dynare_threads('bytecode', 4);
+[info_4, y_4] = bytecode('dynamic', 'jit', y0, oo_.exo_simul, M_.params, ys, options_.periods);
+@# endif
+if info_1 || info_4
+   error('threads: the @{arg} simulation failed');
+end
+if ~isequal(y_4, y_1)
+   disp(max(max(abs(y_4 - y_1))));
+   error('threads: 1 and 4 threads give different paths with the @{arg} code');
+end
+@#endfor
+
+set_dynare_threads('bytecode', 1);
@@ -0,0 +1,46 @@
+function compare_model_derivatives(basename1, basename2, tol)
+% compare_model_derivatives(basename1, basename2, tol)
+% Checks that the static and dynamic files generated by the preprocessor for
+% two mod files of the same model give the same residuals and derivatives,
+% up to the relative tolerance tol, at a point away from the steady state.
+%
+% INPUTS
+%   basename1, basename2  [string]  names of the mod files (without extension)
+%   tol                   [double]  relative tolerance
+%
+% OUTPUTS
+%   none, throws an error if the files differ
+
+global M_ oo_
+
+% The files may have been regenerated since they were last called
+clear([basename1 '_static'], [basename1 '_dynamic'], [basename2 '_static'], [basename2 '_dynamic']);
+
+ys = oo_.steady_state.*(1+0.01*(1:M_.endo_nbr)'/M_.endo_nbr);
+x = 0.001*ones(1, M_.exo_nbr);
+
+[r1, g1_1] = feval([basename1 '_static'], ys, x, M_.params);
+[r2, g1_2] = feval([basename2 '_static'], ys, x, M_.params);
+check(r1, r2, 'static residuals', basename1, basename2, tol);
+check(g1_1, g1_2, 'static jacobian', basename1, basename2, tol);
+
+iyv = M_.lead_lag_incidence';
+z = repmat(ys, 1, size(M_.lead_lag_incidence, 1));
+y = z(find(iyv(:)));
+[r1, g1_1, g2_1, g3_1] = feval([basename1 '_dynamic'], y, x, M_.params, ys, 1);
+[r2, g1_2, g2_2, g3_2] = feval([basename2 '_dynamic'], y, x, M_.params, ys, 1);
+check(r1, r2, 'dynamic residuals', basename1, basename2, tol);
+check(g1_1, g1_2, 'dynamic jacobian', basename1, basename2, tol);
+check(g2_1, g2_2, 'dynamic second derivatives', basename1, basename2, tol);
+check(g3_1, g3_2, 'dynamic third derivatives', basename1, basename2, tol);
+end
+
+function check(a, b, what, basename1, basename2, tol)
+if ~isequal(size(a), size(b))
+    error('%s and %s: the %s have different sizes', basename1, basename2, what);
+end
+d = full(max(max(abs(a - b))));
+if d > tol*max(1, full(max(max(abs(a)))))
+    error('%s and %s: the %s differ by %g', basename1, basename2, what, d);
+end
+end
@@ -0,0 +1,78 @@
+// Checks that the model files and decision rules of fs2000k3_cache_model.mod,
+// preprocessed with the fast option, are those of this file, preprocessed
+// without the derivatives cache, when the cache is created, when it is read,
+// and when it is truncated or garbled, in which case the derivatives must be
+// recomputed. Then one equation is edited (fs2000k3_cache_edited.mod is the
+// reference), and restored: the derivatives of the other equations are read
+// from the cache, and merged with the recomputed ones of this equation.
+
+@#include "fs2000k3_common.inc"
+
+M0 = M_;
+oo0 = oo_;
+options0 = options_;
+
+dynare('fs2000k3_cache_edited.mod', 'console', 'noclearall');
+
+cachedir = 'fs2000k3_cache_model';
+cachefiles = {[cachedir filesep 'static_derivatives'], [cachedir filesep 'dynamic_derivatives']};
+for ifile = 1:length(cachefiles)
+   if exist(cachefiles{ifile}, 'file')
+      delete(cachefiles{ifile});
+   end;
+end;
+
+cases = {'no cache', 'cache', 'truncated cache', 'garbled cache', 'edited equation', 'restored equation'};
+for icase = 1:length(cases)
+   // Without the checksum of the previous run, the model files are rewritten
+   if exist([cachedir filesep 'checksum'], 'file')
+      delete([cachedir filesep 'checksum']);
+   end;
+   if icase > 2
+      for ifile = 1:length(cachefiles)
+         if ~exist(cachefiles{ifile}, 'file')
+            error('%s: %s was not written', cases{icase}, cachefiles{ifile});
+         end;
+      end;
+   end;
+   if icase == 3
+      // Stops in the middle of a line, and of the records of an equation
+      txt = fileread(cachefiles{2});
+      fid = fopen(cachefiles{2}, 'w');
+      fwrite(fid, txt(1:floor(end/2)), 'char');
+      fclose(fid);
+   elseif icase == 4
+      // Puts an unknown operator in every binary operator record
+      txt = fileread(cachefiles{1});
+      garbled = strrep(txt, [char(10) 'B '], [char(10) 'B 99 ']);
+      if isequal(garbled, txt)
+         error('%s: no binary operator in %s', cases{icase}, cachefiles{1});
+      end;
+      fid = fopen(cachefiles{1}, 'w');
+      fwrite(fid, garbled, 'char');
+      fclose(fid);
+   end;
+
+   // The temporary terms of the restored derivatives may be numbered differently
+   if icase == 5
+      dynare('fs2000k3_cache_model.mod', 'console', 'fast', 'noclearall', '-Dedited');
+      compare_model_derivatives('fs2000k3_cache_edited', 'fs2000k3_cache_model', 1e-12);
+   else
+      dynare('fs2000k3_cache_model.mod', 'console', 'fast', 'noclearall');
+      compare_model_derivatives('fs2000k3_cache', 'fs2000k3_cache_model', 1e-12);
+   end;
+
+   if max(max(abs(oo0.dr.g_1 - oo_.dr.g_1))) > 1e-10
+      error('%s: error in g_1', cases{icase});
+   end;
+   if max(max(abs(oo0.dr.g_2 - oo_.dr.g_2))) > 1e-10
+      error('%s: error in g_2', cases{icase});
+   end;
+   if max(max(abs(oo0.dr.g_3 - oo_.dr.g_3))) > 1e-10
+      error('%s: error in g_3', cases{icase});
+   end;
+end;
+
+M_ = M0;
+oo_ = oo0;
+options_ = options0;
@@ -0,0 +1,3 @@
+// Reference of the edited model of fs2000k3_cache.mod, preprocessed without the derivatives cache
+@#define edited = 1
+@#include "fs2000k3_common.inc"
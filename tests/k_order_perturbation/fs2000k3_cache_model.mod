@@ -0,0 +1,2 @@
+// Preprocessed with the fast option, and hence the derivatives cache, by fs2000k3_cache.mod
+@#include "fs2000k3_common.inc"
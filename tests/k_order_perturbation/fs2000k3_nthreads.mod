@@ -0,0 +1,28 @@
+// Checks that the derivatives computed by the preprocessor with nthreads=4
+// (fs2000k3_nthreads_4.mod) give the same model files and decision rules as
+// the sequential ones (this file, preprocessed with the default nthreads=1)
+
+@#include "fs2000k3_common.inc"
+
+M0 = M_;
+oo0 = oo_;
+options0 = options_;
+
+dynare('fs2000k3_nthreads_4.mod', 'console', 'nthreads=4', 'noclearall');
+
+// The threads may change the order of the terms of sums and products
+compare_model_derivatives('fs2000k3_nthreads', 'fs2000k3_nthreads_4', 1e-12);
+
+if max(max(abs(oo0.dr.g_1 - oo_.dr.g_1))) > 1e-10
+   error('error in g_1');
+end;
+if max(max(abs(oo0.dr.g_2 - oo_.dr.g_2))) > 1e-10
+   error('error in g_2');
+end;
+if max(max(abs(oo0.dr.g_3 - oo_.dr.g_3))) > 1e-10
+   error('error in g_3');
+end;
+
+M_ = M0;
+oo_ = oo0;
+options_ = options0;
@@ -0,0 +1,3 @@
+// Preprocessed with nthreads=4 by fs2000k3_nthreads.mod
+
+@#include "fs2000k3_common.inc"